@@ -0,0 +1,61 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "frame_transform.hpp"
+#include <opencv2/imgproc.hpp>
+
+cv::Mat FrameTransformCache::get(const void* source, uint64_t sequence, const cv::Mat& frame, cv::Size size,
+                                 double rotate_angle)
+{
+    if (frame.empty()) {
+        return {};
+    }
+    // 计算期间持有锁，另一个阶段同时请求同一帧时等待并复用结果，而不是重复计算
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!cached.empty() && source == cached_source && sequence == cached_sequence && size == cached_size &&
+        rotate_angle == cached_angle) {
+        ++reused_count;
+        return cached;
+    }
+
+    // 每次都写入新的 Mat，之前返回给读者的结果不受影响
+    // 与原来的 cv::resize(frame, frame, size, cv::INTER_NEAREST) 结果一致：那里 INTER_NEAREST 落在了 fx 参数上，
+    // 实际使用的是默认的双线性插值，模型输入保持不变
+    cv::Mat result;
+    cv::resize(frame, result, size, 0, 0, cv::INTER_LINEAR);
+    if (rotate_angle != 0.0) {
+        const auto rotate_matrix = cv::getRotationMatrix2D(cv::Point(result.cols / 2, result.rows / 2), rotate_angle, 1);
+        cv::Mat rotated;
+        cv::warpAffine(result, rotated, rotate_matrix, result.size(), cv::INTER_NEAREST);
+        result = rotated;
+    }
+
+    cached = result;
+    cached_source = source;
+    cached_sequence = sequence;
+    cached_size = size;
+    cached_angle = rotate_angle;
+    ++computed_count;
+    return result;
+}
+
+uint64_t FrameTransformCache::computed() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return computed_count;
+}
+
+uint64_t FrameTransformCache::reused() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return reused_count;
+}
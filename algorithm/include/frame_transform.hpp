@@ -0,0 +1,33 @@
+// frame_transform.hpp - 每帧只做一次的缩放和旋转，预览和推理共享结果
+#ifndef FRAME_TRANSFORM_HPP
+#define FRAME_TRANSFORM_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <opencv2/core.hpp>
+
+// 预览和推理都需要把同一帧缩放到固定大小再按设置的角度旋转。第一个读到新帧的阶段负责计算，
+// 之后同一来源、同一序号、同样参数的请求直接返回缓存的结果。
+// 返回的帧与其他读者共享像素数据，只能读取；需要在上面画图的调用方先 clone
+class FrameTransformCache {
+public:
+    // source 区分不同的图像来源（例如有线和无线），sequence 为该来源的帧序号，
+    // frame 为来源的原始帧，可以是共享像素的浅拷贝。frame 为空时返回空
+    cv::Mat get(const void* source, uint64_t sequence, const cv::Mat& frame, cv::Size size, double rotate_angle);
+
+    // 实际计算的次数和直接复用的次数
+    uint64_t computed() const;
+    uint64_t reused() const;
+
+private:
+    mutable std::mutex mutex;
+    const void* cached_source = nullptr;
+    uint64_t cached_sequence = 0;
+    cv::Size cached_size;
+    double cached_angle = 0.0;
+    cv::Mat cached;
+    uint64_t computed_count = 0;
+    uint64_t reused_count = 0;
+};
+
+#endif // FRAME_TRANSFORM_HPP
@@ -0,0 +1,93 @@
+// output_resampler.hpp - 把推理输出重采样到固定的发送频率，可选插值或外推预测
+#ifndef OUTPUT_RESAMPLER_HPP
+#define OUTPUT_RESAMPLER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class ResampleMode {
+    OFF,      // 不重采样，有新结果就直接发送
+    LINEAR,   // 在最近两个样本之间插值，输出固定落后一个样本间隔
+    VELOCITY, // 用最近两个样本的速度外推到当前时刻
+    KALMAN    // 每个通道一个匀速模型卡尔曼滤波，预测到当前时刻
+};
+
+struct OutputResamplerOptions {
+    ResampleMode mode = ResampleMode::LINEAR;
+    // 发送线程按这个频率调用 sample()，OFF 模式下不使用
+    double output_rate = 60.0;
+    // 最多外推到最后一个样本之后多久，超过后保持不动，避免推理中断时一直漂移
+    double max_extrapolation_ms = 50.0;
+    // 外推结果最多越过最近两个样本所在区间该区间宽度的多少倍
+    float overshoot_limit = 0.5f;
+    // 卡尔曼过程噪声（加速度谱密度）和测量噪声
+    float kalman_q = 50.0f;
+    float kalman_r = 0.0005f;
+};
+
+// 推理线程 push() 带时间戳的样本，发送线程按固定频率 sample()，两者可以在不同线程。
+// 通道数取第一次 push 的大小，之后通道数不变就不再分配内存
+class OutputResampler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit OutputResampler(const OutputResamplerOptions& options = {});
+
+    // 命令行设置的选项，之后创建的窗口使用。未设置模式时各窗口使用自己的默认模式
+    static void setConfiguredOptions(const OutputResamplerOptions& options);
+    static void setConfiguredMode(ResampleMode mode);
+    static OutputResamplerOptions configuredOptions(ResampleMode fallback_mode);
+    // 解析 off / linear / velocity / kalman
+    static bool parseMode(const std::string& text, ResampleMode& mode);
+    static const char* modeName(ResampleMode mode);
+
+    void setOptions(const OutputResamplerOptions& options);
+    OutputResamplerOptions options() const;
+    // 两次 sample() 之间的间隔，由 output_rate 决定
+    Clock::duration outputInterval() const;
+
+    void push(Clock::time_point time, const std::vector<float>& values);
+    // 计算 time 时刻的输出，写入 out（大小调整为通道数）。还没有任何样本时返回 false
+    bool sample(Clock::time_point time, std::vector<float>& out);
+    void reset();
+
+private:
+    struct KalmanChannel {
+        float x = 0.0f;
+        float v = 0.0f;
+        // 协方差矩阵 [[p00, p01], [p01, p11]]
+        float p00 = 1.0f;
+        float p01 = 0.0f;
+        float p11 = 1.0f;
+    };
+
+    static constexpr std::size_t HISTORY = 2;
+
+    const float* history(std::size_t age) const;
+    void sampleLinear(double t, std::vector<float>& out) const;
+    void sampleVelocity(double t, std::vector<float>& out) const;
+    void sampleKalman(double t, std::vector<float>& out) const;
+    float clampOvershoot(std::size_t channel, float value) const;
+    double seconds(Clock::time_point time) const;
+
+    mutable std::mutex mutex;
+    OutputResamplerOptions opts;
+    std::size_t channel_count = 0;
+    Clock::time_point epoch;
+
+    // 最近的两个样本，history_values 按 [样本][通道] 排列
+    std::array<double, HISTORY> history_times{};
+    std::vector<float> history_values;
+    std::size_t sample_count = 0;
+    // 样本间隔的平滑估计，线性插值用它决定输出落后多少
+    double interval = 0.0;
+
+    std::vector<KalmanChannel> kalman;
+    double kalman_time = 0.0;
+};
+
+#endif // OUTPUT_RESAMPLER_HPP
@@ -0,0 +1,255 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "output_resampler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+namespace {
+
+std::mutex configured_mutex;
+OutputResamplerOptions configured_options;
+std::optional<ResampleMode> configured_mode;
+
+// 样本间隔的平滑系数，推理帧率缓慢变化时跟得上，单帧抖动影响不大
+constexpr double INTERVAL_SMOOTHING = 0.1;
+
+} // namespace
+
+OutputResampler::OutputResampler(const OutputResamplerOptions& options)
+    : opts(options), epoch(Clock::now())
+{
+}
+
+void OutputResampler::setConfiguredOptions(const OutputResamplerOptions& options)
+{
+    std::lock_guard<std::mutex> lock(configured_mutex);
+    configured_options = options;
+}
+
+void OutputResampler::setConfiguredMode(ResampleMode mode)
+{
+    std::lock_guard<std::mutex> lock(configured_mutex);
+    configured_mode = mode;
+}
+
+OutputResamplerOptions OutputResampler::configuredOptions(ResampleMode fallback_mode)
+{
+    std::lock_guard<std::mutex> lock(configured_mutex);
+    OutputResamplerOptions options = configured_options;
+    options.mode = configured_mode.value_or(fallback_mode);
+    return options;
+}
+
+bool OutputResampler::parseMode(const std::string& text, ResampleMode& mode)
+{
+    for (ResampleMode candidate : {ResampleMode::OFF, ResampleMode::LINEAR, ResampleMode::VELOCITY, ResampleMode::KALMAN}) {
+        if (text == modeName(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* OutputResampler::modeName(ResampleMode mode)
+{
+    switch (mode) {
+    case ResampleMode::OFF:
+        return "off";
+    case ResampleMode::LINEAR:
+        return "linear";
+    case ResampleMode::VELOCITY:
+        return "velocity";
+    case ResampleMode::KALMAN:
+        return "kalman";
+    }
+    return "off";
+}
+
+void OutputResampler::setOptions(const OutputResamplerOptions& options)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const bool mode_changed = options.mode != opts.mode;
+    opts = options;
+    if (mode_changed) {
+        sample_count = 0;
+        interval = 0.0;
+    }
+}
+
+OutputResamplerOptions OutputResampler::options() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return opts;
+}
+
+OutputResampler::Clock::duration OutputResampler::outputInterval() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const double rate = std::max(1.0, opts.output_rate);
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+}
+
+void OutputResampler::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    sample_count = 0;
+    interval = 0.0;
+}
+
+double OutputResampler::seconds(Clock::time_point time) const
+{
+    return std::chrono::duration<double>(time - epoch).count();
+}
+
+const float* OutputResampler::history(std::size_t age) const
+{
+    return history_values.data() + ((sample_count - 1 - age) % HISTORY) * channel_count;
+}
+
+void OutputResampler::push(Clock::time_point time, const std::vector<float>& values)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (values.size() != channel_count) {
+        // 参数数量变化（例如换了模型）时旧的历史没有意义，重新开始
+        channel_count = values.size();
+        history_values.assign(HISTORY * channel_count, 0.0f);
+        kalman.assign(channel_count, {});
+        sample_count = 0;
+        interval = 0.0;
+    }
+
+    double t = seconds(time);
+    if (sample_count > 0) {
+        const double newest = history_times[(sample_count - 1) % HISTORY];
+        // 时间戳不递增时视为紧跟在上一个样本之后，避免除以零
+        t = std::max(t, newest + 1e-6);
+        const double dt = t - newest;
+        interval = interval == 0.0 ? dt : interval + INTERVAL_SMOOTHING * (dt - interval);
+    }
+
+    const std::size_t slot = sample_count % HISTORY;
+    history_times[slot] = t;
+    std::copy(values.begin(), values.end(), history_values.begin() + slot * channel_count);
+
+    if (opts.mode == ResampleMode::KALMAN) {
+        const float r = opts.kalman_r;
+        if (sample_count == 0) {
+            for (std::size_t i = 0; i < channel_count; ++i) {
+                kalman[i] = {values[i], 0.0f, r, 0.0f, 1.0f};
+            }
+        } else {
+            const float dt = static_cast<float>(t - kalman_time);
+            const float q = opts.kalman_q;
+            const float q00 = q * dt * dt * dt / 3.0f;
+            const float q01 = q * dt * dt / 2.0f;
+            const float q11 = q * dt;
+            for (std::size_t i = 0; i < channel_count; ++i) {
+                KalmanChannel& k = kalman[i];
+                // 预测：x += v·dt，P = F·P·Fᵀ + Q
+                k.x += k.v * dt;
+                k.p00 += dt * (2.0f * k.p01 + dt * k.p11) + q00;
+                k.p01 += dt * k.p11 + q01;
+                k.p11 += q11;
+                // 更新：只观测位置
+                const float innovation = values[i] - k.x;
+                const float s = k.p00 + r;
+                const float k0 = k.p00 / s;
+                const float k1 = k.p01 / s;
+                k.x += k0 * innovation;
+                k.v += k1 * innovation;
+                k.p11 -= k1 * k.p01;
+                k.p00 -= k0 * k.p00;
+                k.p01 -= k0 * k.p01;
+            }
+        }
+        kalman_time = t;
+    }
+    ++sample_count;
+}
+
+bool OutputResampler::sample(Clock::time_point time, std::vector<float>& out)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sample_count == 0) {
+        return false;
+    }
+    out.resize(channel_count);
+
+    const double t = seconds(time);
+    if (opts.mode == ResampleMode::OFF || sample_count < HISTORY) {
+        const float* newest = history(0);
+        std::copy(newest, newest + channel_count, out.begin());
+        return true;
+    }
+
+    switch (opts.mode) {
+    case ResampleMode::LINEAR:
+        sampleLinear(t, out);
+        break;
+    case ResampleMode::VELOCITY:
+        sampleVelocity(t, out);
+        break;
+    case ResampleMode::KALMAN:
+        sampleKalman(t, out);
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+void OutputResampler::sampleLinear(double t, std::vector<float>& out) const
+{
+    // 输出时刻往回推一个样本间隔，这样总是落在最近两个样本之间，新样本到达时输出也是连续的
+    const double t0 = history_times[(sample_count - 2) % HISTORY];
+    const double t1 = history_times[(sample_count - 1) % HISTORY];
+    const double render_time = std::clamp(t - interval, t0, t1);
+    const float alpha = static_cast<float>((render_time - t0) / (t1 - t0));
+    const float* previous = history(1);
+    const float* newest = history(0);
+    for (std::size_t i = 0; i < channel_count; ++i) {
+        out[i] = previous[i] + alpha * (newest[i] - previous[i]);
+    }
+}
+
+void OutputResampler::sampleVelocity(double t, std::vector<float>& out) const
+{
+    const double t0 = history_times[(sample_count - 2) % HISTORY];
+    const double t1 = history_times[(sample_count - 1) % HISTORY];
+    const double horizon = std::clamp(t - t1, 0.0, opts.max_extrapolation_ms / 1000.0);
+    const float scale = static_cast<float>(horizon / (t1 - t0));
+    const float* previous = history(1);
+    const float* newest = history(0);
+    for (std::size_t i = 0; i < channel_count; ++i) {
+        out[i] = clampOvershoot(i, newest[i] + scale * (newest[i] - previous[i]));
+    }
+}
+
+void OutputResampler::sampleKalman(double t, std::vector<float>& out) const
+{
+    const float horizon = static_cast<float>(std::clamp(t - kalman_time, 0.0, opts.max_extrapolation_ms / 1000.0));
+    for (std::size_t i = 0; i < channel_count; ++i) {
+        out[i] = clampOvershoot(i, kalman[i].x + kalman[i].v * horizon);
+    }
+}
+
+float OutputResampler::clampOvershoot(std::size_t channel, float value) const
+{
+    // 外推值不超出最近两个样本的范围太多，眨眼、扫视结束时不会明显冲过头
+    const float previous = history(1)[channel];
+    const float newest = history(0)[channel];
+    const float margin = opts.overshoot_limit * std::abs(newest - previous);
+    return std::clamp(value, std::min(previous, newest) - margin, std::max(previous, newest) + margin);
+}
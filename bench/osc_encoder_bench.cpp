@@ -0,0 +1,171 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// OSC 编码基准：统计 OscManager 在预热之后每帧的堆分配次数和耗时，任何一种发送方式每帧有分配时返回 1
+//   osc_encoder_bench [帧数，默认 20000] [端口，默认 39539]
+// 数据发往 127.0.0.1，不需要有接收端
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "osc.hpp"
+
+namespace {
+
+std::atomic<uint64_t> allocations = 0;
+
+// 与 OscManager 中的模板一样，开头带 "/"，前缀为 /avatar/parameters
+const std::vector<std::string> FACE_NAMES = {
+    "/cheekPuffLeft", "/cheekPuffRight", "/cheekSuckLeft", "/cheekSuckRight", "/jawOpen", "/jawForward",
+    "/jawLeft", "/jawRight", "/noseSneerLeft", "/noseSneerRight", "/mouthFunnel", "/mouthPucker",
+    "/mouthLeft", "/mouthRight", "/mouthRollUpper", "/mouthRollLower", "/mouthShrugUpper", "/mouthShrugLower",
+    "/mouthClose", "/mouthSmileLeft", "/mouthSmileRight", "/mouthFrownLeft", "/mouthFrownRight",
+    "/mouthDimpleLeft", "/mouthDimpleRight", "/mouthUpperUpLeft", "/mouthUpperUpRight", "/mouthLowerDownLeft",
+    "/mouthLowerDownRight", "/mouthPressLeft", "/mouthPressRight", "/mouthStretchLeft", "/mouthStretchRight",
+    "/tongueOut", "/tongueUp", "/tongueDown", "/tongueLeft", "/tongueRight", "/tongueRoll", "/tongueBendDown",
+    "/tongueCurlUp", "/tongueSquish", "/tongueFlat", "/tongueTwistLeft", "/tongueTwistRight",
+};
+
+struct Result {
+    double us_per_frame;
+    double allocations_per_frame;
+    uint64_t warmup_allocations; // 生成模板和预留缓冲区，只在前几帧发生
+};
+
+// 预热若干帧让模板和缓冲区分配好，之后统计 frames 帧。send(i) 发送第 i 帧
+template<typename Send>
+Result measure(int frames, Send&& send)
+{
+    const uint64_t initial = allocations.load();
+    for (int i = 0; i < 16; ++i) {
+        send(i);
+    }
+    using clock = std::chrono::steady_clock;
+    const uint64_t before = allocations.load();
+    const auto start = clock::now();
+    for (int i = 0; i < frames; ++i) {
+        send(16 + i);
+    }
+    const auto elapsed = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    return {elapsed / frames, static_cast<double>(allocations.load() - before) / frames, before - initial};
+}
+
+void fillFace(std::vector<float>& values, int frame)
+{
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = 0.5f + 0.5f * std::sin(0.05f * static_cast<float>(frame) + static_cast<float>(i));
+    }
+}
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char* argv[])
+{
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int port = argc > 2 ? std::atoi(argv[2]) : 39539;
+
+    struct Case {
+        const char* name;
+        bool use_bundle;
+        float epsilon;
+        bool second_destination;
+        bool eye;
+    };
+    const Case cases[] = {
+        {"逐条发送，关闭死区", false, -1.0f, false, false},
+        {"bundle，关闭死区", true, -1.0f, false, false},
+        {"bundle，默认死区", true, 0.001f, false, false},
+        {"逐条发送，两个接收端", false, -1.0f, true, false},
+        {"眼追 sendEyeFrame", false, -1.0f, false, true},
+    };
+
+    bool allocation_free = true;
+    std::printf("%d 帧，面捕 %zu 个参数\n", frames, FACE_NAMES.size());
+    for (const Case& c : cases) {
+        OscSendOptions options;
+        options.use_bundle = c.use_bundle;
+        options.frame_timetag = c.use_bundle;
+        options.default_epsilon = c.epsilon;
+        OscManager osc;
+        osc.setSendOptions(options);
+        osc.setLocationPrefix("/avatar/parameters");
+        if (!osc.init("127.0.0.1", port)) {
+            std::fprintf(stderr, "OSC 初始化失败\n");
+            return 1;
+        }
+        if (c.second_destination) {
+            OscDestination extra;
+            extra.port = port + 1;
+            extra.prefix = "/ft";
+            extra.parameters = {"/jawOpen", "/mouthClose", "/tongueOut"};
+            osc.addDestination(extra);
+        }
+
+        std::vector<float> values(FACE_NAMES.size());
+        EyeOutputFrame eye;
+        const Result result = c.eye
+            ? measure(frames, [&](int frame) {
+                  eye.lid_left = eye.lid_right = 0.75f + 0.2f * std::sin(0.05f * static_cast<float>(frame));
+                  eye.x_left = eye.x_right = std::sin(0.03f * static_cast<float>(frame));
+                  osc.sendEyeFrame(eye);
+              })
+            : measure(frames, [&](int frame) {
+                  fillFace(values, frame);
+                  osc.sendModelOutput(values, FACE_NAMES);
+              });
+        const OscSendStats stats = osc.getStats();
+        std::printf("%-24s %7.2f us/帧  预热分配 %llu 次  之后 %.3f 次/帧  消息 %llu 条  数据包 %llu 个\n", c.name,
+                    result.us_per_frame, static_cast<unsigned long long>(result.warmup_allocations),
+                    result.allocations_per_frame, static_cast<unsigned long long>(stats.messages_sent),
+                    static_cast<unsigned long long>(stats.packets_sent));
+        allocation_free = allocation_free && result.allocations_per_frame == 0.0;
+    }
+    return allocation_free ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// OutputResampler 基准：模拟相机按 30 FPS（带抖动）采样一条轨迹、推理耗时 8 ms 后 push，
+// 发送线程按 output_rate 调用 sample()，统计各模式相对真实轨迹的误差和额外延迟
+//   output_resampler_bench [轨迹.csv ...]
+// CSV 每行为 "毫秒,通道0,通道1,..."，可以是录下来的推理输出；不指定时使用内置的合成轨迹。
+// 误差是输出与同一时刻真实值的均方根，包含相机和推理本身的延迟；
+// 延迟是让误差最小的时间平移量，即输出整体落后真实轨迹多久
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "output_resampler.hpp"
+
+namespace {
+
+constexpr double CAMERA_RATE = 30.0;
+constexpr double CAMERA_JITTER_S = 0.003;
+constexpr double INFERENCE_DELAY_S = 0.008;
+constexpr double MAX_LAG_S = 0.15;
+
+struct Trace {
+    std::string name;
+    std::size_t channels;
+    double duration; // 秒
+    // 写入 t 秒时的真实值
+    std::function<void(double t, std::vector<float>& out)> at;
+};
+
+std::vector<Trace> syntheticTraces()
+{
+    const double pi = 3.14159265358979;
+    return {
+        {"平滑运动", 4, 20.0,
+         [pi](double t, std::vector<float>& out) {
+             for (std::size_t i = 0; i < out.size(); ++i) {
+                 const double phase = static_cast<double>(i);
+                 out[i] = static_cast<float>(0.5 + 0.3 * std::sin(2 * pi * 0.7 * t + phase) +
+                                             0.1 * std::sin(2 * pi * 2.3 * t + 2 * phase));
+             }
+         }},
+        // 每 3 秒眨一次眼，闭合和睁开各约 80 ms
+        {"眨眼", 2, 20.0,
+         [](double t, std::vector<float>& out) {
+             const double local = std::fmod(t, 3.0) - 1.5;
+             const double closed = std::exp(-local * local / (2 * 0.04 * 0.04));
+             for (float& value : out) {
+                 value = static_cast<float>(0.75 * (1.0 - closed));
+             }
+         }},
+        // 注视点每 0.6 秒扫视一次，30 ms 内到达新位置
+        {"扫视", 2, 20.0,
+         [](double t, std::vector<float>& out) {
+             for (std::size_t i = 0; i < out.size(); ++i) {
+                 const double k = std::floor(t / 0.6);
+                 const double target = std::sin(k * 2.1 + static_cast<double>(i));
+                 const double previous = std::sin((k - 1) * 2.1 + static_cast<double>(i));
+                 const double progress = std::clamp((t - k * 0.6) / 0.03, 0.0, 1.0);
+                 out[i] = static_cast<float>(previous + (target - previous) * progress);
+             }
+         }},
+    };
+}
+
+bool loadTrace(const std::string& path, Trace& trace)
+{
+    std::ifstream file(path);
+    std::vector<double> times;
+    std::vector<std::vector<float>> rows;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line);
+        double time_ms;
+        if (!(fields >> time_ms)) {
+            continue;
+        }
+        std::vector<float> row;
+        for (float value; fields >> value;) {
+            row.push_back(value);
+        }
+        if (row.empty() || (!rows.empty() && (row.size() != rows.front().size() || time_ms / 1000.0 <= times.back()))) {
+            continue;
+        }
+        times.push_back(time_ms / 1000.0);
+        rows.push_back(std::move(row));
+    }
+    if (rows.size() < 2) {
+        return false;
+    }
+    const double start = times.front();
+    for (double& time : times) {
+        time -= start;
+    }
+    trace.name = path;
+    trace.channels = rows.front().size();
+    trace.duration = times.back();
+    // 录制的轨迹在相邻两行之间线性插值
+    trace.at = [times = std::move(times), rows = std::move(rows)](double t, std::vector<float>& out) {
+        const auto next = std::upper_bound(times.begin(), times.end(), t);
+        if (next == times.begin() || next == times.end()) {
+            out = next == times.begin() ? rows.front() : rows.back();
+            return;
+        }
+        const auto index = static_cast<std::size_t>(next - times.begin());
+        const double alpha = (t - times[index - 1]) / (times[index] - times[index - 1]);
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            out[i] = static_cast<float>(rows[index - 1][i] + alpha * (rows[index][i] - rows[index - 1][i]));
+        }
+    };
+    return true;
+}
+
+struct Output {
+    double time;
+    std::vector<float> values;
+};
+
+// 输出相对 t - lag 时刻真实值的均方根误差
+double rmsError(const Trace& trace, const std::vector<Output>& outputs, double lag)
+{
+    std::vector<float> truth(trace.channels);
+    double sum = 0.0;
+    std::size_t count = 0;
+    for (const Output& output : outputs) {
+        if (output.time - lag < 0.0) {
+            continue;
+        }
+        trace.at(output.time - lag, truth);
+        for (std::size_t i = 0; i < trace.channels; ++i) {
+            const double diff = output.values[i] - truth[i];
+            sum += diff * diff;
+        }
+        count += trace.channels;
+    }
+    return count ? std::sqrt(sum / static_cast<double>(count)) : 0.0;
+}
+
+void run(const Trace& trace, ResampleMode mode, const OutputResamplerOptions& base)
+{
+    using Clock = OutputResampler::Clock;
+    OutputResamplerOptions options = base;
+    options.mode = mode;
+    OutputResampler resampler(options);
+    const Clock::time_point epoch = Clock::now();
+    const auto at = [epoch](double t) {
+        return epoch + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(t));
+    };
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> jitter(-CAMERA_JITTER_S, CAMERA_JITTER_S);
+    std::normal_distribution<float> noise(0.0f, 0.005f);
+
+    const double output_step = 1.0 / options.output_rate;
+    double next_capture = 0.0;
+    std::vector<float> captured(trace.channels);
+    std::vector<Output> outputs;
+    std::vector<float> out;
+    double sample_ns = 0.0;
+    for (double t = 0.0; t < trace.duration; t += output_step) {
+        // 把这次发送之前已经推理完成的帧依次 push
+        while (next_capture + INFERENCE_DELAY_S <= t) {
+            trace.at(next_capture, captured);
+            for (float& value : captured) {
+                value += noise(rng);
+            }
+            resampler.push(at(next_capture + INFERENCE_DELAY_S), captured);
+            next_capture += 1.0 / CAMERA_RATE + jitter(rng);
+        }
+        const auto start = Clock::now();
+        const bool ready = resampler.sample(at(t), out);
+        sample_ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        if (ready) {
+            outputs.push_back({t, out});
+        }
+    }
+
+    double best_lag = 0.0;
+    double best_error = rmsError(trace, outputs, 0.0);
+    for (double lag = 0.001; lag <= MAX_LAG_S; lag += 0.001) {
+        const double error = rmsError(trace, outputs, lag);
+        if (error < best_error) {
+            best_error = error;
+            best_lag = lag;
+        }
+    }
+    std::printf("  %-9s 误差 %.4f  延迟 %5.1f ms（平移后误差 %.4f）  sample %4.0f ns\n", OutputResampler::modeName(mode),
+                rmsError(trace, outputs, 0.0), best_lag * 1000.0, best_error,
+                outputs.empty() ? 0.0 : sample_ns / static_cast<double>(outputs.size()));
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<Trace> traces;
+    for (int i = 1; i < argc; ++i) {
+        Trace trace;
+        if (!loadTrace(argv[i], trace)) {
+            std::fprintf(stderr, "无法读取轨迹 %s\n", argv[i]);
+            return 1;
+        }
+        traces.push_back(std::move(trace));
+    }
+    if (traces.empty()) {
+        traces = syntheticTraces();
+    }
+
+    const OutputResamplerOptions options;
+    std::printf("相机 %.0f FPS ±%.0f ms，推理 %.0f ms，输出 %.0f Hz\n", CAMERA_RATE, CAMERA_JITTER_S * 1000.0,
+                INFERENCE_DELAY_S * 1000.0, options.output_rate);
+    for (const Trace& trace : traces) {
+        std::printf("%s（%zu 个通道，%.1f 秒）\n", trace.name.c_str(), trace.channels, trace.duration);
+        for (ResampleMode mode : {ResampleMode::OFF, ResampleMode::LINEAR, ResampleMode::VELOCITY, ResampleMode::KALMAN}) {
+            run(trace, mode, options);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// 串口文本包解析基准：一次性收到大量设备状态包时，正则参照实现与 SerialPacketParser 的耗时
+//   serial_packet_parser_bench [包数，默认 20000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "regex_packet_parser.hpp"
+#include "serial_packet_parser.hpp"
+
+int main(int argc, char* argv[])
+{
+    const int count = argc > 1 ? std::atoi(argv[1]) : 20000;
+    std::string burst;
+    for (int i = 0; i < count; ++i) {
+        burst += "A5128192168001100POWER87VERSION2B5\r\n";
+    }
+
+    using clock = std::chrono::steady_clock;
+    const auto t0 = clock::now();
+    const auto reference = regex_packet_parser::parse(burst);
+    const auto t1 = clock::now();
+
+    std::size_t parsed = 0;
+    SerialPacketHandlers handlers;
+    handlers.on_device_status = [&parsed](const DeviceStatusPacket&) { ++parsed; };
+    SerialPacketParser parser(handlers);
+    parser.feed(burst);
+    const auto t2 = clock::now();
+
+    const auto ms = [](clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    std::printf("%d 个状态包: 正则 %zu 个 %.1f ms，SerialPacketParser %zu 个 %.2f ms\n", count, reference.size(),
+                ms(t1 - t0), parsed, ms(t2 - t1));
+    return reference.size() == parsed ? 0 : 1;
+}
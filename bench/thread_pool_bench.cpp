@@ -0,0 +1,160 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// ThreadPool 基准：与重写前的线程池（legacy_thread_pool.hpp）比较吞吐量和唤醒延迟
+//   thread_pool_bench [线程数，默认 4] [重复次数，默认 3]
+// 外部提交：主线程连续提交大量空任务；提交开销：所有线程被占住时只计提交本身的耗时；
+// 嵌套提交：池内任务再各自提交一批空任务；唤醒延迟：线程全部空闲时提交一个任务，到它开始执行的时间
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include <vector>
+#include "legacy_thread_pool.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int EXTERNAL_TASKS = 200000;
+constexpr int NESTED_OUTER = 200;
+constexpr int NESTED_INNER = 1000;
+constexpr int WAKEUPS = 2000;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void waitFor(const std::atomic<int>& counter, int target)
+{
+    while (counter.load() < target) {
+        std::this_thread::yield();
+    }
+}
+
+template<typename Pool>
+double externalSubmit(std::size_t threads)
+{
+    Pool pool(threads);
+    std::atomic<int> done = 0;
+    const auto start = Clock::now();
+    for (int i = 0; i < EXTERNAL_TASKS; ++i) {
+        pool.submit([&done] { ++done; });
+    }
+    waitFor(done, EXTERNAL_TASKS);
+    return elapsedMs(start);
+}
+
+// 先用阻塞任务占住所有线程，返回每次 submit 的平均耗时（纳秒），不含执行和线程间竞争
+template<typename Pool>
+double submitCost(std::size_t threads)
+{
+    Pool pool(threads);
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    for (std::size_t i = 0; i < threads; ++i) {
+        pool.submit([opened] { opened.wait(); });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::atomic<int> done = 0;
+    const auto start = Clock::now();
+    for (int i = 0; i < EXTERNAL_TASKS; ++i) {
+        pool.submit([&done] { ++done; });
+    }
+    const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    gate.set_value();
+    waitFor(done, EXTERNAL_TASKS);
+    return elapsed / EXTERNAL_TASKS;
+}
+
+template<typename Pool>
+double nestedSubmit(std::size_t threads)
+{
+    Pool pool(threads);
+    std::atomic<int> done = 0;
+    const auto start = Clock::now();
+    for (int i = 0; i < NESTED_OUTER; ++i) {
+        pool.submit([&pool, &done] {
+            for (int j = 0; j < NESTED_INNER; ++j) {
+                pool.submit([&done] { ++done; });
+            }
+        });
+    }
+    waitFor(done, NESTED_OUTER * NESTED_INNER);
+    return elapsedMs(start);
+}
+
+// 返回平均唤醒延迟（微秒）
+template<typename Pool>
+double wakeupLatency(std::size_t threads)
+{
+    Pool pool(threads);
+    double total = 0.0;
+    for (int i = 0; i < WAKEUPS; ++i) {
+        // 留出时间让所有线程重新睡眠
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        std::atomic<int> done = 0;
+        Clock::time_point started;
+        const auto submitted = Clock::now();
+        pool.submit([&done, &started] {
+            started = Clock::now();
+            ++done;
+        });
+        waitFor(done, 1);
+        total += std::chrono::duration<double, std::micro>(started - submitted).count();
+    }
+    return total / WAKEUPS;
+}
+
+template<typename F>
+void report(const char* name, const char* unit, int repeat, F&& measure)
+{
+    std::vector<double> legacy;
+    std::vector<double> current;
+    for (int i = 0; i < repeat; ++i) {
+        legacy.push_back(measure(false));
+        current.push_back(measure(true));
+    }
+    std::sort(legacy.begin(), legacy.end());
+    std::sort(current.begin(), current.end());
+    std::printf("%-16s 旧 %8.1f %s（%.1f-%.1f）  新 %8.1f %s（%.1f-%.1f）\n", name, legacy[legacy.size() / 2], unit,
+                legacy.front(), legacy.back(), current[current.size() / 2], unit, current.front(), current.back());
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const std::size_t threads = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 4;
+    const int repeat = std::max(1, argc > 2 ? std::atoi(argv[2]) : 3);
+    std::printf("%zu 个线程，每项 %d 次取中位数（括号内为最小-最大），CPU 核数 %u\n", threads, repeat,
+                std::thread::hardware_concurrency());
+
+    report("外部提交 20 万", "ms", repeat, [threads](bool current) {
+        return current ? externalSubmit<utils::ThreadPool>(threads) : externalSubmit<legacy::ThreadPool>(threads);
+    });
+    report("提交开销", "ns", repeat, [threads](bool current) {
+        return current ? submitCost<utils::ThreadPool>(threads) : submitCost<legacy::ThreadPool>(threads);
+    });
+    report("嵌套 200x1000", "ms", repeat, [threads](bool current) {
+        return current ? nestedSubmit<utils::ThreadPool>(threads) : nestedSubmit<legacy::ThreadPool>(threads);
+    });
+    report("空闲唤醒", "us", repeat, [threads](bool current) {
+        return current ? wakeupLatency<utils::ThreadPool>(threads) : wakeupLatency<legacy::ThreadPool>(threads);
+    });
+    return 0;
+}
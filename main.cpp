@@ -9,6 +9,13 @@
 #include <updater.hpp>
 #include <QDir>
 #include <QDebug>
+#include <QCommandLineParser>
+#include "config_writer.hpp"
+#include "output_resampler.hpp"
+#include "serial.hpp"
+#include "shared_output.hpp"
+#include "stream_hub.hpp"
+#include "thread_policy.hpp"
 #include "translator_manager.h"
 
 int main(int argc, char *argv[]) {
@@ -35,6 +42,126 @@ int main(int argc, char *argv[]) {
         box.exec();
     }
 
+    // --record-dir <目录>: 录制所有设备的原始数据流，用于离线回放复现问题
+    // --replay <文件>[:fast]: 用录制的 .ptrec 文件代替设备作为图像来源，:fast 表示不按录制间隔等待
+    // --udp-port <端口>: 在该端口接收 UDP 分片图像代替 WebSocket 视频流
+    //               两者都可重复指定，按先回放、后 UDP 的顺序排列，面捕窗口和左眼用第一个，右眼用第二个
+    // --serial-port <端口>: 固定使用该串口作为有线设备，例如配合模拟器使用的 pty
+    // --osc-bundle: 以 OSC bundle 发送每帧参数，需要接收端支持；--osc-mtu 设置单包上限，
+    //               --osc-timetag frame 让同一帧的 bundle 带相同的时间戳
+    // --osc-epsilon <值>: 变化不超过该值的参数不重复发送，负数关闭；--osc-keyframe-ms 为全量发送间隔
+    // --osc-max-rate <次/秒>: 面捕结果的最高发送频率，0 表示不限制
+    // --osc-forward <主机:端口[:前缀]>: 同时把参数发给另一个接收端，可重复指定
+    // --shared-memory: 把追踪结果写入共享内存，同机程序用 paper_tracker_shm.h 读取
+    // --resample-mode <off|linear|velocity|kalman>: 输出重采样方式，默认面捕 off、眼追 linear；
+    //               --resample-rate 为重采样后的发送频率，--resample-max-extrapolation-ms 为最长外推时间
+    QCommandLineParser parser;
+    QCommandLineOption recordDirOption("record-dir", "Record raw device streams into <dir>.", "dir");
+    QCommandLineOption replayOption("replay", "Replay a recorded <file>[:fast] instead of the device stream.", "file");
+    QCommandLineOption udpPortOption("udp-port", "Receive fragmented frames over UDP on <port> instead of WebSocket.", "port");
+    QCommandLineOption serialPortOption("serial-port", "Use <port> as the wired device instead of auto-detection.", "port");
+    QCommandLineOption oscBundleOption("osc-bundle", "Send each frame of OSC parameters as bundles.");
+    QCommandLineOption oscMtuOption("osc-mtu", "Maximum OSC bundle packet size in bytes.", "bytes", "1400");
+    QCommandLineOption oscTimetagOption("osc-timetag", "OSC bundle timetag: immediate or frame.", "mode", "immediate");
+    QCommandLineOption oscEpsilonOption("osc-epsilon", "Skip OSC parameters that changed by at most <value>.", "value", "0.001");
+    QCommandLineOption oscKeyframeOption("osc-keyframe-ms", "Send every OSC parameter at least every <ms>.", "ms", "1000");
+    QCommandLineOption oscMaxRateOption("osc-max-rate", "Send face tracking results at most <hz> times per second, 0 for no limit.", "hz", "66");
+    QCommandLineOption oscForwardOption("osc-forward", "Also send OSC parameters to <host:port[:prefix]>.", "target");
+    QCommandLineOption sharedMemoryOption("shared-memory", "Publish tracking results to shared memory for local consumers.");
+    QCommandLineOption resampleModeOption("resample-mode", "Output resampling: off, linear, velocity or kalman.", "mode");
+    QCommandLineOption resampleRateOption("resample-rate", "Emit resampled output <hz> times per second.", "hz", "60");
+    QCommandLineOption resampleExtrapolationOption("resample-max-extrapolation-ms", "Predict at most <ms> past the newest result.", "ms", "50");
+    parser.addOptions({recordDirOption, replayOption, udpPortOption, serialPortOption, oscBundleOption, oscMtuOption, oscTimetagOption,
+                       oscEpsilonOption, oscKeyframeOption, oscMaxRateOption, oscForwardOption, sharedMemoryOption,
+                       resampleModeOption, resampleRateOption, resampleExtrapolationOption});
+    parser.process(app);
+    OscSendOptions oscOptions;
+    oscOptions.use_bundle = parser.isSet(oscBundleOption);
+    oscOptions.max_packet_size = qMax(64u, parser.value(oscMtuOption).toUInt());
+    oscOptions.frame_timetag = parser.value(oscTimetagOption) == "frame";
+    oscOptions.default_epsilon = parser.value(oscEpsilonOption).toFloat();
+    oscOptions.keyframe_interval_ms = parser.value(oscKeyframeOption).toInt();
+    bool maxRateOk = false;
+    const int maxRate = parser.value(oscMaxRateOption).toInt(&maxRateOk);
+    if (maxRateOk && maxRate >= 0) {
+        oscOptions.max_send_rate = maxRate;
+    } else {
+        LOG_WARN("忽略无效的 OSC 最高发送频率: {}，使用默认值 {}", parser.value(oscMaxRateOption).toStdString(),
+                 oscOptions.max_send_rate);
+    }
+    OscManager::setDefaultSendOptions(oscOptions);
+    for (const QString& target : parser.values(oscForwardOption)) {
+        const QStringList parts = target.split(':');
+        if (parts.size() < 2 || parts[1].toInt() <= 0) {
+            LOG_WARN("忽略无效的 OSC 转发目标: {}", target.toStdString());
+            continue;
+        }
+        OscDestination destination;
+        destination.address = parts[0].toStdString();
+        destination.port = parts[1].toInt();
+        if (parts.size() > 2) {
+            destination.prefix = parts[2].toStdString();
+        }
+        OscManager::addDefaultDestination(destination);
+    }
+    OutputResamplerOptions resampleOptions;
+    resampleOptions.output_rate = qMax(1.0, parser.value(resampleRateOption).toDouble());
+    resampleOptions.max_extrapolation_ms = qMax(0.0, parser.value(resampleExtrapolationOption).toDouble());
+    OutputResampler::setConfiguredOptions(resampleOptions);
+    if (parser.isSet(resampleModeOption)) {
+        ResampleMode mode;
+        if (OutputResampler::parseMode(parser.value(resampleModeOption).toStdString(), mode)) {
+            OutputResampler::setConfiguredMode(mode);
+        } else {
+            LOG_WARN("忽略无效的重采样方式: {}", parser.value(resampleModeOption).toStdString());
+        }
+    }
+    // 线程优先级、CPU 亲和性和内存锁定，必须在任何追踪线程启动之前读取。
+    // 文件不存在或为空时写入默认配置方便用户修改；已有内容时从不写回，解析失败时使用默认策略并保留用户的文件
+    utils::ThreadPolicyConfig threadPolicy;
+    QFile threadPolicyFile("./thread_policy.json");
+    if (!threadPolicyFile.exists() || threadPolicyFile.size() == 0) {
+        ConfigWriter("./thread_policy.json").write_config(threadPolicy);
+    } else if (threadPolicyFile.open(QIODevice::ReadOnly)) {
+        try {
+            threadPolicy = json::parse(threadPolicyFile.readAll().toStdString()).get<utils::ThreadPolicyConfig>();
+        } catch (const std::exception& e) {
+            LOG_ERROR("thread_policy.json 解析失败，本次使用默认线程策略，文件保持不变: {}", e.what());
+        }
+        threadPolicyFile.close();
+    } else {
+        LOG_WARN("无法读取 thread_policy.json，本次使用默认线程策略");
+    }
+    utils::ThreadPolicies::configure(threadPolicy);
+    if (parser.isSet(sharedMemoryOption)) {
+        SharedOutputChannel::instance().open();
+    }
+    if (parser.isSet(serialPortOption)) {
+        SerialPortManager::setPortOverride(parser.value(serialPortOption).toStdString());
+    }
+    if (parser.isSet(recordDirOption)) {
+        const QString recordDir = parser.value(recordDirOption);
+        QDir().mkpath(recordDir);
+        StreamHub::instance().setRecordDirectory(recordDir.toStdString());
+    }
+    for (QString replay : parser.values(replayOption)) {
+        // 只识别结尾的 :fast，Windows 路径里的盘符冒号保持不变
+        const bool fast = replay.endsWith(":fast");
+        if (fast) {
+            replay.chop(5);
+        }
+        StreamHub::instance().addReplaySource(replay.toStdString(), fast);
+    }
+    for (const QString& value : parser.values(udpPortOption)) {
+        bool ok = false;
+        const uint port = value.toUInt(&ok);
+        if (!ok || port == 0 || port > 65535) {
+            LOG_WARN("忽略无效的 UDP 端口: {}", value.toStdString());
+            continue;
+        }
+        StreamHub::instance().addUdpSource(static_cast<quint16>(port));
+    }
+
     TranslatorManager::instance();  // 触发单例初始化
 
     PaperTrackerMainWindow window;
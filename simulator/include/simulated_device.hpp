@@ -0,0 +1,93 @@
+// simulated_device.hpp - 模拟追踪器固件的 WebSocket 视频流，用于无硬件压测
+#ifndef SIMULATED_DEVICE_HPP
+#define SIMULATED_DEVICE_HPP
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QSerialPort>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QWebSocket>
+#include <QWebSocketServer>
+#include "stream_recording.hpp"
+
+struct SimulatedDeviceOptions {
+    quint16 port = 8080;
+    int fps = 60;
+    int width = 240;
+    int height = 240;
+    int jpeg_quality = 80;
+    // 非空时按录制文件中的 JPEG 循环发送，忽略 width/height
+    std::string recording_path;
+    float battery = 100.0f;
+    int brightness = 128;
+    // 0 表示不触发上位机的固件版本检查
+    int hardware_version = 0;
+    int telemetry_interval_ms = 1000;
+    // 非空时同时把帧分片后通过 UDP 发到该地址，用于测试 UdpFrameReceiver
+    QString udp_host;
+    quint16 udp_port = 0;
+    // UDP 分片的随机丢包率（0-100）
+    double udp_loss_percent = 0.0;
+    // 非空时同时按有线模式的帧格式写入该串口（Linux 下可用 socat 创建的 pty 对测试）
+    QString serial_port;
+};
+
+// 在 ws://0.0.0.0:port/ws 上提供与设备固件一致的数据：
+// 二进制消息为 JPEG 帧，文本消息为 battery/brightness/hardware_version 的 JSON
+class SimulatedDevice : public QObject {
+public:
+    explicit SimulatedDevice(SimulatedDeviceOptions options, QObject* parent = nullptr);
+    ~SimulatedDevice() override;
+
+    bool start();
+    void stop();
+
+    quint16 port() const { return options.port; }
+    uint64_t framesSent() const { return frames_sent; }
+    int clientCount() const { return static_cast<int>(clients.size()); }
+
+private:
+    void onNewConnection();
+    void onFrameTimer();
+    void scheduleNextFrame();
+    void sendFrame();
+    void sendTelemetry();
+    void sendUdp(const QByteArray& payload, uint32_t id, uint8_t flags);
+    void sendSerial(const QByteArray& payload, uint8_t type);
+    bool loadFrames();
+    void generateSyntheticFrames();
+
+    // 合成图像预先编码好一轮循环所需的帧，避免模拟器自身的编码开销影响压测
+    static constexpr int SYNTHETIC_FRAME_COUNT = 60;
+
+    SimulatedDeviceOptions options;
+    QWebSocketServer server;
+    QList<QWebSocket*> clients;
+    // 单次定时器按绝对截止时间重新启动，毫秒取整的误差不会累积，60 FPS 不会变成 62.5 FPS
+    QTimer frame_timer;
+    std::chrono::steady_clock::time_point next_frame_time;
+    std::chrono::steady_clock::duration frame_interval{};
+    QTimer telemetry_timer;
+
+    // 来自录制文件的帧通过 QByteArray::fromRawData 直接引用映射内存
+    std::unique_ptr<StreamRecording> recording;
+    std::vector<QByteArray> frames;
+    std::size_t next_frame = 0;
+    uint64_t frames_sent = 0;
+
+    QUdpSocket udp_socket;
+    QHostAddress udp_address;
+    uint32_t udp_frame_id = 0;
+    uint32_t udp_text_id = 0;
+    uint64_t udp_fragments_dropped = 0;
+
+    QSerialPort serial;
+};
+
+#endif // SIMULATED_DEVICE_HPP
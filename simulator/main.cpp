@@ -0,0 +1,94 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// 设备模拟器：在本机启动 N 个模拟设备，端口从 --port 开始依次递增
+//   PaperTrackerSimulator --count 4 --port 8080 --fps 60 --width 240 --height 240
+//   PaperTrackerSimulator --count 2 --recording face.ptrec
+//   PaperTrackerSimulator --udp 127.0.0.1:9000 --udp-loss 2
+//   socat -d -d pty,raw,echo=0 pty,raw,echo=0 后用 --serial /dev/pts/N 模拟有线模式
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTimer>
+#include "simulated_device.hpp"
+#include "logger.hpp"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("PaperTrackerSimulator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulates PaperTracker devices streaming JPEG frames over WebSocket.");
+    parser.addHelpOption();
+    QCommandLineOption countOption("count", "Number of simulated devices.", "n", "1");
+    QCommandLineOption portOption("port", "First listening port; device i listens on port + i.", "port", "8080");
+    QCommandLineOption fpsOption("fps", "Frames per second per device.", "fps", "60");
+    QCommandLineOption widthOption("width", "Synthetic frame width.", "px", "240");
+    QCommandLineOption heightOption("height", "Synthetic frame height.", "px", "240");
+    QCommandLineOption qualityOption("quality", "Synthetic frame JPEG quality.", "q", "80");
+    QCommandLineOption recordingOption("recording", "Loop JPEG frames from a .ptrec recording.", "file");
+    QCommandLineOption batteryOption("battery", "Reported battery percentage.", "percent", "100");
+    QCommandLineOption brightnessOption("brightness", "Reported brightness.", "value", "128");
+    QCommandLineOption versionOption("hardware-version", "Reported firmware version (0 = skip check).", "v", "0");
+    QCommandLineOption udpOption("udp", "Also send fragmented frames over UDP to host:port; device i uses port + i.", "host:port");
+    QCommandLineOption udpLossOption("udp-loss", "Percentage of UDP fragments to drop.", "percent", "0");
+    QCommandLineOption serialOption("serial", "Also write wired-mode frames to this serial port (only the first device).", "port");
+    parser.addOptions({countOption, portOption, fpsOption, widthOption, heightOption, qualityOption,
+                       recordingOption, batteryOption, brightnessOption, versionOption, udpOption, udpLossOption,
+                       serialOption});
+    parser.process(app);
+
+    const int count = std::max(1, parser.value(countOption).toInt());
+    const int basePort = parser.value(portOption).toInt();
+
+    std::vector<std::unique_ptr<SimulatedDevice>> devices;
+    for (int i = 0; i < count; ++i) {
+        SimulatedDeviceOptions options;
+        options.port = static_cast<quint16>(basePort + i);
+        options.fps = parser.value(fpsOption).toInt();
+        options.width = parser.value(widthOption).toInt();
+        options.height = parser.value(heightOption).toInt();
+        options.jpeg_quality = parser.value(qualityOption).toInt();
+        options.recording_path = parser.value(recordingOption).toStdString();
+        options.battery = parser.value(batteryOption).toFloat();
+        options.brightness = parser.value(brightnessOption).toInt();
+        options.hardware_version = parser.value(versionOption).toInt();
+        if (parser.isSet(udpOption)) {
+            const QString target = parser.value(udpOption);
+            options.udp_host = target.section(':', 0, 0);
+            options.udp_port = static_cast<quint16>(target.section(':', 1, 1).toInt() + i);
+            options.udp_loss_percent = parser.value(udpLossOption).toDouble();
+        }
+        if (i == 0 && parser.isSet(serialOption)) {
+            options.serial_port = parser.value(serialOption);
+        }
+
+        auto device = std::make_unique<SimulatedDevice>(options);
+        if (!device->start()) {
+            return 1;
+        }
+        devices.push_back(std::move(device));
+    }
+
+    // 每 5 秒输出一次各设备的发送帧数
+    QTimer statsTimer;
+    QObject::connect(&statsTimer, &QTimer::timeout, [&devices]() {
+        for (const auto& device : devices) {
+            LOG_INFO("端口 {}: {} 个连接, 已发送 {} 帧", device->port(), device->clientCount(), device->framesSent());
+        }
+    });
+    statsTimer.start(5000);
+
+    return QCoreApplication::exec();
+}
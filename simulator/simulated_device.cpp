@@ -0,0 +1,246 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "simulated_device.hpp"
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include "serial_frame_protocol.hpp"
+#include "udp_frame_protocol.hpp"
+#include "logger.hpp"
+
+SimulatedDevice::SimulatedDevice(SimulatedDeviceOptions options, QObject* parent)
+    : QObject(parent),
+      options(std::move(options)),
+      server(QString("PaperTrackerSimulator"), QWebSocketServer::NonSecureMode)
+{
+    frame_timer.setTimerType(Qt::PreciseTimer);
+    frame_timer.setSingleShot(true);
+    connect(&server, &QWebSocketServer::newConnection, this, &SimulatedDevice::onNewConnection);
+    connect(&frame_timer, &QTimer::timeout, this, &SimulatedDevice::onFrameTimer);
+    connect(&telemetry_timer, &QTimer::timeout, this, &SimulatedDevice::sendTelemetry);
+}
+
+SimulatedDevice::~SimulatedDevice()
+{
+    stop();
+}
+
+bool SimulatedDevice::start()
+{
+    if (!loadFrames()) {
+        return false;
+    }
+    if (!server.listen(QHostAddress::Any, options.port)) {
+        LOG_ERROR("模拟设备无法监听端口 {}: {}", options.port, server.errorString().toStdString());
+        return false;
+    }
+    if (!options.udp_host.isEmpty()) {
+        udp_address = QHostAddress(options.udp_host);
+        LOG_INFO("模拟设备同时通过 UDP 发送到 {}:{}，丢包率 {}%", options.udp_host.toStdString(),
+                 options.udp_port, options.udp_loss_percent);
+    }
+    if (!options.serial_port.isEmpty()) {
+        serial.setPortName(options.serial_port);
+        if (!serial.open(QIODevice::ReadWrite)) {
+            LOG_ERROR("模拟设备无法打开串口 {}: {}", options.serial_port.toStdString(), serial.errorString().toStdString());
+            return false;
+        }
+        LOG_INFO("模拟设备同时通过串口 {} 发送", options.serial_port.toStdString());
+    }
+    frame_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / std::max(1, options.fps)));
+    next_frame_time = std::chrono::steady_clock::now();
+    scheduleNextFrame();
+    telemetry_timer.start(options.telemetry_interval_ms);
+    LOG_INFO("模拟设备已启动: ws://127.0.0.1:{}/ws ({} 帧循环, {} FPS)", options.port, frames.size(), options.fps);
+    return true;
+}
+
+void SimulatedDevice::stop()
+{
+    frame_timer.stop();
+    telemetry_timer.stop();
+    if (serial.isOpen()) {
+        serial.close();
+    }
+    for (auto* client : clients) {
+        disconnect(client, nullptr, this, nullptr);
+        client->close();
+        client->deleteLater();
+    }
+    clients.clear();
+    server.close();
+}
+
+void SimulatedDevice::onNewConnection()
+{
+    while (server.hasPendingConnections()) {
+        QWebSocket* client = server.nextPendingConnection();
+        // 固件只在 /ws 上提供视频流
+        if (client->requestUrl().path() != "/ws") {
+            LOG_WARN("拒绝未知路径的连接: {}", client->requestUrl().toString().toStdString());
+            client->close(QWebSocketProtocol::CloseCodeNormal);
+            client->deleteLater();
+            continue;
+        }
+        LOG_INFO("端口 {} 新的上位机连接: {}", options.port, client->peerAddress().toString().toStdString());
+        clients.append(client);
+        connect(client, &QWebSocket::disconnected, this, [this, client]() {
+            clients.removeAll(client);
+            client->deleteLater();
+        });
+        sendTelemetry();
+    }
+}
+
+void SimulatedDevice::onFrameTimer()
+{
+    sendFrame();
+    next_frame_time += frame_interval;
+    // 事件循环被阻塞太久时从当前时间重新开始，不连续补发积压的帧
+    const auto now = std::chrono::steady_clock::now();
+    if (now - next_frame_time > frame_interval) {
+        next_frame_time = now;
+    }
+    scheduleNextFrame();
+}
+
+void SimulatedDevice::scheduleNextFrame()
+{
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(next_frame_time - std::chrono::steady_clock::now());
+    frame_timer.start(std::max(std::chrono::milliseconds(0), remaining));
+}
+
+void SimulatedDevice::sendFrame()
+{
+    const bool use_udp = !udp_address.isNull();
+    const bool use_serial = serial.isOpen();
+    if ((clients.isEmpty() && !use_udp && !use_serial) || frames.empty()) {
+        return;
+    }
+    const QByteArray& frame = frames[next_frame];
+    next_frame = (next_frame + 1) % frames.size();
+    if (use_udp) {
+        sendUdp(frame, udp_frame_id++, udp_frame::FLAG_NONE);
+    }
+    if (use_serial) {
+        sendSerial(frame, serial_frame::FRAME_JPEG);
+    }
+    for (auto* client : clients) {
+        client->sendBinaryMessage(frame);
+    }
+    ++frames_sent;
+}
+
+void SimulatedDevice::sendTelemetry()
+{
+    if (clients.isEmpty() && udp_address.isNull() && !serial.isOpen()) {
+        return;
+    }
+    QJsonObject obj;
+    obj["battery"] = options.battery;
+    obj["brightness"] = options.brightness;
+    obj["hardware_version"] = options.hardware_version;
+    const QString message = QString::fromUtf8(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    for (auto* client : clients) {
+        client->sendTextMessage(message);
+    }
+    if (!udp_address.isNull()) {
+        sendUdp(message.toUtf8(), udp_text_id++, udp_frame::FLAG_TEXT);
+    }
+    if (serial.isOpen()) {
+        sendSerial(message.toUtf8(), serial_frame::FRAME_STATUS_JSON);
+    }
+}
+
+void SimulatedDevice::sendSerial(const QByteArray& payload, uint8_t type)
+{
+    // 上一帧还没写完时丢弃当前帧，与固件在 USB 拥塞时的行为一致
+    if (serial.bytesToWrite() > 0) {
+        return;
+    }
+    const auto packet = serial_frame::encode(static_cast<serial_frame::FrameType>(type),
+                                             reinterpret_cast<const uint8_t*>(payload.constData()),
+                                             static_cast<std::size_t>(payload.size()));
+    serial.write(reinterpret_cast<const char*>(packet.data()), static_cast<qint64>(packet.size()));
+}
+
+void SimulatedDevice::sendUdp(const QByteArray& payload, uint32_t id, uint8_t flags)
+{
+    const auto packets = udp_frame::fragment(reinterpret_cast<const uint8_t*>(payload.constData()),
+                                             static_cast<std::size_t>(payload.size()), id, flags);
+    for (const auto& packet : packets) {
+        // 按设定的丢包率随机丢弃分片，模拟 Wi-Fi 丢包
+        if (options.udp_loss_percent > 0.0 &&
+            QRandomGenerator::global()->generateDouble() * 100.0 < options.udp_loss_percent) {
+            ++udp_fragments_dropped;
+            continue;
+        }
+        udp_socket.writeDatagram(reinterpret_cast<const char*>(packet.data()),
+                                 static_cast<qint64>(packet.size()), udp_address, options.udp_port);
+    }
+}
+
+bool SimulatedDevice::loadFrames()
+{
+    frames.clear();
+    next_frame = 0;
+    if (options.recording_path.empty()) {
+        generateSyntheticFrames();
+        return !frames.empty();
+    }
+
+    recording = std::make_unique<StreamRecording>();
+    if (!recording->open(options.recording_path)) {
+        return false;
+    }
+    for (const auto& record : recording->records()) {
+        if (record.type == RecordType::JPEG_FRAME) {
+            frames.push_back(QByteArray::fromRawData(reinterpret_cast<const char*>(record.data),
+                                                     static_cast<qsizetype>(record.size)));
+        }
+    }
+    if (frames.empty()) {
+        LOG_ERROR("录制文件中没有图像帧: {}", options.recording_path);
+        return false;
+    }
+    return true;
+}
+
+void SimulatedDevice::generateSyntheticFrames()
+{
+    // 灰度背景上移动的暗色圆，大致模拟红外摄像头下的瞳孔/嘴部运动
+    const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, options.jpeg_quality};
+    const int radius = std::max(4, std::min(options.width, options.height) / 8);
+    std::vector<uchar> encoded;
+    for (int i = 0; i < SYNTHETIC_FRAME_COUNT; ++i) {
+        const double phase = 2.0 * CV_PI * i / SYNTHETIC_FRAME_COUNT;
+        cv::Mat image(options.height, options.width, CV_8UC3, cv::Scalar(150, 150, 150));
+        const cv::Point center(
+            static_cast<int>(options.width / 2 + options.width / 4 * std::cos(phase)),
+            static_cast<int>(options.height / 2 + options.height / 4 * std::sin(phase)));
+        cv::circle(image, center, radius, cv::Scalar(30, 30, 30), cv::FILLED);
+        cv::putText(image, std::to_string(options.port), cv::Point(4, 16),
+                    cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255));
+        if (!cv::imencode(".jpg", image, encoded, params)) {
+            LOG_ERROR("合成图像编码失败");
+            frames.clear();
+            return;
+        }
+        frames.emplace_back(reinterpret_cast<const char*>(encoded.data()), static_cast<qsizetype>(encoded.size()));
+    }
+}
@@ -0,0 +1,97 @@
+// regex_packet_parser.hpp - 原来基于正则的串口数据包解析，作为测试和基准的参照实现
+#ifndef REGEX_PACKET_PARSER_HPP
+#define REGEX_PACKET_PARSER_HPP
+
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace regex_packet_parser {
+
+using Events = std::vector<std::string>;
+
+inline std::string trim(const std::string& str)
+{
+    const std::string whitespace = " \t\n\r";
+    const size_t start = str.find_first_not_of(whitespace);
+    if (start == std::string::npos) {
+        return "";
+    }
+    const size_t end = str.find_last_not_of(whitespace);
+    return str.substr(start, end - start + 1);
+}
+
+// 原 SerialPortManager::processReceivedData + parsePacket 的行为，作为参照
+inline Events parse(std::string data)
+{
+    Events events;
+    while (true) {
+        const size_t start = data.find('A');
+        if (start == std::string::npos) {
+            break;
+        }
+        if (start > 0) {
+            data = data.substr(start);
+        }
+        const size_t end = data.find('B', 1);
+        if (end == std::string::npos || end + 1 >= data.length()) {
+            break;
+        }
+        const std::string packet = trim(data.substr(0, end + 2));
+        data = data.substr(end + 2);
+        if (packet.length() < 3 || packet[0] != 'A' || packet[packet.length() - 2] != 'B') {
+            continue;
+        }
+
+        std::smatch match;
+        switch (packet.back()) {
+        case '1':
+            if (std::regex_match(packet, std::regex("^A1(01)B1$"))) {
+                events.push_back("1");
+            }
+            break;
+        case '2':
+            if (std::regex_match(packet, match, std::regex("^A2SSID(.*?)PWD(.*?)B2$"))) {
+                events.push_back("2|" + match[1].str() + "|" + match[2].str());
+            }
+            break;
+        case '3':
+            if (std::regex_match(packet, std::regex("^A303B3$"))) {
+                events.push_back("3");
+            }
+            break;
+        case '4':
+            if (std::regex_match(packet, match, std::regex("^A4SSID(.*?)PWD(.*?)B4$"))) {
+                events.push_back("4|" + match[1].str() + "|" + match[2].str());
+            }
+            break;
+        case '5':
+            if (std::regex_match(packet, match,
+                                 std::regex(R"(^A5(\d{1,3})(\d+)POWER(\d{1,3})VERSION(\d{1,3})B5$)"))) {
+                std::string padded = match[2];
+                while (padded.length() < 12) {
+                    padded = "0" + padded;
+                }
+                const std::string ip = std::to_string(std::stoi(padded.substr(0, 3))) + "." +
+                                       std::to_string(std::stoi(padded.substr(3, 3))) + "." +
+                                       std::to_string(std::stoi(padded.substr(6, 3))) + "." +
+                                       std::to_string(std::stoi(padded.substr(9, 3)));
+                events.push_back("5|" + ip + "|" + std::to_string(std::stoi(match[1])) + "|" +
+                                 std::to_string(std::stoi(match[3])) + "|" + std::to_string(std::stoi(match[4])));
+            }
+            break;
+        case '6':
+            if (std::regex_match(packet, match, std::regex("^A6(\\d{1,3})B6$"))) {
+                events.push_back("6|" + std::to_string(std::stoi(match[1])));
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return events;
+}
+
+} // namespace regex_packet_parser
+
+#endif // REGEX_PACKET_PARSER_HPP
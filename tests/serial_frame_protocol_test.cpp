@@ -0,0 +1,143 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// serial_frame::Decoder 测试：帧与文本混合、分段到达、非法帧头和同步字误匹配后的超时重新同步
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "serial_frame_protocol.hpp"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                         \
+        }                                                                       \
+    } while (0)
+
+using namespace std::chrono_literals;
+
+struct Collector {
+    std::vector<std::string> frames;
+    std::string text;
+    serial_frame::Decoder decoder{
+        [this](serial_frame::FrameType, const uint8_t* payload, std::size_t size) {
+            frames.emplace_back(reinterpret_cast<const char*>(payload), size);
+        },
+        [this](const char* data, std::size_t size) { text.append(data, size); }};
+
+    void feed(const std::vector<uint8_t>& bytes, serial_frame::Decoder::Clock::time_point now)
+    {
+        decoder.feed(bytes.data(), bytes.size(), now);
+    }
+    void feed(const std::string& bytes, serial_frame::Decoder::Clock::time_point now)
+    {
+        decoder.feed(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), now);
+    }
+};
+
+std::vector<uint8_t> encodeText(serial_frame::FrameType type, const std::string& payload)
+{
+    return serial_frame::encode(type, reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+}
+
+void testFramesAndTextByteByByte()
+{
+    Collector c;
+    const auto now = serial_frame::Decoder::Clock::now();
+    std::vector<uint8_t> stream;
+    const std::string before = "A6100B6";
+    const std::string after = "A303B3";
+    stream.insert(stream.end(), before.begin(), before.end());
+    const auto frame = encodeText(serial_frame::FRAME_STATUS_JSON, "{\"battery\":87}");
+    stream.insert(stream.end(), frame.begin(), frame.end());
+    stream.insert(stream.end(), after.begin(), after.end());
+    for (uint8_t byte : stream) {
+        c.feed(std::vector<uint8_t>{byte}, now);
+    }
+    CHECK(c.frames.size() == 1 && c.frames[0] == "{\"battery\":87}");
+    CHECK(c.text == before + after);
+    CHECK(c.decoder.framesDecoded() == 1);
+}
+
+// 类型未知或保留字节非 0 时不等待负载，同步字作为文本交出，后面的文本立即可用
+void testInvalidHeaderRejectedImmediately()
+{
+    const auto now = serial_frame::Decoder::Clock::now();
+    for (const auto& header : {std::vector<uint8_t>{0xA5, 0x5A, 0x07, 0x00, 0x00, 0x10, 0x00, 0x00},
+                               std::vector<uint8_t>{0xA5, 0x5A, 0x01, 0x33, 0x00, 0x10, 0x00, 0x00}}) {
+        Collector c;
+        c.feed(header, now);
+        c.feed(std::string("A101B1"), now);
+        CHECK(c.decoder.invalidHeaders() == 1);
+        CHECK(c.text.size() == header.size() + 6);
+        CHECK(c.text.substr(c.text.size() - 6) == "A101B1");
+    }
+}
+
+// 帧头看起来合法但长度是误匹配出来的：超时后从下一个字节重新查找，被扣住的文本和后面的帧都能拿到
+void testSyncTimeout()
+{
+    Collector c;
+    c.decoder.setSyncTimeout(100ms);
+    const auto start = serial_frame::Decoder::Clock::now();
+    const std::vector<uint8_t> fake = {0xA5, 0x5A, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00}; // 长度 64KB
+    c.feed(fake, start);
+    c.feed(std::string("A101B1"), start + 50ms);
+    CHECK(c.text.empty());
+    CHECK(c.decoder.syncTimeouts() == 0);
+
+    const auto frame = encodeText(serial_frame::FRAME_JPEG, "jpeg");
+    c.feed(frame, start + 150ms);
+    CHECK(c.decoder.syncTimeouts() == 1);
+    CHECK(c.text.size() == fake.size() + 6);
+    CHECK(c.text.substr(c.text.size() - 6) == "A101B1");
+    CHECK(c.frames.size() == 1 && c.frames[0] == "jpeg");
+}
+
+// 正常的大帧分批到达，从帧头起在超时之内收齐就不会被打断
+void testSlowFrameWithinTimeout()
+{
+    Collector c;
+    c.decoder.setSyncTimeout(100ms);
+    const std::string payload(20000, 'x');
+    const auto frame = encodeText(serial_frame::FRAME_JPEG, payload);
+    const auto start = serial_frame::Decoder::Clock::now();
+    const std::size_t half = frame.size() / 2;
+    c.feed(std::vector<uint8_t>(frame.begin(), frame.begin() + static_cast<std::ptrdiff_t>(half)), start);
+    c.feed(std::vector<uint8_t>(frame.begin() + static_cast<std::ptrdiff_t>(half), frame.end()), start + 90ms);
+    CHECK(c.frames.size() == 1 && c.frames[0] == payload);
+    CHECK(c.decoder.syncTimeouts() == 0);
+    CHECK(c.text.empty());
+}
+
+} // namespace
+
+int main()
+{
+    testFramesAndTextByteByByte();
+    testInvalidHeaderRejectedImmediately();
+    testSyncTimeout();
+    testSlowFrameWithinTimeout();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d 项检查失败\n", failures);
+        return 1;
+    }
+    std::puts("全部通过");
+    return 0;
+}
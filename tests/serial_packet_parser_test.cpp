@@ -0,0 +1,152 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// SerialPacketParser 测试：与原来基于正则的解析做差分模糊测试，并检查超长包体后的重新同步
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include "regex_packet_parser.hpp"
+#include "serial_packet_parser.hpp"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                         \
+        }                                                                       \
+    } while (0)
+
+using regex_packet_parser::Events;
+
+SerialPacketHandlers recordingHandlers(Events& events)
+{
+    SerialPacketHandlers handlers;
+    handlers.on_wifi_setup = [&events]() { events.push_back("1"); };
+    handlers.on_wifi_confirm = [&events]() { events.push_back("3"); };
+    handlers.on_wifi_config = [&events](std::string_view ssid, std::string_view pwd) {
+        events.push_back("2|" + std::string(ssid) + "|" + std::string(pwd));
+    };
+    handlers.on_wifi_connecting = [&events](std::string_view ssid, std::string_view pwd) {
+        events.push_back("4|" + std::string(ssid) + "|" + std::string(pwd));
+    };
+    handlers.on_device_status = [&events](const DeviceStatusPacket& status) {
+        events.push_back("5|" + std::string(status.ip) + "|" + std::to_string(status.brightness) + "|" +
+                         std::to_string(status.power) + "|" + std::to_string(status.version));
+    };
+    handlers.on_light_control = [&events](int brightness) { events.push_back("6|" + std::to_string(brightness)); };
+    return handlers;
+}
+
+// 合法数据包与随机噪声混合，以 1-8 字节的随机分段喂给新解析器，结果应与参照实现完全一致
+void testDifferentialFuzz()
+{
+    const std::vector<std::string> valid = {
+        "A101B1", "A303B3", "A5128192168001100POWER87VERSION2B5", "A6255B6", "A2SSIDhomePWDsecretB2",
+        "A4SSIDpaperPWD12345678B4", "A512101POWER1VERSION1B5", "A5999999999999999POWER999VERSION999B5",
+    };
+    const std::string noise = "AB0123456789PWDSIOERVN \r\nxyz";
+    std::mt19937 rng(1);
+
+    int mismatches = 0;
+    std::size_t events_total = 0;
+    for (int iteration = 0; iteration < 20000; ++iteration) {
+        std::string stream;
+        const int pieces = static_cast<int>(rng() % 12);
+        for (int i = 0; i < pieces; ++i) {
+            if (rng() % 3 == 0) {
+                stream += valid[rng() % valid.size()];
+            } else {
+                const int length = static_cast<int>(rng() % 12);
+                for (int j = 0; j < length; ++j) {
+                    stream += noise[rng() % noise.size()];
+                }
+            }
+        }
+
+        const Events expected = regex_packet_parser::parse(stream);
+        Events actual;
+        SerialPacketParser parser(recordingHandlers(actual));
+        for (std::size_t pos = 0; pos < stream.size();) {
+            const std::size_t chunk = std::min<std::size_t>(1 + rng() % 8, stream.size() - pos);
+            parser.feed(stream.data() + pos, chunk);
+            pos += chunk;
+        }
+        events_total += expected.size();
+        if (actual != expected) {
+            if (mismatches < 5) {
+                std::fprintf(stderr, "结果不一致: [%s]\n", stream.c_str());
+            }
+            ++mismatches;
+        }
+    }
+    std::printf("差分模糊测试: 20000 段数据，%zu 个事件，%d 处不一致\n", events_total, mismatches);
+    CHECK(mismatches == 0);
+}
+
+// 丢失结束符后，同一段数据里紧跟着的数据包不能被跳过
+void testOverflowResyncInChunk()
+{
+    Events events;
+    SerialPacketParser parser(recordingHandlers(events));
+    parser.feed("A" + std::string(250, 'x'));
+    parser.feed(std::string(10, 'y') + "A303B3" + "A6100B6");
+    CHECK(parser.overflows() == 1);
+    CHECK((events == Events{"3", "6|100"}));
+}
+
+// 新包的 'A' 已经在缓存的包体里时，从它之后继续收集
+void testOverflowResyncInBuffer()
+{
+    Events events;
+    SerialPacketParser parser(recordingHandlers(events));
+    parser.feed("A" + std::string(SerialPacketParser::MAX_PACKET_SIZE - 2, 'x') + "A6");
+    parser.feed("25B6");
+    CHECK(parser.overflows() == 1);
+    CHECK((events == Events{"6|25"}));
+    CHECK(parser.packetsParsed() == 1);
+}
+
+// 长时间没有 'A' 和 'B' 的噪声不会让解析器卡住
+void testLongNoise()
+{
+    Events events;
+    SerialPacketParser parser(recordingHandlers(events));
+    parser.feed("A");
+    for (int i = 0; i < 10; ++i) {
+        parser.feed(std::string(100, 'z'));
+    }
+    parser.feed("A101B1");
+    CHECK((events == Events{"1"}));
+    CHECK(parser.overflows() >= 1);
+}
+
+} // namespace
+
+int main()
+{
+    testDifferentialFuzz();
+    testOverflowResyncInChunk();
+    testOverflowResyncInBuffer();
+    testLongNoise();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d 项检查失败\n", failures);
+        return 1;
+    }
+    std::puts("全部通过");
+    return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// UdpFrameReceiver 回环测试：本机发送分片后检查拼装、乱序、重复、丢片、迟到帧和随机丢包的统计
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QUdpSocket>
+#include <opencv2/imgcodecs.hpp>
+#include "udp_frame_protocol.hpp"
+#include "udp_frame_receiver.hpp"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            std::fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                         \
+        }                                                                       \
+    } while (0)
+
+constexpr quint16 TEST_PORT = 47291;
+
+// 噪声图像压缩后有十几 KB，会被拆成多个分片
+std::vector<uint8_t> makeJpeg(int seed)
+{
+    cv::Mat image(240, 240, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(seed % 16), cv::Scalar::all(255));
+    std::vector<uint8_t> jpeg;
+    cv::imencode(".jpg", image, jpeg, {cv::IMWRITE_JPEG_QUALITY, 90});
+    return jpeg;
+}
+
+// 处理事件直到条件满足或超时
+bool pumpUntil(const std::function<bool()>& done, int timeout_ms = 1000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done()) {
+        if (timer.elapsed() > timeout_ms) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+    }
+    return true;
+}
+
+void pumpFor(int ms)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < ms) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+    }
+}
+
+struct Fixture {
+    UdpFrameReceiver receiver{TEST_PORT};
+    QUdpSocket sender;
+
+    Fixture()
+    {
+        receiver.setReassemblyDeadline(std::chrono::milliseconds(50));
+        CHECK(receiver.start());
+    }
+
+    ~Fixture() { receiver.stop(); }
+
+    void send(const std::vector<uint8_t>& packet)
+    {
+        sender.writeDatagram(reinterpret_cast<const char*>(packet.data()), static_cast<qint64>(packet.size()),
+                             QHostAddress::LocalHost, TEST_PORT);
+    }
+
+    void waitForPackets(uint64_t count)
+    {
+        CHECK(pumpUntil([&]() { return receiver.getStats().packets_received >= count; }));
+    }
+};
+
+void testInOrderFrame()
+{
+    Fixture f;
+    const auto jpeg = makeJpeg(1);
+    const auto packets = udp_frame::fragment(jpeg.data(), jpeg.size(), 1);
+    CHECK(packets.size() > 1);
+    for (const auto& packet : packets) {
+        f.send(packet);
+    }
+    f.waitForPackets(packets.size());
+    const auto stats = f.receiver.getStats();
+    CHECK(stats.frames_completed == 1);
+    CHECK(f.receiver.getFrameSequence() == 1);
+    const cv::Mat frame = f.receiver.getLatestFrame();
+    CHECK(frame.cols == 240 && frame.rows == 240);
+}
+
+void testReorderedAndDuplicateFragments()
+{
+    Fixture f;
+    const auto jpeg = makeJpeg(2);
+    const auto packets = udp_frame::fragment(jpeg.data(), jpeg.size(), 7);
+    for (auto it = packets.rbegin(); it != packets.rend(); ++it) {
+        f.send(*it);
+    }
+    f.send(packets.back());
+    f.waitForPackets(packets.size() + 1);
+    const auto stats = f.receiver.getStats();
+    CHECK(stats.frames_completed == 1);
+    CHECK(stats.fragments_duplicate == 1);
+    CHECK(stats.packets_malformed == 0);
+}
+
+void testMissingFragmentExpires()
+{
+    Fixture f;
+    const auto jpeg = makeJpeg(3);
+    const auto packets = udp_frame::fragment(jpeg.data(), jpeg.size(), 1);
+    for (std::size_t i = 0; i < packets.size(); ++i) {
+        if (i != 1) {
+            f.send(packets[i]);
+        }
+    }
+    f.waitForPackets(packets.size() - 1);
+    CHECK(pumpUntil([&]() { return f.receiver.getStats().frames_incomplete == 1; }));
+    const auto stats = f.receiver.getStats();
+    CHECK(stats.frames_completed == 0);
+    CHECK(stats.fragments_lost == 1);
+    CHECK(f.receiver.getFrameSequence() == 0);
+}
+
+void testLateAndStaleFrames()
+{
+    Fixture f;
+    const auto older = makeJpeg(4);
+    const auto newer = makeJpeg(5);
+    const auto older_packets = udp_frame::fragment(older.data(), older.size(), 5);
+    const auto newer_packets = udp_frame::fragment(newer.data(), newer.size(), 6);
+
+    // 第 5 帧缺最后一片，第 6 帧完整到达后第 5 帧作为迟到帧丢弃
+    for (std::size_t i = 0; i + 1 < older_packets.size(); ++i) {
+        f.send(older_packets[i]);
+    }
+    for (const auto& packet : newer_packets) {
+        f.send(packet);
+    }
+    f.waitForPackets(older_packets.size() - 1 + newer_packets.size());
+    auto stats = f.receiver.getStats();
+    CHECK(stats.frames_completed == 1);
+    CHECK(stats.frames_late == 1);
+    CHECK(stats.fragments_lost == 1);
+
+    // 已发布第 6 帧后，补到的第 5 帧分片直接忽略
+    const uint64_t received = stats.packets_received;
+    f.send(older_packets.back());
+    f.waitForPackets(received + 1);
+    stats = f.receiver.getStats();
+    CHECK(stats.frames_completed == 1);
+    CHECK(f.receiver.getFrameSequence() == 1);
+}
+
+void testMalformedPacket()
+{
+    Fixture f;
+    std::vector<uint8_t> packet(udp_frame::HEADER_SIZE + 10, 0xAB);
+    f.send(packet);
+    f.waitForPackets(1);
+    CHECK(f.receiver.getStats().packets_malformed == 1);
+}
+
+// 随机丢片：任何一片丢失的帧都不能完成，其余帧都应完成，丢失的分片数要与统计一致
+void testRandomLoss()
+{
+    Fixture f;
+    constexpr int FRAME_COUNT = 60;
+    constexpr double LOSS = 0.05;
+    std::mt19937 rng(12345);
+    std::bernoulli_distribution drop(LOSS);
+
+    uint64_t sent = 0;
+    uint64_t frames_seen = 0;
+    uint64_t frames_intact = 0;
+    uint64_t fragments_dropped = 0;
+    for (int id = 1; id <= FRAME_COUNT; ++id) {
+        const auto jpeg = makeJpeg(id);
+        const auto packets = udp_frame::fragment(jpeg.data(), jpeg.size(), static_cast<uint32_t>(id));
+        uint64_t dropped = 0;
+        for (const auto& packet : packets) {
+            if (drop(rng)) {
+                ++dropped;
+                continue;
+            }
+            f.send(packet);
+            ++sent;
+        }
+        if (dropped < packets.size()) {
+            ++frames_seen;
+            fragments_dropped += dropped;
+            frames_intact += dropped == 0 ? 1 : 0;
+        }
+        // 逐帧等接收端处理完，避免回环缓冲区溢出造成测试之外的丢包
+        f.waitForPackets(sent);
+    }
+    pumpFor(200);
+
+    const auto stats = f.receiver.getStats();
+    std::printf("随机丢片: 帧 %llu 完整 %llu，完成 %llu 不完整 %llu 迟到 %llu，丢失分片 %llu/%llu\n",
+                static_cast<unsigned long long>(frames_seen), static_cast<unsigned long long>(frames_intact),
+                static_cast<unsigned long long>(stats.frames_completed),
+                static_cast<unsigned long long>(stats.frames_incomplete),
+                static_cast<unsigned long long>(stats.frames_late),
+                static_cast<unsigned long long>(stats.fragments_lost),
+                static_cast<unsigned long long>(fragments_dropped));
+    CHECK(stats.frames_completed == frames_intact);
+    CHECK(stats.frames_completed + stats.frames_incomplete + stats.frames_late == frames_seen);
+    CHECK(stats.fragments_lost == fragments_dropped);
+    CHECK(stats.packets_malformed == 0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testInOrderFrame();
+    testReorderedAndDuplicateFragments();
+    testMissingFragmentExpires();
+    testLateAndStaleFrames();
+    testMalformedPacket();
+    testRandomLoss();
+
+    if (failures != 0) {
+        std::fprintf(stderr, "%d 项检查失败\n", failures);
+        return 1;
+    }
+    std::puts("全部通过");
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "device_discovery.hpp"
+#include <algorithm>
+#include <QCoreApplication>
+#include "logger.hpp"
+
+#if !defined(_WIN32) && !defined(__linux__)
+std::unique_ptr<DeviceDiscoveryBackend> createDeviceDiscoveryBackend()
+{
+    return nullptr;
+}
+#endif
+
+DeviceDiscovery& DeviceDiscovery::instance()
+{
+    static DeviceDiscovery discovery;
+    return discovery;
+}
+
+DeviceDiscovery::DeviceDiscovery()
+{
+    discovery_thread.setObjectName("DeviceDiscovery");
+    discovery_thread.start();
+
+    rescan_timer = new QTimer();
+    rescan_timer->setSingleShot(true);
+    rescan_timer->moveToThread(&discovery_thread);
+    QObject::connect(rescan_timer, &QTimer::timeout, rescan_timer, [this]() { rescan(); });
+    // 首次枚举也在发现线程上进行，窗口启动不等待
+    QMetaObject::invokeMethod(rescan_timer, [this]() { startOnThread(); }, Qt::QueuedConnection);
+
+    if (QCoreApplication::instance()) {
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, [this]() {
+            shutdown();
+        });
+    }
+}
+
+DeviceDiscovery::~DeviceDiscovery()
+{
+    shutdown();
+}
+
+void DeviceDiscovery::shutdown()
+{
+    if (!discovery_thread.isRunning()) {
+        return;
+    }
+    QMetaObject::invokeMethod(rescan_timer, [this]() { stopOnThread(); }, Qt::BlockingQueuedConnection);
+    discovery_thread.quit();
+    discovery_thread.wait();
+}
+
+int DeviceDiscovery::subscribe(QObject* context, Callback callback)
+{
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = next_listener_id++;
+        listeners.push_back({id, context, std::move(callback)});
+    }
+    // 现有设备在发现线程上补发，保证与增量事件不重复、不遗漏
+    if (rescan_timer) {
+        QMetaObject::invokeMethod(rescan_timer, [this, id]() { prime(id); }, Qt::QueuedConnection);
+    }
+    return id;
+}
+
+void DeviceDiscovery::unsubscribe(int id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::erase_if(listeners, [id](const Listener& listener) { return listener.id == id; });
+}
+
+std::vector<SerialDeviceInfo> DeviceDiscovery::devices() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return current_devices;
+}
+
+void DeviceDiscovery::startOnThread()
+{
+    backend = createDeviceDiscoveryBackend();
+    if (!backend) {
+        LOG_WARN("当前平台不支持串口设备发现");
+    } else if (!backend->startMonitoring([this]() { rescan_timer->start(RESCAN_DELAY_MS); })) {
+        LOG_WARN("串口热插拔监听启动失败，只在启动时枚举一次设备");
+    }
+    rescan();
+}
+
+void DeviceDiscovery::stopOnThread()
+{
+    if (backend) {
+        backend->stopMonitoring();
+        backend.reset();
+    }
+    delete rescan_timer;
+    rescan_timer = nullptr;
+}
+
+void DeviceDiscovery::rescan()
+{
+    std::vector<SerialDeviceInfo> found = backend ? backend->scan() : std::vector<SerialDeviceInfo>{};
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto contains = [](const std::vector<SerialDeviceInfo>& list, const SerialDeviceInfo& device) {
+        return std::find(list.begin(), list.end(), device) != list.end();
+    };
+    for (const auto& device : current_devices) {
+        if (contains(found, device)) {
+            continue;
+        }
+        LOG_DEBUG("串口设备已移除: {}", device.port);
+        for (const auto& listener : listeners) {
+            if (listener.primed) {
+                post(listener, {SerialDeviceEvent::DETACHED, device});
+            }
+        }
+    }
+    for (const auto& device : found) {
+        if (contains(current_devices, device)) {
+            continue;
+        }
+        LOG_DEBUG("发现串口设备: {} {:04X}:{:04X} {}", device.port, device.vendor_id, device.product_id, device.description);
+        for (const auto& listener : listeners) {
+            if (listener.primed) {
+                post(listener, {SerialDeviceEvent::ATTACHED, device});
+            }
+        }
+    }
+    current_devices = std::move(found);
+}
+
+void DeviceDiscovery::prime(int id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find_if(listeners.begin(), listeners.end(), [id](const Listener& l) { return l.id == id; });
+    if (it == listeners.end()) {
+        return;
+    }
+    for (const auto& device : current_devices) {
+        post(*it, {SerialDeviceEvent::ATTACHED, device});
+    }
+    post(*it, {SerialDeviceEvent::ENUMERATED, {}});
+    it->primed = true;
+}
+
+void DeviceDiscovery::post(const Listener& listener, const SerialDeviceEvent& event)
+{
+    // 持有 mutex 时调用，unsubscribe 之后不会再投递到已销毁的 context
+    QMetaObject::invokeMethod(listener.context, [callback = listener.callback, event]() {
+        callback(event);
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,159 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// Linux 实现：从 /sys/class/tty 枚举 USB 串口，通过内核 uevent netlink 接收热插拔通知
+#ifdef __linux__
+
+#include "device_discovery.hpp"
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <QSocketNotifier>
+#include "logger.hpp"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+std::string readFirstLine(const fs::path& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+int readHex(const fs::path& path)
+{
+    const std::string text = readFirstLine(path);
+    if (text.empty()) {
+        return -1;
+    }
+    try {
+        return std::stoi(text, nullptr, 16);
+    } catch (const std::exception&) {
+        return -1;
+    }
+}
+
+class LinuxDeviceDiscoveryBackend : public DeviceDiscoveryBackend {
+public:
+    ~LinuxDeviceDiscoveryBackend() override
+    {
+        stopMonitoring();
+    }
+
+    std::vector<SerialDeviceInfo> scan() override
+    {
+        std::vector<SerialDeviceInfo> devices;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator("/sys/class/tty", ec)) {
+            // 虚拟终端和 pty 没有 device 链接
+            const fs::path device = fs::canonical(entry.path() / "device", ec);
+            if (ec) {
+                ec.clear();
+                continue;
+            }
+            SerialDeviceInfo info;
+            info.port = "/dev/" + entry.path().filename().string();
+            // 向上查找 USB 接口（bInterfaceNumber）和 USB 设备（idVendor）
+            for (fs::path dir = device; dir.has_relative_path(); dir = dir.parent_path()) {
+                if (info.interface_number < 0 && fs::exists(dir / "bInterfaceNumber", ec)) {
+                    info.interface_number = readHex(dir / "bInterfaceNumber");
+                }
+                if (fs::exists(dir / "idVendor", ec)) {
+                    info.vendor_id = static_cast<uint16_t>(readHex(dir / "idVendor"));
+                    info.product_id = static_cast<uint16_t>(readHex(dir / "idProduct"));
+                    info.description = readFirstLine(dir / "product");
+                    break;
+                }
+            }
+            // 主板自带的 ttyS* 即使不存在也会列出，只保留 USB 串口
+            if (info.vendor_id == 0) {
+                continue;
+            }
+            devices.push_back(std::move(info));
+        }
+        return devices;
+    }
+
+    bool startMonitoring(std::function<void()> onChanged) override
+    {
+        on_changed = std::move(onChanged);
+        // 内核 uevent 广播组，udev 也是从这里收到事件；不依赖 libudev
+        netlink_fd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+        if (netlink_fd < 0) {
+            LOG_WARN("无法创建 uevent netlink 套接字");
+            return false;
+        }
+        sockaddr_nl addr{};
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = 1;
+        if (::bind(netlink_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            LOG_WARN("无法绑定 uevent netlink 套接字");
+            ::close(netlink_fd);
+            netlink_fd = -1;
+            return false;
+        }
+        notifier = std::make_unique<QSocketNotifier>(netlink_fd, QSocketNotifier::Read);
+        QObject::connect(notifier.get(), &QSocketNotifier::activated, notifier.get(), [this]() { drain(); });
+        return true;
+    }
+
+    void stopMonitoring() override
+    {
+        notifier.reset();
+        if (netlink_fd >= 0) {
+            ::close(netlink_fd);
+            netlink_fd = -1;
+        }
+    }
+
+private:
+    void drain()
+    {
+        bool changed = false;
+        while (true) {
+            const ssize_t n = ::recv(netlink_fd, buffer.data(), buffer.size(), 0);
+            if (n <= 0) {
+                break;
+            }
+            // 消息为 "add@/devices/...\0ACTION=add\0SUBSYSTEM=tty\0..."
+            const std::string_view message(buffer.data(), static_cast<std::size_t>(n));
+            if (message.find(std::string_view("SUBSYSTEM=tty\0", 14)) != std::string_view::npos ||
+                message.find(std::string_view("SUBSYSTEM=usb\0", 14)) != std::string_view::npos) {
+                changed = true;
+            }
+        }
+        if (changed && on_changed) {
+            on_changed();
+        }
+    }
+
+    int netlink_fd = -1;
+    std::unique_ptr<QSocketNotifier> notifier;
+    std::function<void()> on_changed;
+    std::array<char, 8192> buffer{};
+};
+
+} // namespace
+
+std::unique_ptr<DeviceDiscoveryBackend> createDeviceDiscoveryBackend()
+{
+    return std::make_unique<LinuxDeviceDiscoveryBackend>();
+}
+
+#endif // __linux__
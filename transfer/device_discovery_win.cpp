@@ -0,0 +1,166 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+// Windows 实现：SetupAPI 枚举串口类设备，RegisterDeviceNotification 接收热插拔通知
+#ifdef _WIN32
+
+#include "device_discovery.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <windows.h>
+#include <setupapi.h>
+#include <devguid.h>    // 包含 GUID_DEVCLASS_PORTS
+#include <dbt.h>
+#include "logger.hpp"
+
+namespace {
+
+// GUID_DEVINTERFACE_COMPORT，直接定义避免为 ntddser.h 引入 initguid.h
+constexpr GUID COMPORT_INTERFACE_GUID = {0x86E0D1E0, 0x8089, 0x11D0, {0x9C, 0xE4, 0x08, 0x00, 0x3E, 0x30, 0x1F, 0x73}};
+constexpr wchar_t WINDOW_CLASS_NAME[] = L"PaperTrackerDeviceDiscovery";
+
+// 从 "USB\VID_303A&PID_1001&MI_00\..." 中取出 key 后面的十六进制数
+int parseInstanceHex(const char* instance_id, const char* key)
+{
+    const char* pos = strstr(instance_id, key);
+    if (!pos) {
+        return -1;
+    }
+    return static_cast<int>(strtol(pos + strlen(key), nullptr, 16));
+}
+
+class WindowsDeviceDiscoveryBackend : public DeviceDiscoveryBackend {
+public:
+    ~WindowsDeviceDiscoveryBackend() override
+    {
+        stopMonitoring();
+    }
+
+    std::vector<SerialDeviceInfo> scan() override
+    {
+        std::vector<SerialDeviceInfo> devices;
+        HDEVINFO hDevInfo = SetupDiGetClassDevs(&GUID_DEVCLASS_PORTS, nullptr, nullptr, DIGCF_PRESENT);
+        if (hDevInfo == INVALID_HANDLE_VALUE) {
+            LOG_ERROR("获取设备信息集失败，错误码: {}", GetLastError());
+            return devices;
+        }
+
+        SP_DEVINFO_DATA devInfoData;
+        devInfoData.cbSize = sizeof(SP_DEVINFO_DATA);
+        for (DWORD i = 0; SetupDiEnumDeviceInfo(hDevInfo, i, &devInfoData); i++) {
+            HKEY hKey = SetupDiOpenDevRegKey(hDevInfo, &devInfoData, DICS_FLAG_GLOBAL, 0, DIREG_DEV, KEY_READ);
+            if (hKey == INVALID_HANDLE_VALUE) {
+                continue;
+            }
+            char portName[16] = {0};
+            DWORD dwSize = sizeof(portName);
+            DWORD dwType = 0;
+            const bool hasPort = RegQueryValueExA(hKey, "PortName", nullptr, &dwType,
+                                                  reinterpret_cast<LPBYTE>(portName), &dwSize) == ERROR_SUCCESS;
+            RegCloseKey(hKey);
+            if (!hasPort) {
+                continue;
+            }
+
+            SerialDeviceInfo info;
+            info.port = portName;
+            char instanceId[256] = {0};
+            if (SetupDiGetDeviceInstanceIdA(hDevInfo, &devInfoData, instanceId, sizeof(instanceId), nullptr)) {
+                const int vid = parseInstanceHex(instanceId, "VID_");
+                const int pid = parseInstanceHex(instanceId, "PID_");
+                if (vid >= 0 && pid >= 0) {
+                    info.vendor_id = static_cast<uint16_t>(vid);
+                    info.product_id = static_cast<uint16_t>(pid);
+                }
+                info.interface_number = parseInstanceHex(instanceId, "MI_");
+            }
+            char friendlyName[256] = {0};
+            if (SetupDiGetDeviceRegistryPropertyA(hDevInfo, &devInfoData, SPDRP_FRIENDLYNAME, nullptr,
+                                                  reinterpret_cast<PBYTE>(friendlyName), sizeof(friendlyName), nullptr)) {
+                info.description = friendlyName;
+            }
+            devices.push_back(std::move(info));
+        }
+        SetupDiDestroyDeviceInfoList(hDevInfo);
+        return devices;
+    }
+
+    bool startMonitoring(std::function<void()> onChanged) override
+    {
+        on_changed = std::move(onChanged);
+
+        // 仅接收消息的隐藏窗口，建在发现线程上，由该线程的 Qt 事件循环分发消息
+        WNDCLASSEXW wc = {};
+        wc.cbSize = sizeof(wc);
+        wc.lpfnWndProc = &WindowsDeviceDiscoveryBackend::windowProc;
+        wc.hInstance = GetModuleHandleW(nullptr);
+        wc.lpszClassName = WINDOW_CLASS_NAME;
+        RegisterClassExW(&wc);
+
+        hwnd = CreateWindowExW(0, WINDOW_CLASS_NAME, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, wc.hInstance, nullptr);
+        if (!hwnd) {
+            LOG_WARN("创建设备通知窗口失败，错误码: {}", GetLastError());
+            return false;
+        }
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+
+        DEV_BROADCAST_DEVICEINTERFACE_W filter = {};
+        filter.dbcc_size = sizeof(filter);
+        filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+        filter.dbcc_classguid = COMPORT_INTERFACE_GUID;
+        notification = RegisterDeviceNotificationW(hwnd, &filter, DEVICE_NOTIFY_WINDOW_HANDLE);
+        if (!notification) {
+            LOG_WARN("注册设备通知失败，错误码: {}", GetLastError());
+            stopMonitoring();
+            return false;
+        }
+        return true;
+    }
+
+    void stopMonitoring() override
+    {
+        if (notification) {
+            UnregisterDeviceNotification(notification);
+            notification = nullptr;
+        }
+        if (hwnd) {
+            DestroyWindow(hwnd);
+            hwnd = nullptr;
+        }
+    }
+
+private:
+    static LRESULT CALLBACK windowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+    {
+        if (msg == WM_DEVICECHANGE && (wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE)) {
+            auto* self = reinterpret_cast<WindowsDeviceDiscoveryBackend*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+            if (self && self->on_changed) {
+                self->on_changed();
+            }
+            return TRUE;
+        }
+        return DefWindowProcW(hwnd, msg, wParam, lParam);
+    }
+
+    HWND hwnd = nullptr;
+    HDEVNOTIFY notification = nullptr;
+    std::function<void()> on_changed;
+};
+
+} // namespace
+
+std::unique_ptr<DeviceDiscoveryBackend> createDeviceDiscoveryBackend()
+{
+    return std::make_unique<WindowsDeviceDiscoveryBackend>();
+}
+
+#endif // _WIN32
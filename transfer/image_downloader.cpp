@@ -19,12 +19,31 @@
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 #include <QUrl>
-#include <QMutexLocker>
+#include <QDateTime>
+#include <QThread>
 #include <QTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <algorithm>
+#include <map>
+#include <random>
+#include "config_writer.hpp"
+
+namespace {
+
+// 每个设备上次连接成功的 WebSocket 地址
+struct StreamAddressCache {
+    std::map<std::string, std::string> last_urls;
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(StreamAddressCache, last_urls);
+};
+
+const std::string STREAM_CACHE_PATH = "./stream_cache.json";
+
+} // namespace
+
 ESP32VideoStream::ESP32VideoStream(QObject *parent)
-    : QObject(parent), isRunning(false), webSocket(nullptr), heartbeatTimer(nullptr)
+    : QObject(parent), isRunning(false), webSocket(nullptr)
 {
 }
 
@@ -32,6 +51,7 @@ ESP32VideoStream::~ESP32VideoStream() {
     if (isRunning) {
         stop();
     }
+    abortPendingConnections();
 
     // 确保 mdnsLookup 被正确清理
     if (mdnsLookup) {
@@ -40,9 +60,15 @@ ESP32VideoStream::~ESP32VideoStream() {
     }
 }
 
-// 修改 init 方法
 // 修改 init 方法
 bool ESP32VideoStream::init(const std::string& url, int deviceType) {
+    if (QThread::currentThread() != thread() && thread()->isRunning()) {
+        // WebSocket 和 mDNS 查询都属于网络线程，转发过去同步执行
+        bool result = false;
+        QMetaObject::invokeMethod(this, [&]() { result = init(url, deviceType); },
+                                  Qt::BlockingQueuedConnection);
+        return result;
+    }
     if (url.empty()) {
         if (this->currentStreamUrl.empty()) {
             LOG_INFO("无法初始化WebSocket：URL为空");
@@ -53,7 +79,6 @@ bool ESP32VideoStream::init(const std::string& url, int deviceType) {
 
     // 清空连接 URL 列表
     connection_urls.clear();
-    connection_attempts = 0;
 
     // 保存原始 URL，但不要立即连接
     currentStreamUrl = url;
@@ -149,6 +174,16 @@ bool ESP32VideoStream::init(const std::string& url, int deviceType) {
             break;
     }
 
+    device_type = deviceType;
+    // 上次连接成功的地址放在最前面，第一个发起连接
+    cache_key = deviceType != DEVICE_TYPE_UNKNOWN ? "device_" + std::to_string(deviceType) : url;
+    const QString cachedUrl = QString::fromStdString(loadCachedUrl());
+    if (!cachedUrl.isEmpty()) {
+        connection_urls.removeAll(cachedUrl);
+        connection_urls.prepend(cachedUrl);
+        LOG_DEBUG("优先尝试上次连接成功的地址: {}", cachedUrl.toStdString());
+    }
+
     LOG_DEBUG("初始化WebSocket视频流，URL列表: {}",
               connection_urls.join(", ").toStdString());
 
@@ -184,11 +219,15 @@ void ESP32VideoStream::setupMdnsLookup(const QString& hostname) {
                 if (!connection_urls.contains(wsUrl)) {
                     connection_urls.prepend(wsUrl);
                     LOG_INFO("添加 mDNS 解析的 URL: {}", wsUrl.toStdString());
+                    // 正在连接中则直接加入这一轮竞速
+                    if (race_active && !connectionEstablished) {
+                        launchCandidate(wsUrl);
+                    }
                 }
 
                 // 如果尚未开始连接，开始尝试连接
-                if (connection_attempts == 0 && !isRunning) {
-                    tryConnectToNextAddress();
+                if (!race_active && !isRunning) {
+                    startConnectionRace();
                 }
             } else {
                 LOG_WARN("mDNS 解析未找到 IP 地址: {}", hostname.toStdString());
@@ -200,8 +239,8 @@ void ESP32VideoStream::setupMdnsLookup(const QString& hostname) {
         }
 
         // 即使 mDNS 解析失败，也开始尝试连接
-        if (connection_attempts == 0 && !isRunning) {
-            QTimer::singleShot(500, this, &ESP32VideoStream::tryConnectToNextAddress);
+        if (!race_active && !isRunning) {
+            startConnectionRace();
         }
     });
 
@@ -211,33 +250,92 @@ void ESP32VideoStream::setupMdnsLookup(const QString& hostname) {
     LOG_INFO("开始 mDNS 解析: {}", hostname.toStdString());
 }
 
-// 尝试连接到下一个地址
-void ESP32VideoStream::tryConnectToNextAddress() {
-    if (connection_attempts >= connection_urls.size()) {
+// 同时向所有候选地址发起连接，每个地址错开 CONNECTION_STAGGER_MS 启动
+void ESP32VideoStream::startConnectionRace() {
+    abortPendingConnections();
+    if (connection_urls.isEmpty()) {
         LOG_DEBUG("无法通过WIFI链接到捕捉设备");
-        connection_attempts=0;
         return;
     }
 
-    QString urlToTry = connection_urls.at(connection_attempts);
-    connection_attempts++;
+    ++race_generation;
+    race_active = true;
+    race_launched = 0;
+    connectionEstablished = false;
+    LOG_DEBUG("同时尝试连接 {} 个地址: {}", connection_urls.size(),
+              connection_urls.join(", ").toStdString());
+
+    const int generation = race_generation;
+    const QStringList urls = connection_urls;
+    for (int i = 0; i < urls.size(); ++i) {
+        const QString url = urls.at(i);
+        if (i == 0) {
+            launchCandidate(url);
+            continue;
+        }
+        QTimer::singleShot(i * CONNECTION_STAGGER_MS, this, [this, generation, url]() {
+            if (generation == race_generation && race_active && !connectionEstablished) {
+                launchCandidate(url);
+            }
+        });
+    }
+
+    // 整轮超时：最后一个地址启动后再等 CONNECTION_TIMEOUT_MS
+    if (!connectionTimeoutTimer) {
+        connectionTimeoutTimer = new QTimer(this);
+        connectionTimeoutTimer->setSingleShot(true);
+        connect(connectionTimeoutTimer, &QTimer::timeout, this, [this]() {
+            if (race_active && !connectionEstablished) {
+                LOG_DEBUG("所有候选地址连接超时");
+                abortPendingConnections();
+                LOG_DEBUG("无法通过WIFI链接到捕捉设备");
+            }
+        });
+    }
+    connectionTimeoutTimer->start((urls.size() - 1) * CONNECTION_STAGGER_MS + CONNECTION_TIMEOUT_MS);
+}
+
+void ESP32VideoStream::launchCandidate(const QString& url) {
+    for (const auto& pending : pendingConnections) {
+        if (pending == url) {
+            return;
+        }
+    }
+    ++race_launched;
+    LOG_DEBUG("尝试连接到 URL: {}", url.toStdString());
+
+    auto* socket = new QWebSocket();
+    socket->setProxy(QNetworkProxy::NoProxy);
+    pendingConnections.insert(socket, url);
 
-    LOG_DEBUG("尝试连接到 URL ({}/{}): {}",
-             connection_attempts,
-             connection_urls.size(),
-             urlToTry.toStdString());
+    connect(socket, &QWebSocket::connected, this, [this, socket]() {
+        onCandidateConnected(socket);
+    });
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::errorOccurred),
+            this, [this, socket](QAbstractSocket::SocketError error) {
+        onCandidateError(socket, error);
+    });
+
+    socket->open(QUrl(url));
+}
+
+void ESP32VideoStream::onCandidateConnected(QWebSocket* socket) {
+    if (!pendingConnections.contains(socket)) {
+        return;
+    }
+    const QString url = pendingConnections.take(socket);
+    LOG_DEBUG("地址 {} 最先完成握手", url.toStdString());
+
+    // 关闭其余仍在握手的连接
+    abortPendingConnections();
+    connectionEstablished = true;
 
-    // 创建 WebSocket 连接
     if (webSocket) {
         disconnect(webSocket, nullptr, this, nullptr);
         webSocket->deleteLater();
     }
-
-    webSocket = new QWebSocket();
-    webSocket->setProxy(QNetworkProxy::NoProxy);
-
-    // 连接信号
-    connect(webSocket, &QWebSocket::connected, this, &ESP32VideoStream::onConnected);
+    webSocket = socket;
+    disconnect(webSocket, nullptr, this, nullptr);
     connect(webSocket, &QWebSocket::disconnected, this, &ESP32VideoStream::onDisconnected);
     connect(webSocket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::errorOccurred),
             this, &ESP32VideoStream::onError);
@@ -246,16 +344,72 @@ void ESP32VideoStream::tryConnectToNextAddress() {
     connect(webSocket, &QWebSocket::textMessageReceived,
             this, &ESP32VideoStream::onTextMessageReceived);
 
-    // 打开连接
-    webSocket->open(QUrl(urlToTry));
+    // 断流重连时最先尝试这个地址
+    connection_urls.removeAll(url);
+    connection_urls.prepend(url);
 
-    // 设置连接超时
-    QTimer::singleShot(3000, this, [this, urlToTry]() {
-        if (!isRunning && webSocket && webSocket->state() != QAbstractSocket::ConnectedState) {
-            LOG_DEBUG("连接到 {} 超时，尝试下一个地址", urlToTry.toStdString());
-            tryConnectToNextAddress();
+    onConnected();
+    if (url.toStdString() != loadCachedUrl()) {
+        saveCachedUrl(url.toStdString());
+    }
+}
+
+void ESP32VideoStream::onCandidateError(QWebSocket* socket, QAbstractSocket::SocketError error) {
+    if (!pendingConnections.contains(socket)) {
+        return;
+    }
+    const QString url = pendingConnections.take(socket);
+    LOG_DEBUG("连接 {} 失败: {}-{}", url.toStdString(), static_cast<int>(error),
+              socket->errorString().toStdString());
+    disconnect(socket, nullptr, this, nullptr);
+    socket->deleteLater();
+
+    // 所有地址都已启动且全部失败，不必等到超时
+    if (race_active && !connectionEstablished && pendingConnections.isEmpty() &&
+        race_launched >= connection_urls.size()) {
+        race_active = false;
+        if (connectionTimeoutTimer) {
+            connectionTimeoutTimer->stop();
         }
-    });
+        LOG_DEBUG("无法通过WIFI链接到捕捉设备");
+    }
+}
+
+void ESP32VideoStream::abortPendingConnections() {
+    race_active = false;
+    ++race_generation;
+    if (connectionTimeoutTimer) {
+        connectionTimeoutTimer->stop();
+    }
+    for (auto it = pendingConnections.begin(); it != pendingConnections.end(); ++it) {
+        QWebSocket* socket = it.key();
+        disconnect(socket, nullptr, this, nullptr);
+        socket->abort();
+        socket->deleteLater();
+    }
+    pendingConnections.clear();
+}
+
+std::string ESP32VideoStream::loadCachedUrl() const {
+    if (cache_key.empty() || !std::filesystem::exists(STREAM_CACHE_PATH)) {
+        return {};
+    }
+    auto cache = ConfigWriter(STREAM_CACHE_PATH).get_config<StreamAddressCache>();
+    auto it = cache.last_urls.find(cache_key);
+    return it == cache.last_urls.end() ? std::string{} : it->second;
+}
+
+void ESP32VideoStream::saveCachedUrl(const std::string& url) const {
+    if (cache_key.empty()) {
+        return;
+    }
+    // 所有视频流都在同一个网络线程上，读改写不会互相覆盖
+    ConfigWriter writer(STREAM_CACHE_PATH);
+    auto cache = writer.get_config<StreamAddressCache>();
+    cache.last_urls[cache_key] = url;
+    if (!writer.write_config(cache)) {
+        LOG_WARN("无法保存连接地址缓存: {}", STREAM_CACHE_PATH);
+    }
 }
 
 void ESP32VideoStream::checkHeartBeat()
@@ -263,73 +417,154 @@ void ESP32VideoStream::checkHeartBeat()
     // 检查URL是否为空
     if (currentStreamUrl.empty()) {
         // URL为空，停止心跳检查
-        if (heartbeatTimer->isActive()) {
-            heartbeatTimer->stop();
-        }
+        heartbeat_enabled = false;
         return;
     }
 
-    if (image_not_receive_count++ > 50)
-    {
-        image_not_receive_count = 0;
+    // 正在连接中，由连接竞速自己的超时处理
+    if (race_active) {
+        return;
+    }
+
+    using namespace std::chrono;
+    const auto now = steady_clock::now();
+    if (connectionEstablished) {
+        const float interval = frame_interval_ms.load(std::memory_order_relaxed);
+        const float timeout = interval > 0.0f
+            ? std::max(static_cast<float>(MIN_STALL_TIMEOUT_MS), interval * STALL_INTERVAL_FACTOR)
+            : static_cast<float>(INITIAL_STALL_TIMEOUT_MS);
+        const float silent = duration<float, std::milli>(now - last_frame_time).count();
+        if (silent <= timeout) {
+            return;
+        }
+        LOG_INFO("视频流断流: {:.0f} ms 未收到图像 (预期帧间隔 {:.1f} ms)", silent, interval);
+        if (!recovering) {
+            // 第一次断流立即重连
+            ++stall_count;
+            recovering = true;
+            stall_detected_time = now;
+            reconnect();
+            return;
+        }
+        // 重连成功但仍然没有图像，算作一次失败，交给下面的退避逻辑
+        if (webSocket) {
+            disconnect(webSocket, nullptr, this, nullptr);
+            webSocket->abort();
+            webSocket->deleteLater();
+            webSocket = nullptr;
+        }
         isRunning = false;
-        stop();
-        start();
+        connectionEstablished = false;
+    }
+
+    // 连接已断开（或上一轮连接全部失败）
+    if (!recovering) {
+        ++stall_count;
+        recovering = true;
+        stall_detected_time = now;
+        reconnect();
+        return;
+    }
+    if (next_reconnect_time == steady_clock::time_point{}) {
+        const int delay = nextBackoffMs();
+        next_reconnect_time = now + milliseconds(delay);
+        LOG_DEBUG("第 {} 次重连失败，{} ms 后重试", consecutive_failures.load(), delay);
+        return;
+    }
+    if (now >= next_reconnect_time) {
+        next_reconnect_time = {};
+        reconnect();
     }
 }
 
+void ESP32VideoStream::reconnect()
+{
+    isRunning = false;
+    connectionEstablished = false;
+    if (webSocket) {
+        disconnect(webSocket, nullptr, this, nullptr);
+        webSocket->abort();
+        webSocket->deleteLater();
+        webSocket = nullptr;
+    }
+    startConnectionRace();
+}
+
+int ESP32VideoStream::nextBackoffMs()
+{
+    thread_local std::mt19937 rng{std::random_device{}()};
+    const int failures = ++consecutive_failures;
+    const int exponent = std::min(failures - 1, 10);
+    const int base = std::min(RECONNECT_BACKOFF_BASE_MS << exponent, RECONNECT_BACKOFF_MAX_MS);
+    // ±50% 抖动，避免多台设备同时重连
+    std::uniform_real_distribution<float> jitter(0.5f, 1.5f);
+    return static_cast<int>(base * jitter(rng));
+}
+
+void ESP32VideoStream::onFrameArrived()
+{
+    using namespace std::chrono;
+    const auto now = steady_clock::now();
+    if (has_previous_frame) {
+        const float dt = duration<float, std::milli>(now - last_frame_time).count();
+        const float interval = frame_interval_ms.load(std::memory_order_relaxed);
+        frame_interval_ms.store(interval > 0.0f ? interval + FRAME_INTERVAL_ALPHA * (dt - interval) : dt,
+                                std::memory_order_relaxed);
+    }
+    has_previous_frame = true;
+    last_frame_time = now;
+
+    if (recovering) {
+        const float elapsed = duration<float, std::milli>(now - stall_detected_time).count();
+        last_reconnect_ms.store(elapsed, std::memory_order_relaxed);
+        ++reconnect_count;
+        LOG_INFO("视频流已恢复，重连耗时 {:.0f} ms", elapsed);
+        recovering = false;
+        consecutive_failures = 0;
+        next_reconnect_time = {};
+    }
+}
+
+StreamMetrics ESP32VideoStream::getMetrics() const
+{
+    StreamMetrics metrics;
+    metrics.stall_count = stall_count.load(std::memory_order_relaxed);
+    metrics.reconnect_count = reconnect_count.load(std::memory_order_relaxed);
+    metrics.last_reconnect_ms = last_reconnect_ms.load(std::memory_order_relaxed);
+    metrics.expected_frame_interval_ms = frame_interval_ms.load(std::memory_order_relaxed);
+    metrics.consecutive_failures = consecutive_failures.load(std::memory_order_relaxed);
+    return metrics;
+}
+
 bool ESP32VideoStream::start() {
+    if (QThread::currentThread() != thread() && thread()->isRunning()) {
+        bool result = false;
+        QMetaObject::invokeMethod(this, [&]() { result = start(); }, Qt::BlockingQueuedConnection);
+        return result;
+    }
     // 检查URL是否为空
     if (connection_urls.isEmpty() && currentStreamUrl.empty()) {
         LOG_INFO("无法启动WebSocket连接：URL为空");
         return false;
     }
 
-    webSocket = new QWebSocket();
-    // 禁用代理设置，避免代理相关错误
-    webSocket->setProxy(QNetworkProxy::NoProxy);
-
-    connect(webSocket, &QWebSocket::connected,
-        this, &ESP32VideoStream::onConnected);
-    connect(webSocket, &QWebSocket::disconnected,
-            this, &ESP32VideoStream::onDisconnected);
-    connect(webSocket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::errorOccurred),
-            this, &ESP32VideoStream::onError);
-    connect(webSocket, &QWebSocket::binaryMessageReceived,
-            this, &ESP32VideoStream::onBinaryMessageReceived);
-    // 添加文本消息处理的连接
-    connect(webSocket, &QWebSocket::textMessageReceived,
-            this, &ESP32VideoStream::onTextMessageReceived);
-
-    if (!heartbeatTimer)
-    {
-        heartbeatTimer = new QTimer();
-        connect(heartbeatTimer, &QTimer::timeout, this, &ESP32VideoStream::checkHeartBeat);
-    }
-
-
     if (isRunning) {
         LOG_WARN("视频流已经在运行中");
         return false;
     }
 
     // 开始连接尝试
-    connection_attempts = 0;
-    tryConnectToNextAddress();
-
-    if (!heartbeatTimer) {
-        heartbeatTimer = new QTimer();
-        connect(heartbeatTimer, &QTimer::timeout, this, &ESP32VideoStream::checkHeartBeat);
-    }
-
-    if (!heartbeatTimer->isActive()) {
-        heartbeatTimer->start(50);
-    }
+    startConnectionRace();
 
+    heartbeat_enabled = true;
     return true;
 }
 
 void ESP32VideoStream::stop() {
+    if (QThread::currentThread() != thread() && thread()->isRunning()) {
+        QMetaObject::invokeMethod(this, [this]() { stop(); }, Qt::BlockingQueuedConnection);
+        return;
+    }
     LOG_DEBUG("停止WebSocket视频流");
     isRunning = false;
 
@@ -338,6 +573,10 @@ void ESP32VideoStream::stop() {
         mdnsLookup->abort();
     }
 
+    // 关闭所有仍在握手的候选连接
+    abortPendingConnections();
+    connectionEstablished = false;
+
     // 关闭WebSocket
     if (webSocket) {
         if (webSocket->state() != QAbstractSocket::UnconnectedState) {
@@ -347,36 +586,47 @@ void ESP32VideoStream::stop() {
         webSocket = nullptr;
     }
 
-    // 清空图像队列
-    QMutexLocker locker(&mutex);
-    while (!image_buffer_queue.empty()) {
-        image_buffer_queue.pop();
-    }
+    // 清空图像槽位
+    frame_slot.clear();
 }
 
 cv::Mat ESP32VideoStream::getLatestFrame() const
 {
-    QMutexLocker locker(&mutex);
-    if (image_buffer_queue.empty()) {
-        return {};
-    }
-    return image_buffer_queue.front().clone();
+    return frame_slot.copy();
 }
 
 // 修改 onConnected 方法
 void ESP32VideoStream::onConnected() {
     LOG_INFO("成功连接到 WebSocket: {}", webSocket->requestUrl().toString().toStdString());
     isRunning = true;
-    image_not_receive_count = 0;
+    // 断流检测从连接建立时开始计时，跨重连的间隔不计入帧间隔估计
+    last_frame_time = std::chrono::steady_clock::now();
+    has_previous_frame = false;
 
     // 保存成功连接的 URL
     currentStreamUrl = webSocket->requestUrl().toString().toStdString();
+
+    if (!record_directory.empty() && !recorder.isOpen()) {
+        const QString fileName = QString("%1/device_%2_%3.ptrec")
+            .arg(QString::fromStdString(record_directory))
+            .arg(device_type)
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss"));
+        recorder.open(fileName.toStdString());
+    }
+
+    // 重新连接后重新学习分辨率
+    if (configured_width == 0) {
+        learned_width = learned_height = 0;
+        dimension_mismatch_count = 0;
+        jpeg_validator.setExpectedResolution(0, 0);
+    }
 }
 
 void ESP32VideoStream::onDisconnected()
 {
     LOG_DEBUG("WebSocket连接已关闭");
     isRunning = false;
+    connectionEstablished = false;
 }
 
 void ESP32VideoStream::onError(QAbstractSocket::SocketError error) {
@@ -387,18 +637,18 @@ void ESP32VideoStream::onError(QAbstractSocket::SocketError error) {
              errorString.toStdString(),
              webSocket->requestUrl().toString().toStdString());
 
-    // 如果尚未成功运行，尝试下一个 URL
-    if (!isRunning) {
-        LOG_INFO("连接失败，尝试下一个地址");
-        tryConnectToNextAddress();
-    } else {
-        LOG_ERROR("无线连接失败，请确保设备已经开机且连接上WIFI并且和电脑处于一个路由器下");
-        isRunning = false;
-    }
+    // 候选地址的握手失败由 onCandidateError 处理，这里只处理已建立的连接
+    LOG_ERROR("无线连接失败，请确保设备已经开机且连接上WIFI并且和电脑处于一个路由器下");
+    isRunning = false;
+    connectionEstablished = false;
 }
 
 // 在 image_downloader.cpp 中添加新方法
 void ESP32VideoStream::onTextMessageReceived(const QString &message) {
+    if (recorder.isOpen()) {
+        const QByteArray utf8 = message.toUtf8();
+        recorder.append(RecordType::TEXT_MESSAGE, utf8.constData(), static_cast<std::size_t>(utf8.size()));
+    }
     try {
         // 尝试解析JSON
         QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8());
@@ -406,15 +656,15 @@ void ESP32VideoStream::onTextMessageReceived(const QString &message) {
             QJsonObject obj = doc.object();
             if (obj.contains("battery")) {
                 battery_percentage = static_cast<float>(obj["battery"].toDouble());
-                LOG_DEBUG("收到电池电量: {}%", battery_percentage);
+                LOG_DEBUG("收到电池电量: {}%", battery_percentage.load());
             }
             if (obj.contains("brightness")) {
                 brightness_value = obj["brightness"].toInt();
-                LOG_DEBUG("收到亮度值: {}", brightness_value);
+                LOG_DEBUG("收到亮度值: {}", brightness_value.load());
             }
             if (obj.contains("hardware_version")) {
                 hardware_version = obj["hardware_version"].toInt();
-                LOG_DEBUG("当前固件版本: {}", hardware_version);
+                LOG_DEBUG("当前固件版本: {}", hardware_version.load());
             }
             else
             {
@@ -428,14 +678,14 @@ void ESP32VideoStream::onTextMessageReceived(const QString &message) {
 void ESP32VideoStream::onBinaryMessageReceived(const QByteArray &message)
 {
     isRunning = true;
-    image_not_receive_count = 0;
+    // 录制原始数据，包括后面会被校验丢弃的帧
+    if (recorder.isOpen()) {
+        recorder.append(RecordType::JPEG_FRAME, message.constData(), static_cast<std::size_t>(message.size()));
+    }
     try {
         // 打印接收到的数据长度以进行调试
         LOG_DEBUG("接收到WebSocket数据: {} 字节", message.size());
         // 帧率计算
-        static std::deque<std::chrono::steady_clock::time_point> frame_timestamps;
-        static auto last_fps_log_time = std::chrono::steady_clock::now();
-
         auto current_time = std::chrono::steady_clock::now();
         frame_timestamps.push_back(current_time);
 
@@ -453,92 +703,61 @@ void ESP32VideoStream::onBinaryMessageReceived(const QByteArray &message)
                 frame_timestamps.back() - frame_timestamps.front()).count();
             float fps = (frame_timestamps.size() - 1) / duration;
 
-            LOG_DEBUG("当前WebSocket帧率: {} FPS", fps);
+            LOG_DEBUG("当前WebSocket帧率: {} FPS, 已丢弃无效帧: {}", fps, jpeg_validator.rejectedTotal());
             last_fps_log_time = current_time;
         }
 
-        // 检查数据是否足够长
-        if (message.size() < 10) {
-            LOG_WARN("接收到的数据太短，不可能是有效的图像");
+        // 解码前先做结构校验，截断或损坏的帧在这里直接丢弃
+        JpegInfo info;
+        const auto* data = reinterpret_cast<const uint8_t*>(message.constData());
+        const auto size = static_cast<std::size_t>(message.size());
+        // 分辨率变化时同一帧会校验两次，先不计数，按最终结果只统计一次
+        JpegRejectReason reason = jpeg_validator.validate(data, size, &info, false);
+        if (reason == JpegRejectReason::DIMENSION_MISMATCH && configured_width == 0 &&
+            ++dimension_mismatch_count >= 10) {
+            // 设备分辨率发生变化（例如切换了固件模式），重新学习。
+            // 校验失败时 info 不会被填写，新分辨率要等重新校验通过后才能打印
+            jpeg_validator.setExpectedResolution(0, 0);
+            learned_width = learned_height = 0;
+            reason = jpeg_validator.validate(data, size, &info, false);
+            if (reason == JpegRejectReason::NONE) {
+                LOG_INFO("图像分辨率已变化，重新学习: {}x{}", info.width, info.height);
+            }
+        }
+        jpeg_validator.record(reason);
+        if (reason != JpegRejectReason::NONE) {
+            LOG_DEBUG("丢弃无效图像帧: {} ({} 字节)", jpegRejectReasonName(reason), message.size());
             return;
         }
+        dimension_mismatch_count = 0;
+
+        // 只使用OpenCV一个解码器，直接在接收缓冲区上解码，避免额外拷贝
+        const cv::Mat encoded(1, static_cast<int>(message.size()), CV_8UC1, const_cast<char*>(message.constData()));
+        cv::Mat rawFrame = cv::imdecode(encoded, cv::IMREAD_COLOR);
+        if (rawFrame.empty()) {
+            jpeg_validator.reject(JpegRejectReason::DECODE_FAILED);
+            LOG_WARN("无法解码接收到的图像数据");
+            return;
+        }
+        LOG_DEBUG("成功解码图像，尺寸: {}x{}", rawFrame.cols, rawFrame.rows);
 
-        // 直接使用OpenCV解码数据 - 模仿HTML测试页面的处理方式
-        std::vector<uchar> buffer(message.begin(), message.end());
-        cv::Mat rawFrame = cv::imdecode(buffer, cv::IMREAD_COLOR);
-
-        if (!rawFrame.empty()) {
-            LOG_DEBUG("成功解码图像，尺寸: {}x{}", rawFrame.cols, rawFrame.rows);
-
-            QMutexLocker locker(&mutex);
-            if (image_buffer_queue.empty()) {
-                image_buffer_queue.push(std::move(rawFrame));
-            } else {
-                image_buffer_queue.pop();
-                image_buffer_queue.push(std::move(rawFrame));
-            }
-        } else {
-            // 如果OpenCV解码失败，尝试Qt的方法
-            QImage image;
-            if (image.loadFromData(message, "JPEG")) {
-                LOG_DEBUG("Qt成功解码JPEG图像");
-                cv::Mat frame = QImageToCvMat(image);
-
-                if (!frame.empty()) {
-                    QMutexLocker locker(&mutex);
-                    image_not_receive_count = 0;
-                    if (image_buffer_queue.empty()) {
-                        image_buffer_queue.push(std::move(frame));
-                    } else {
-                        image_buffer_queue.pop();
-                        image_buffer_queue.push(std::move(frame));
-                    }
-                }
-            } else {
-                // 如果Qt也失败，记录数据头部信息
-                LOG_WARN("无法解码接收到的图像数据");
-                //LOG_DEBUG("数据前16字节: " + bytesToHexString(message.left(16)));
-
-                // 尝试检测数据类型
-                if (message.size() > 4) {
-                    uint32_t magic = 0;
-                    memcpy(&magic, message.data(), 4);
-                    LOG_DEBUG("数据前4字节魔数: 0x{}", QString::number(magic, 16).toStdString());
-                }
-            }
+        if (configured_width == 0 && learned_width == 0) {
+            learned_width = rawFrame.cols;
+            learned_height = rawFrame.rows;
+            jpeg_validator.setExpectedResolution(learned_width, learned_height);
         }
 
+        frame_slot.publish(std::move(rawFrame));
+        onFrameArrived();
     } catch (const std::exception& e) {
         LOG_ERROR("处理WebSocket消息时出错: {}", e.what());
     }
 }
 
-cv::Mat ESP32VideoStream::QImageToCvMat(const QImage &image) const
+void ESP32VideoStream::setExpectedResolution(int width, int height)
 {
-    switch (image.format()) {
-    case QImage::Format_RGB888: {
-        cv::Mat mat(image.height(), image.width(), CV_8UC3,
-                   const_cast<uchar*>(image.bits()), image.bytesPerLine());
-        cv::Mat result;
-        cv::cvtColor(mat, result, cv::COLOR_RGB2BGR);
-        return result;
-    }
-    case QImage::Format_ARGB32:
-    case QImage::Format_ARGB32_Premultiplied: {
-        cv::Mat mat(image.height(), image.width(), CV_8UC4,
-                   const_cast<uchar*>(image.bits()), image.bytesPerLine());
-        cv::Mat result;
-        cv::cvtColor(mat, result, cv::COLOR_RGBA2BGR);
-        return result;
-    }
-    default: {
-        // 对于其他格式，转换为RGB888再处理
-        QImage converted = image.convertToFormat(QImage::Format_RGB888);
-        cv::Mat mat(converted.height(), converted.width(), CV_8UC3,
-                   const_cast<uchar*>(converted.bits()), converted.bytesPerLine());
-        cv::Mat result;
-        cv::cvtColor(mat, result, cv::COLOR_RGB2BGR);
-        return result;
-    }
-    }
-}
\ No newline at end of file
+    configured_width = width;
+    configured_height = height;
+    learned_width = learned_height = 0;
+    jpeg_validator.setExpectedResolution(width, height);
+}
@@ -0,0 +1,104 @@
+// device_discovery.hpp - 串口设备发现与热插拔通知，Windows 和 Linux 共用同一接口
+#ifndef DEVICE_DISCOVERY_HPP
+#define DEVICE_DISCOVERY_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+
+struct SerialDeviceInfo {
+    std::string port;         // Windows 下为 COMx，Linux 下为 /dev/ttyACMx
+    uint16_t vendor_id = 0;   // 非 USB 串口为 0
+    uint16_t product_id = 0;
+    int interface_number = -1; // USB 复合设备的接口号，未知时为 -1
+    std::string description;
+
+    bool operator==(const SerialDeviceInfo& other) const {
+        return port == other.port && vendor_id == other.vendor_id && product_id == other.product_id &&
+               interface_number == other.interface_number;
+    }
+};
+
+struct SerialDeviceEvent {
+    enum Type {
+        ATTACHED,  // 设备接入
+        DETACHED,  // 设备拔出
+        ENUMERATED // 订阅时的现有设备已全部通知完毕，之后只有热插拔事件
+    };
+    Type type;
+    SerialDeviceInfo device;
+};
+
+// 平台相关的部分：枚举当前串口，设备变化时调用 onChanged
+class DeviceDiscoveryBackend {
+public:
+    virtual ~DeviceDiscoveryBackend() = default;
+    virtual std::vector<SerialDeviceInfo> scan() = 0;
+    // 在发现线程上调用，之后的通知也必须在发现线程上发出
+    virtual bool startMonitoring(std::function<void()> onChanged) = 0;
+    virtual void stopMonitoring() = 0;
+};
+
+// 由各平台的实现文件提供，不支持的平台返回空
+std::unique_ptr<DeviceDiscoveryBackend> createDeviceDiscoveryBackend();
+
+// 在独立线程上枚举串口并监听热插拔，把接入/拔出事件推送给订阅者。
+// 热插拔通知只触发一次重新扫描，与上次结果比较后得出事件，避免依赖各平台通知的细节
+class DeviceDiscovery {
+public:
+    using Callback = std::function<void(const SerialDeviceEvent&)>;
+
+    static DeviceDiscovery& instance();
+
+    // 回调通过 context 所在线程的事件循环调用。订阅后先收到现有设备的 ATTACHED
+    // 和一个 ENUMERATED，之后是热插拔事件。context 销毁前必须调用 unsubscribe
+    int subscribe(QObject* context, Callback callback);
+    void unsubscribe(int id);
+
+    // 最近一次扫描结果的快照，首次扫描完成前为空
+    std::vector<SerialDeviceInfo> devices() const;
+
+    DeviceDiscovery(const DeviceDiscovery&) = delete;
+    DeviceDiscovery& operator=(const DeviceDiscovery&) = delete;
+
+private:
+    DeviceDiscovery();
+    ~DeviceDiscovery();
+    void shutdown();
+
+    struct Listener {
+        int id;
+        QObject* context;
+        Callback callback;
+        // 现有设备通知完毕之前不接收增量事件，避免重复
+        bool primed = false;
+    };
+
+    // 以下在发现线程上执行
+    void startOnThread();
+    void stopOnThread();
+    void rescan();
+    void prime(int id);
+    void post(const Listener& listener, const SerialDeviceEvent& event);
+
+    // 同一次插拔通常有多条通知（USB 设备、接口、tty 节点），合并后再扫描
+    static constexpr int RESCAN_DELAY_MS = 200;
+
+    QThread discovery_thread;
+    std::unique_ptr<DeviceDiscoveryBackend> backend;
+    // 属于发现线程，同时作为投递到发现线程的上下文对象
+    QTimer* rescan_timer = nullptr;
+
+    mutable std::mutex mutex;
+    std::vector<SerialDeviceInfo> current_devices;
+    std::vector<Listener> listeners;
+    int next_listener_id = 1;
+};
+
+#endif // DEVICE_DISCOVERY_HPP
@@ -0,0 +1,49 @@
+// frame_slot.hpp - 最新帧槽位，传输线程写入，推理/预览线程读取
+#ifndef FRAME_SLOT_HPP
+#define FRAME_SLOT_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <opencv2/core.hpp>
+
+// 只保留最新的一帧，每次发布递增序号，读者可以据此判断是否有新帧
+class FrameSlot {
+public:
+    void publish(cv::Mat frame) {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest = std::move(frame);
+        ++seq;
+    }
+
+    // 返回共享同一块像素数据的浅拷贝，调用方不能原地修改
+    cv::Mat peek(uint64_t* sequence = nullptr) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sequence) {
+            *sequence = seq;
+        }
+        return latest;
+    }
+
+    // 返回深拷贝，调用方可以随意修改
+    cv::Mat copy(uint64_t* sequence = nullptr) const {
+        cv::Mat frame = peek(sequence);
+        return frame.empty() ? cv::Mat() : frame.clone();
+    }
+
+    uint64_t sequence() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return seq;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest.release();
+    }
+
+private:
+    mutable std::mutex mutex;
+    cv::Mat latest;
+    uint64_t seq = 0;
+};
+
+#endif // FRAME_SLOT_HPP
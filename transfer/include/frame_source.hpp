@@ -0,0 +1,29 @@
+// frame_source.hpp - 图像来源的公共接口，真实设备流和录制回放都实现它
+#ifndef FRAME_SOURCE_HPP
+#define FRAME_SOURCE_HPP
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+
+    // 获取最新帧的深拷贝
+    virtual cv::Mat getLatestFrame() const = 0;
+    // 获取最新帧和它的序号，返回的帧与来源共享像素数据，调用方不能原地修改
+    virtual cv::Mat peekLatestFrame(uint64_t* sequence) const = 0;
+    // 最新帧的序号，每产生一帧递增
+    virtual uint64_t getFrameSequence() const = 0;
+    virtual bool isStreaming() const = 0;
+
+    // 设备上报的状态
+    virtual float getBatteryPercentage() const = 0;
+    virtual int getBrightnessValue() const = 0;
+    virtual int getHardwareVersion() const = 0;
+};
+
+#endif // FRAME_SOURCE_HPP
@@ -4,13 +4,18 @@
 #include <vector>
 #include <thread>
 #include <atomic>
-#include <queue>
+#include <chrono>
+#include <deque>
 #include <opencv2/core.hpp>
 #include <QWebSocket>
 #include <QObject>
 #include <QMutex>
 #include <QTimer>
 #include "http_server.hpp"  // 添加这一行
+#include "frame_slot.hpp"
+#include "frame_source.hpp"
+#include "jpeg_validator.hpp"
+#include "stream_recording.hpp"
 #include "logger.hpp"
 #include <QDnsLookup>
 #define DEVICE_TYPE_UNKNOWN 0
@@ -18,7 +23,18 @@
 #define DEVICE_TYPE_LEFT_EYE 2
 #define DEVICE_TYPE_RIGHT_EYE 3
 
-class ESP32VideoStream : public QObject {
+// 视频流连接质量统计
+struct StreamMetrics {
+    uint64_t stall_count = 0;              // 检测到的断流次数
+    uint64_t reconnect_count = 0;          // 断流后成功恢复的次数
+    float last_reconnect_ms = 0.0f;        // 最近一次从检测到断流到收到新帧的耗时
+    float expected_frame_interval_ms = 0.0f; // 当前估计的帧间隔
+    int consecutive_failures = 0;          // 连续重连失败次数
+};
+
+// 视频流对象运行在 StreamHub 的网络线程上，请通过 StreamHub::createStream() 创建。
+// init/start/stop 可以在任意线程调用，会同步转发到网络线程执行
+class ESP32VideoStream : public QObject, public FrameSource {
 public:
     // 构造函数和析构函数
     explicit ESP32VideoStream(QObject *parent = nullptr);
@@ -28,39 +44,53 @@ public:
     bool init(const std::string& url, int deviceType = DEVICE_TYPE_UNKNOWN);
 
     // 开始接收视频流
-    bool start();
-    float getBatteryPercentage() const { return battery_percentage; }
-    int getBrightnessValue() const { return brightness_value; }
-    int getHardwareVersion() const {return hardware_version;}
+    bool start() override;
+    float getBatteryPercentage() const override { return battery_percentage; }
+    int getBrightnessValue() const override { return brightness_value; }
+    int getHardwareVersion() const override {return hardware_version;}
     // 停止视频流
-    void stop();
+    void stop() override;
 
     // 获取最新的帧
-    cv::Mat getLatestFrame() const;
+    cv::Mat getLatestFrame() const override;
+    cv::Mat peekLatestFrame(uint64_t* sequence) const override { return frame_slot.peek(sequence); }
+
+    // 最新帧的序号，每收到一帧递增
+    uint64_t getFrameSequence() const override { return frame_slot.sequence(); }
 
     // 检查流是否正在运行
-    bool isStreaming() const { return isRunning; }
+    bool isStreaming() const override { return isRunning; }
+
+    // 把设备发来的原始消息（JPEG 和文本）连同接收时间录制到文件，可用 ReplayStream 回放
+    bool startRecording(const std::string& path) { return recorder.open(path); }
+    void stopRecording() { recorder.close(); }
+    bool isRecording() const { return recorder.isOpen(); }
+
+    // 设置后每次连接成功都会在该目录下自动开始录制
+    void setRecordDirectory(const std::string& directory) { record_directory = directory; }
+
+    // 设置期望的摄像头分辨率，不设置时以连接后第一帧的分辨率为准
+    void setExpectedResolution(int width, int height);
+
+    // 断流检测与重连统计
+    StreamMetrics getMetrics() const;
 
+    // 各原因被拒绝的帧数统计
+    const JpegValidator& frameValidator() const { return jpeg_validator; }
+
+    // 心跳检查由 StreamHub 的统一定时器驱动，这里只控制是否参与检查
     void stop_heartbeat_timer()
     {
-        if (heartbeatTimer && heartbeatTimer->isActive())
-        {
-            heartbeatTimer->stop();
-        }
+        heartbeat_enabled = false;
     }
 
     void start_heartbeat_timer()
     {
-        if (!heartbeatTimer)
-        {
-            heartbeatTimer = new QTimer();
-        }
-        if (!heartbeatTimer->isActive())
-        {
-            heartbeatTimer->start(50);
-        }
+        heartbeat_enabled = true;
     }
 
+    bool heartbeatEnabled() const { return heartbeat_enabled; }
+
 private slots:
     // WebSocket连接成功的槽函数
     void onConnected();
@@ -74,40 +104,89 @@ private slots:
     // 处理接收到的二进制消息(JPEG图片)
     void onBinaryMessageReceived(const QByteArray &message);
     void onTextMessageReceived(const QString &message);
+
+private:
+    friend class StreamHub;
+    // 由 StreamHub 在网络线程上周期调用
     void checkHeartBeat();
+    // 断开当前连接并立即重新发起连接竞速（上次成功的地址最先启动）
+    void reconnect();
+    // 带随机抖动的指数退避时间
+    int nextBackoffMs();
+    // 更新帧间隔估计，断流恢复时记录重连耗时
+    void onFrameArrived();
 
 private:
-    // 将QImage转换为cv::Mat
-    cv::Mat QImageToCvMat(const QImage &image) const;
     // 添加以下成员变量
     QDnsLookup* mdnsLookup = nullptr;
     bool using_mdns = false;
 
-    // 添加连接尝试计数器
-    int connection_attempts = 0;
-    static const int MAX_CONNECTION_ATTEMPTS = 3;
+    // 所有候选地址同时发起连接（错开启动），第一个完成握手的胜出，其余立即关闭
+    static constexpr int CONNECTION_STAGGER_MS = 250;
+    static constexpr int CONNECTION_TIMEOUT_MS = 3000;
     QMap<QWebSocket*, QString> pendingConnections;
     QTimer* connectionTimeoutTimer = nullptr;
     bool connectionEstablished = false;
-    // 新增加的方法
-    void tryConnectToNextAddress();
+    bool race_active = false;
+    // 每次重新发起连接时递增，用来丢弃上一轮尚未触发的延迟启动
+    int race_generation = 0;
+    int race_launched = 0;
+    void startConnectionRace();
+    void launchCandidate(const QString& url);
+    void onCandidateConnected(QWebSocket* socket);
+    void onCandidateError(QWebSocket* socket, QAbstractSocket::SocketError error);
+    void abortPendingConnections();
     void setupMdnsLookup(const QString& hostname);
 
+    // 上次连接成功的地址缓存，下次启动时最先尝试
+    std::string cache_key;
+    std::string loadCachedUrl() const;
+    void saveCachedUrl(const std::string& url) const;
+
     // 存储多个候选 URL
     QStringList connection_urls;
-    // 辅助函数：将字节数组转换为十六进制字符串（用于调试）
-    std::string bytesToHexString(const QByteArray &bytes) const;
 
     // 成员变量
     std::atomic<bool> isRunning;
     std::string currentStreamUrl;
     QWebSocket* webSocket;
-    mutable QMutex mutex;
-    std::queue<cv::Mat> image_buffer_queue;
+    FrameSlot frame_slot;
     // 已有的成员...
-    float battery_percentage = 0.0f;
-    int brightness_value = 0;
-    int hardware_version = 0;
-    int image_not_receive_count = 0;
-    QTimer* heartbeatTimer;
+    std::atomic<float> battery_percentage = 0.0f;
+    std::atomic<int> brightness_value = 0;
+    std::atomic<int> hardware_version = 0;
+    std::atomic<bool> heartbeat_enabled = false;
+
+    // 断流检测：超过估计帧间隔的 STALL_INTERVAL_FACTOR 倍没有收到帧即认为断流
+    static constexpr float STALL_INTERVAL_FACTOR = 4.0f;
+    static constexpr float FRAME_INTERVAL_ALPHA = 0.1f;
+    static constexpr int MIN_STALL_TIMEOUT_MS = 250;
+    static constexpr int INITIAL_STALL_TIMEOUT_MS = 1500; // 还没有帧间隔估计时使用
+    static constexpr int RECONNECT_BACKOFF_BASE_MS = 200;
+    static constexpr int RECONNECT_BACKOFF_MAX_MS = 5000;
+    std::chrono::steady_clock::time_point last_frame_time;
+    std::chrono::steady_clock::time_point stall_detected_time;
+    std::chrono::steady_clock::time_point next_reconnect_time;
+    bool has_previous_frame = false;
+    bool recovering = false;
+    std::atomic<float> frame_interval_ms = 0.0f;
+    std::atomic<uint64_t> stall_count = 0;
+    std::atomic<uint64_t> reconnect_count = 0;
+    std::atomic<float> last_reconnect_ms = 0.0f;
+    std::atomic<int> consecutive_failures = 0;
+
+    // 帧率统计
+    std::deque<std::chrono::steady_clock::time_point> frame_timestamps;
+    std::chrono::steady_clock::time_point last_fps_log_time = std::chrono::steady_clock::now();
+
+    JpegValidator jpeg_validator;
+    StreamRecorder recorder;
+    std::string record_directory;
+    int device_type = DEVICE_TYPE_UNKNOWN;
+    // 用户指定的分辨率；为0时使用连接后学习到的分辨率
+    int configured_width = 0;
+    int configured_height = 0;
+    int learned_width = 0;
+    int learned_height = 0;
+    int dimension_mismatch_count = 0;
 };
\ No newline at end of file
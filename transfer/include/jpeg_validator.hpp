@@ -0,0 +1,60 @@
+// jpeg_validator.hpp - JPEG结构预校验，在解码前快速丢弃损坏帧
+#ifndef JPEG_VALIDATOR_HPP
+#define JPEG_VALIDATOR_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 帧被拒绝的原因
+enum class JpegRejectReason : uint8_t {
+    NONE = 0,
+    TOO_SHORT,          // 数据长度不足以构成JPEG
+    MISSING_SOI,        // 缺少 FFD8 起始标记
+    BAD_MARKER,         // 段标记不以 0xFF 开头或出现非法标记
+    BAD_SEGMENT_LENGTH, // 段长度非法或越界（截断帧）
+    MISSING_SOF,        // SOS 之前没有帧头
+    DIMENSION_MISMATCH, // 分辨率与期望的摄像头分辨率不符
+    MISSING_EOI,        // 缺少 FFD9 结束标记（截断帧）
+    DECODE_FAILED,      // 结构正确但解码器解码失败
+    COUNT
+};
+
+const char* jpegRejectReasonName(JpegRejectReason reason);
+
+struct JpegInfo {
+    int width = 0;
+    int height = 0;
+};
+
+class JpegValidator {
+public:
+    static constexpr std::size_t REASON_COUNT = static_cast<std::size_t>(JpegRejectReason::COUNT);
+
+    // 设置期望的分辨率，任意一项为0时不检查分辨率
+    void setExpectedResolution(int width, int height);
+
+    // 只解析段结构，不做熵解码；校验失败时累加对应原因的计数。
+    // count 为 false 时不计数，同一帧需要校验多次时由调用方在得出最终结果后调用 record()
+    JpegRejectReason validate(const uint8_t* data, std::size_t size, JpegInfo* info = nullptr, bool count = true);
+
+    // 记入一次校验结果，NONE 计为通过
+    void record(JpegRejectReason reason);
+
+    // 解码失败等外部原因也记入统计
+    void reject(JpegRejectReason reason);
+
+    uint64_t acceptedCount() const { return accepted.load(std::memory_order_relaxed); }
+    uint64_t rejectedCount(JpegRejectReason reason) const;
+    uint64_t rejectedTotal() const;
+    void resetCounters();
+
+private:
+    std::atomic<int> expected_width{0};
+    std::atomic<int> expected_height{0};
+    std::atomic<uint64_t> accepted{0};
+    std::array<std::atomic<uint64_t>, REASON_COUNT> rejected{};
+};
+
+#endif // JPEG_VALIDATOR_HPP
@@ -5,7 +5,11 @@
 #ifndef OSC_HPP
 #define OSC_HPP
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 #include <mutex>
@@ -14,30 +18,167 @@
 
 // 前向声明oscpack类
 
+// OSC 发送方式。并非所有接收端都支持 #bundle，默认仍然逐条发送
+struct OscSendOptions {
+    // 把一次 sendModelOutput 的所有参数打包成 bundle 发送
+    bool use_bundle = false;
+    // 单个 UDP 包的上限，超出时拆成多个 bundle，避免 IP 分片
+    std::size_t max_packet_size = 1400;
+    // false: 立即执行的 timetag；true: 同一帧的所有 bundle 使用相同的发送时刻
+    bool frame_timetag = false;
+    // 与上次发送值相差不超过 epsilon 的参数不再发送，负数表示关闭死区
+    float default_epsilon = 0.001f;
+    // 每隔这么久发送一次全部参数，让后加入或丢包的接收端也能收敛
+    int keyframe_interval_ms = 1000;
+    // 推理结果到达即发送，这里只是每秒发送次数的上限，0 表示不限制
+    int max_send_rate = 66;
+};
+
+// 一个 OSC 接收端。同一帧的数据只编码一次，再按各自的前缀和参数子集发给每个接收端
+struct OscDestination {
+    std::string address = "127.0.0.1";
+    int port = 9000;
+    std::string prefix;
+    // 只发送这些参数（不含前缀），为空时发送全部
+    std::vector<std::string> parameters;
+};
+
+// 一帧眼追输出，按 v2 参数的顺序排列。默认值为双眼居中、0.75 开度
+struct EyeOutputFrame {
+    float lid_left = 0.75f;
+    float x_left = 0.0f;
+    float y_left = 0.0f;
+    float lid_right = 0.75f;
+    float x_right = 0.0f;
+    float y_right = 0.0f;
+    float pupil_dilation = 0.5f;
+
+    static constexpr std::size_t SIZE = 7;
+    // 与 toValues 的顺序一一对应的 OSC 地址
+    static const std::vector<std::string>& parameterNames();
+    // 写入 values（大小调整为 SIZE），容量足够时不分配内存
+    void toValues(std::vector<float>& values) const;
+    // values 不足 SIZE 个时缺少的字段保持默认值
+    static EyeOutputFrame fromValues(const std::vector<float>& values);
+};
+
+struct OscSendStats {
+    uint64_t messages_sent = 0;
+    uint64_t messages_suppressed = 0; // 落在死区内未发送的参数
+    uint64_t packets_sent = 0;
+    uint64_t keyframes = 0;
+    uint64_t batch_calls = 0;         // 发送整帧数据包的系统调用次数（sendmmsg）
+};
+
 class OscManager {
 public:
     OscManager();
     ~OscManager();
 
-    // 初始化OSC管理器
+    // 初始化OSC管理器，address:port 为主接收端，之后追加默认的转发接收端
     bool init(const std::string& address = "127.0.0.1", int port = 8888);
 
-    // 设置OSC前缀
+    // 设置主接收端的OSC前缀
     void setLocationPrefix(const std::string& prefix);
 
+    // 追加一个接收端，init 之后调用
+    bool addDestination(const OscDestination& destination);
+    // 之后 init 的 OscManager 都会追加这些接收端，由命令行参数设置
+    static void addDefaultDestination(const OscDestination& destination);
+
+    // 之后创建的 OscManager 使用的发送方式，由命令行参数设置
+    static void setDefaultSendOptions(const OscSendOptions& options);
+    void setSendOptions(const OscSendOptions& options);
+    OscSendOptions sendOptions();
+
+    // 单独设置某个参数（不含前缀）的死区，未设置的参数使用 default_epsilon
+    void setParameterEpsilon(const std::string& name, float epsilon);
+
     // 发送模型输出
     bool sendModelOutput(const std::vector<float>& output, const std::vector<std::string>& blend_shapes);
+    // 发送一帧眼追输出，使用预先编码好的 v2 参数模板，一次加锁发出
+    bool sendEyeFrame(const EyeOutputFrame& frame);
+
+    OscSendStats getStats() const;
 
     // 关闭连接
     void close();
 
 private:
+    // 一组参数预先编码好的 OSC 消息。地址、补齐和类型标签只在前缀、参数列表或
+    // 发送方式变化时生成一次，发送时只填入大端 float 值
+    struct CompiledParameters {
+        struct Element {
+            std::size_t source_index; // 在调用方参数列表中的位置
+            std::size_t offset;
+            std::size_t size;         // bundle 模式下包含 4 字节的长度前缀
+            std::size_t value_offset; // float 在 bytes 中的位置
+        };
+        std::vector<std::string> names;
+        std::vector<char> bytes;
+        std::vector<Element> elements;
+        std::vector<float> epsilons;
+        std::vector<float> last_sent; // 初始为 NaN，保证第一帧全部发送
+        std::chrono::steady_clock::time_point last_keyframe;
+    };
+
+    struct Destination {
+        OscDestination config;
+        std::unique_ptr<UdpTransmitSocket> socket;
+        uint32_t ip = 0; // 主机字节序，供批量发送使用
+        std::vector<CompiledParameters> compiled;
+    };
+
+    // 本帧待发送的一个数据包。data 为空时内容位于 batch_buffer_ 的 offset 处
+    struct Datagram {
+        const Destination* destination;
+        const char* data;
+        std::size_t offset;
+        std::size_t size;
+    };
+
+    bool sendLocked(const std::vector<float>& output, const std::vector<std::string>& blend_shapes);
+    bool addDestinationLocked(const OscDestination& destination);
+    CompiledParameters& compiledFor(Destination& destination, const std::vector<std::string>& blend_shapes, std::size_t count);
+    void compile(const Destination& destination, CompiledParameters& compiled) const;
+    void encodeFor(Destination& destination, const std::vector<float>& output, const std::vector<std::string>& blend_shapes,
+                   std::size_t count, std::chrono::steady_clock::time_point now, uint64_t time_tag);
+    void queueElement(const Destination& destination, const CompiledParameters& compiled,
+                      const CompiledParameters::Element& element, uint64_t time_tag);
+    void closeBundle(const Destination& destination);
+    void flushBatch();
+    static uint64_t currentTimeTag();
+
+    // 调用方的参数列表是固定的几组，超过上限时丢弃最早的模板
+    static constexpr std::size_t MAX_COMPILED_SETS = 8;
+    static constexpr std::size_t BUNDLE_HEADER_SIZE = 16;
+    static constexpr std::size_t NO_BUNDLE = static_cast<std::size_t>(-1);
+
     std::string address_;
     int port_;
     std::string location_prefix_;
     float multiplier_;
-    std::unique_ptr<UdpTransmitSocket> socket_;
+    float max_clip_value_;
+    std::vector<std::unique_ptr<Destination>> destinations_;
     std::mutex mutex_;
+    OscSendOptions options_;
+    std::unordered_map<std::string, float> parameter_epsilons_;
+    // sendEyeFrame 展开后的数值，在帧之间复用
+    std::vector<float> eye_frame_values_;
+
+    // 本帧所有接收端的数据包，编码完成后一次发出。容量在帧之间复用
+    std::vector<Datagram> batch_;
+    // bundle 模式下拼装的数据包内容
+    std::vector<char> batch_buffer_;
+    std::size_t open_bundle_ = NO_BUNDLE;
+    // Linux 下用 sendmmsg 一次发出整帧的数据包，其他平台逐个发送
+    int batch_socket_ = -1;
+
+    std::atomic<uint64_t> messages_sent_ = 0;
+    std::atomic<uint64_t> messages_suppressed_ = 0;
+    std::atomic<uint64_t> packets_sent_ = 0;
+    std::atomic<uint64_t> keyframes_ = 0;
+    std::atomic<uint64_t> batch_calls_ = 0;
 };
 
 
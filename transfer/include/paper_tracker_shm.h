@@ -0,0 +1,263 @@
+/* paper_tracker_shm.h - 同机程序读取追踪结果的共享内存布局和 C 读取接口 */
+#ifndef PAPER_TRACKER_SHM_H
+#define PAPER_TRACKER_SHM_H
+
+/*
+ * PaperTracker 启动时加上 --shared-memory 后会创建该共享内存，每次输出面捕或眼追结果时
+ * 写入环形缓冲区的下一格。读取方不需要链接任何库，包含本头文件即可：
+ *
+ *     pt_shm_reader reader;
+ *     pt_shm_names names = {0};
+ *     if (pt_shm_open(&reader) == PT_SHM_OK) {
+ *         pt_shm_frame frame;
+ *         if (pt_shm_read_latest(&reader, &frame) == PT_SHM_OK) {
+ *             if (frame.names_version != names.version) {
+ *                 pt_shm_read_names(&reader, &names);
+ *             }
+ *             ... names.face[i] = frame.face[i] ...
+ *         }
+ *         pt_shm_close(&reader);
+ *     }
+ *
+ * 每一格和参数名表各用一个 seqlock 保护：写入期间 seq 为奇数，写完后为偶数。读取方在拷贝前后
+ * 各读一次 seq，两次相同且为偶数时数据才完整，否则重试，重试 PT_SHM_MAX_RETRIES 次仍失败时
+ * 返回 PT_SHM_ERR_BUSY，由调用方决定稍后再读。写入方从不等待读取方。
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PT_SHM_MAGIC 0x48535450u /* "PTSH" */
+#define PT_SHM_VERSION 2u
+#ifdef _WIN32
+#define PT_SHM_NAME "Local\\PaperTrackerOutput"
+#else
+#define PT_SHM_NAME "/paper_tracker_output"
+#endif
+
+#define PT_SHM_RING_SIZE 8
+#define PT_SHM_MAX_FACE 64
+#define PT_SHM_MAX_EYE 16
+#define PT_SHM_NAME_LENGTH 64
+/* 读取时 seqlock 校验失败的最多重试次数，正常情况下写入方在几微秒内写完 */
+#define PT_SHM_MAX_RETRIES 64
+
+/* 返回值 */
+#define PT_SHM_OK 0
+#define PT_SHM_ERR_UNAVAILABLE (-1) /* PaperTracker 未运行、未开启共享内存或还没有任何输出 */
+#define PT_SHM_ERR_VERSION (-2)     /* 布局版本不匹配 */
+#define PT_SHM_ERR_BUSY (-3)        /* 重试次数用完仍在被写入，稍后再读 */
+
+/* 一帧输出。未连接的设备对应的 count 为 0 */
+typedef struct pt_shm_frame {
+    uint64_t frame_id;     /* 从 1 开始递增 */
+    uint64_t timestamp_us; /* 单调时钟：Linux 为 CLOCK_MONOTONIC，Windows 为 QueryPerformanceCounter */
+    uint32_t face_count;
+    uint32_t eye_count;
+    uint32_t names_version; /* 写入这一帧时参数名表的版本，与 pt_shm_names.version 比较 */
+    uint32_t reserved;
+    float face[PT_SHM_MAX_FACE]; /* 顺序与 face_names 一致 */
+    float eye[PT_SHM_MAX_EYE];   /* 顺序与 eye_names 一致 */
+} pt_shm_frame;
+
+typedef struct pt_shm_slot {
+    uint32_t seq;
+    uint32_t reserved;
+    pt_shm_frame frame;
+} pt_shm_slot;
+
+typedef struct pt_shm_layout {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ring_size;
+    uint32_t frame_size;
+    uint64_t latest_frame_id; /* 最近写完的一帧，位于 slots[latest_frame_id % ring_size] */
+    /* 参数名表的 seqlock，同时作为版本号：每次更新加 2 */
+    uint32_t names_seq;
+    uint32_t names_reserved;
+    /* 参数名，顺序变化时更新，以 \0 结尾 */
+    char face_names[PT_SHM_MAX_FACE][PT_SHM_NAME_LENGTH];
+    char eye_names[PT_SHM_MAX_EYE][PT_SHM_NAME_LENGTH];
+    pt_shm_slot slots[PT_SHM_RING_SIZE];
+} pt_shm_layout;
+
+/* 参数名表的一份拷贝 */
+typedef struct pt_shm_names {
+    uint32_t version; /* 0 表示还没有读取过 */
+    char face[PT_SHM_MAX_FACE][PT_SHM_NAME_LENGTH];
+    char eye[PT_SHM_MAX_EYE][PT_SHM_NAME_LENGTH];
+} pt_shm_names;
+
+typedef struct pt_shm_reader {
+    const pt_shm_layout* layout;
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+} pt_shm_reader;
+
+/* 共享字段的 acquire 读取，写入方对应地使用 release 写入 */
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static inline uint32_t pt_shm_load_u32(const uint32_t* p)
+{
+    const uint32_t value = *(const volatile uint32_t*)p;
+    _ReadWriteBarrier();
+    return value;
+}
+static inline uint64_t pt_shm_load_u64(const uint64_t* p)
+{
+    const uint64_t value = *(const volatile uint64_t*)p;
+    _ReadWriteBarrier();
+    return value;
+}
+#define PT_SHM_FENCE_ACQUIRE() _ReadWriteBarrier()
+#else
+static inline uint32_t pt_shm_load_u32(const uint32_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static inline uint64_t pt_shm_load_u64(const uint64_t* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+#define PT_SHM_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+/* 成功返回 PT_SHM_OK，未运行或未开启共享内存时返回 PT_SHM_ERR_UNAVAILABLE，
+ * 版本不匹配返回 PT_SHM_ERR_VERSION（仍需 pt_shm_close） */
+static inline int pt_shm_open(pt_shm_reader* reader)
+{
+    const pt_shm_layout* layout;
+    reader->layout = NULL;
+#ifdef _WIN32
+    reader->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, PT_SHM_NAME);
+    if (!reader->mapping) {
+        return PT_SHM_ERR_UNAVAILABLE;
+    }
+    layout = (const pt_shm_layout*)MapViewOfFile(reader->mapping, FILE_MAP_READ, 0, 0, sizeof(pt_shm_layout));
+    if (!layout) {
+        CloseHandle(reader->mapping);
+        reader->mapping = NULL;
+        return PT_SHM_ERR_UNAVAILABLE;
+    }
+#else
+    int fd = shm_open(PT_SHM_NAME, O_RDONLY, 0);
+    if (fd < 0) {
+        return PT_SHM_ERR_UNAVAILABLE;
+    }
+    layout = (const pt_shm_layout*)mmap(NULL, sizeof(pt_shm_layout), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (layout == (const pt_shm_layout*)MAP_FAILED) {
+        return PT_SHM_ERR_UNAVAILABLE;
+    }
+#endif
+    reader->layout = layout;
+    if (layout->magic != PT_SHM_MAGIC || layout->version != PT_SHM_VERSION ||
+        layout->frame_size != sizeof(pt_shm_frame)) {
+        return PT_SHM_ERR_VERSION;
+    }
+    return PT_SHM_OK;
+}
+
+static inline void pt_shm_close(pt_shm_reader* reader)
+{
+    if (!reader->layout) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(reader->layout);
+    CloseHandle(reader->mapping);
+    reader->mapping = NULL;
+#else
+    munmap((void*)reader->layout, sizeof(pt_shm_layout));
+#endif
+    reader->layout = NULL;
+}
+
+static inline uint64_t pt_shm_latest_frame_id(const pt_shm_reader* reader)
+{
+    return pt_shm_load_u64(&reader->layout->latest_frame_id);
+}
+
+/*
+ * 不拷贝直接读取某一格：begin 返回当时的 seq（奇数表示正在写入，应稍后重试），
+ * 读完后用 end 检查 seq 是否仍相同，不同说明读取期间被覆盖，读到的数据要丢弃
+ */
+static inline uint32_t pt_shm_begin_read(const pt_shm_slot* slot)
+{
+    return pt_shm_load_u32(&slot->seq);
+}
+
+static inline int pt_shm_end_read(const pt_shm_slot* slot, uint32_t seq)
+{
+    PT_SHM_FENCE_ACQUIRE();
+    return (seq & 1u) == 0 && pt_shm_load_u32(&slot->seq) == seq;
+}
+
+/* 把最新一帧拷贝到 out。成功返回 PT_SHM_OK，还没有任何输出时返回 PT_SHM_ERR_UNAVAILABLE */
+static inline int pt_shm_read_latest(const pt_shm_reader* reader, pt_shm_frame* out)
+{
+    int attempt;
+    for (attempt = 0; attempt < PT_SHM_MAX_RETRIES; ++attempt) {
+        const uint64_t frame_id = pt_shm_latest_frame_id(reader);
+        const pt_shm_slot* slot;
+        uint32_t seq;
+        if (frame_id == 0) {
+            return PT_SHM_ERR_UNAVAILABLE;
+        }
+        slot = &reader->layout->slots[frame_id % PT_SHM_RING_SIZE];
+        seq = pt_shm_begin_read(slot);
+        if (seq & 1u) {
+            continue;
+        }
+        memcpy(out, &slot->frame, sizeof(*out));
+        if (pt_shm_end_read(slot, seq)) {
+            return PT_SHM_OK;
+        }
+    }
+    return PT_SHM_ERR_BUSY;
+}
+
+/* 参数名表的当前版本，与上次 pt_shm_read_names 得到的 version 不同时需要重新读取 */
+static inline uint32_t pt_shm_names_version(const pt_shm_reader* reader)
+{
+    return pt_shm_load_u32(&reader->layout->names_seq);
+}
+
+/* 把参数名表拷贝到 out，成功返回 PT_SHM_OK，名表正在更新且重试次数用完时返回 PT_SHM_ERR_BUSY */
+static inline int pt_shm_read_names(const pt_shm_reader* reader, pt_shm_names* out)
+{
+    int attempt;
+    for (attempt = 0; attempt < PT_SHM_MAX_RETRIES; ++attempt) {
+        const uint32_t seq = pt_shm_load_u32(&reader->layout->names_seq);
+        if (seq & 1u) {
+            continue;
+        }
+        memcpy(out->face, reader->layout->face_names, sizeof(out->face));
+        memcpy(out->eye, reader->layout->eye_names, sizeof(out->eye));
+        PT_SHM_FENCE_ACQUIRE();
+        if (pt_shm_load_u32(&reader->layout->names_seq) == seq) {
+            out->version = seq;
+            return PT_SHM_OK;
+        }
+    }
+    return PT_SHM_ERR_BUSY;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAPER_TRACKER_SHM_H */
@@ -0,0 +1,66 @@
+// replay_stream.hpp - 回放录制的设备数据流，不需要连接硬件
+#ifndef REPLAY_STREAM_HPP
+#define REPLAY_STREAM_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "frame_source.hpp"
+#include "frame_slot.hpp"
+#include "jpeg_validator.hpp"
+#include "stream_recording.hpp"
+
+class ReplayStream : public FrameSource {
+public:
+    enum class Timing {
+        ORIGINAL,            // 按录制时的接收间隔回放
+        AS_FAST_AS_POSSIBLE, // 不等待，解码完立刻发布下一帧
+    };
+
+    explicit ReplayStream(std::string path, Timing timing = Timing::ORIGINAL, bool loop = false);
+    ~ReplayStream() override;
+
+    bool start() override;
+    void stop() override;
+
+    cv::Mat getLatestFrame() const override { return frame_slot.copy(); }
+    cv::Mat peekLatestFrame(uint64_t* sequence) const override { return frame_slot.peek(sequence); }
+    uint64_t getFrameSequence() const override { return frame_slot.sequence(); }
+    bool isStreaming() const override { return running; }
+
+    float getBatteryPercentage() const override { return battery_percentage; }
+    int getBrightnessValue() const override { return brightness_value; }
+    int getHardwareVersion() const override { return hardware_version; }
+
+    // 回放到文件末尾（且不循环）后返回 true
+    bool finished() const { return reached_end; }
+    // 阻塞直到回放结束或被 stop()
+    void waitUntilFinished();
+
+    const JpegValidator& frameValidator() const { return jpeg_validator; }
+
+private:
+    void run();
+    void handleTextMessage(const uint8_t* data, uint32_t size);
+
+    std::string path;
+    Timing timing;
+    bool loop;
+
+    StreamRecording recording;
+    std::thread worker;
+    std::atomic<bool> running = false;
+    std::atomic<bool> reached_end = false;
+    std::mutex wait_mutex;
+    std::condition_variable wait_cv;
+
+    FrameSlot frame_slot;
+    JpegValidator jpeg_validator;
+    std::atomic<float> battery_percentage = 0.0f;
+    std::atomic<int> brightness_value = 0;
+    std::atomic<int> hardware_version = 0;
+};
+
+#endif // REPLAY_STREAM_HPP
@@ -1,7 +1,12 @@
 #pragma once
 
-#include <any>
+#include <atomic>
+#include <deque>
+#include <memory>
+#ifdef _WIN32
+// 界面代码依赖这里间接引入的 windows.h
 #include <windows.h>
+#endif
 #include <string>
 #include <queue>
 #include <mutex>
@@ -18,6 +23,10 @@
 #include <QTimer>
 
 #include "logger.hpp"
+#include "device_discovery.hpp"
+#include "serial_frame_protocol.hpp"
+#include "serial_frame_source.hpp"
+#include "serial_packet_parser.hpp"
 const std::unordered_map<std::string, int> LATEST_FIRMWARE_VERSIONS = {
     {"face_tracker", 2},
     {"eye_tracker", 1}
@@ -51,21 +60,37 @@ enum PacketType {
     PACKET_LIGHT_CONTROL = 6   // 补光灯控制
 };
 
+// 异步写入的结果，通过 write_data 的回调在主线程通知
+enum class SerialWriteResult {
+    WRITTEN,   // 已全部写入串口
+    COALESCED, // 被同类型的新命令替换，未发送
+    DROPPED,   // 写队列已满，未发送
+    FAILED     // 串口未打开、写入出错或超时
+};
+
 class SerialPortManager : public QObject {
 public:
+    using WriteCallback = std::function<void(SerialWriteResult)>;
+
     explicit SerialPortManager(QObject *parent = nullptr);
     ~SerialPortManager() override;
     void registerRawDataCallback(std::function<void(const std::string&)> callback);
-    template<typename Func>
-    void registerCallback(PacketType packetType, Func&& callback) {
-        registerCallbackImpl(packetType, std::forward<Func>(callback), &Func::operator());
-    }
+    // 收到设备状态包（PACKET_DEVICE_STATUS）时在主线程调用
+    void registerDeviceStatusCallback(std::function<void(const std::string& ip, int brightness, int power, int version)> callback);
+    // 有线连接状态变化时在主线程调用：首次设备枚举完成后调用一次，之后在设备接入或拔出时调用
+    void registerConnectionCallback(std::function<void(bool connected)> callback);
 
+    // 固定使用指定的串口（例如测试用的 pty），不再按 VID/PID 自动选择
+    static void setPortOverride(const std::string& port);
+
+    // 订阅设备发现后立即返回，设备出现时在主线程上打开串口
     void init();
 
     void stop();
 
-    void write_data(const std::string& data);
+    // 放入写队列后立即返回，不等待写完。队列中尚未发送的同类型数据包（A<t>...B<t>）
+    // 会被替换为最新的一条，拖动亮度滑条时只发送最后的值
+    void write_data(const std::string& data, WriteCallback callback = {});
 
     SerialStatus status() const;
 
@@ -79,9 +104,12 @@ public:
 
     void flashESP32(QWidget* window, const std::string& firmwareType = "face_tracker");
 
-    // 查找ESP32-S3设备串口
+    // 查找ESP32-S3设备串口，取设备发现服务最近一次的枚举结果，不会阻塞
     std::string FindEsp32S3Port();
 
+    // 有线模式下通过串口传输的图像，接口与无线视频流相同
+    std::shared_ptr<SerialFrameSource> frameSource() const { return frame_source; }
+
     void stop_heartbeat_timer() const
     {
         if (heartBeatTimer && heartBeatTimer->isActive())
@@ -102,57 +130,64 @@ public:
         }
     }
 private slots:
-    void onReadyRead();
+    // 在串口读取线程上执行：二进制图像帧直接在读取线程解码，文本数据包转回主线程处理
+    void onReadyRead(QSerialPort* port);
 
     void heartBeatTimeout();
 
 private:
-    // 辅助函数，用于推导函数参数类型
-    template<typename Func, typename Class, typename... Args>
-    void registerCallbackImpl(PacketType packetType, Func&& callback, void (Class::*)(Args...) const) {
-        callbacks[packetType] = [callback = std::forward<Func>(callback)](const std::vector<std::any>& params) {
-            if (sizeof...(Args) != params.size()) {
-                LOG_ERROR("回调参数数量不匹配: 期望 {} 个参数，实际 {} 个参数",
-                          sizeof...(Args), params.size());
-                return;
-            }
-            invokeCallbackHelper<0, Args...>(callback, params);
-        };
-    }
+    // 注册各类数据包的处理函数
+    void setupPacketHandlers();
+
+    void onDeviceEvent(const SerialDeviceEvent& event);
+    // 打开 currentPort，为空时直接标记为失败
+    void openPort();
+    void reportConnection();
+
+    // 以下在 io_thread 上执行
+    void startNextWrite(QSerialPort* port);
+    void onBytesWritten(QSerialPort* port, qint64 bytes);
+    void finishWrite(QSerialPort* port, SerialWriteResult result);
+    // 放弃正在写和排队中的数据，回调报告 FAILED
+    void abortWrites();
+    void notifyWrite(WriteCallback callback, SerialWriteResult result);
 
-    // 递归解包参数的辅助函数
-    template<size_t I, typename T, typename... Rest, typename F>
-    static void invokeCallbackHelper(F&& callback, const std::vector<std::any>& params) {
-        if constexpr (sizeof...(Rest) == 0) {
-            // 最后一个参数
-            callback(std::any_cast<std::remove_reference_t<T>>(params[I]));
-        } else {
-            // 还有更多参数，递归展开
-            invokeCallbackHelper<I+1, Rest...>(
-                [&callback, param = std::any_cast<std::remove_reference_t<T>>(params[I])](Rest... args) {
-                    callback(param, args...);
-                },
-                params
-            );
-        }
-    }
-
-    void handlePacket(PacketType packetType, const std::vector<std::any>& params);
-
-    // 解析接收的数据包
-    PacketType parsePacket(const std::string& packet);
-
-    // 处理接收到的数据
-    void processReceivedData(std::string& receivedData);
     std::function<void(const std::string&)> rawDataCallback;
+    std::function<void(const std::string&, int, int, int)> deviceStatusCallback;
+    std::function<void(bool)> connectionCallback;
+    // -1 表示还没有通知过，避免心跳重连时重复回调
+    int reported_connected = -1;
+    int discovery_id = 0;
+    bool enumerated = false;
+    // 只在主线程上访问，数据包跨多次读取时也能拼接完整
+    SerialPacketParser packet_parser;
     std::string currentPort; // 默认端口
     QSerialPort* serialPort;
-    SerialStatus m_status;
+    std::atomic<SerialStatus> m_status;
+
+    struct PendingWrite {
+        std::string data;
+        char packet_type = 0; // A<t>...B<t> 数据包的类型字符，0 表示不参与合并
+        WriteCallback callback;
+    };
+    static constexpr std::size_t MAX_PENDING_WRITES = 16;
+    static constexpr int WRITE_TIMEOUT_MS = 1000;
 
+    // write_lock 保护 write_queue 和 write_in_progress
     std::mutex write_lock;
+    std::deque<PendingWrite> write_queue;
+    bool write_in_progress = false;
 
     QTimer* heartBeatTimer;
-    int timeout_count = 0;
-
-    std::map<PacketType, std::function<void(const std::vector<std::any>&)>> callbacks;
+    std::atomic<int> timeout_count = 0;
+
+    // 串口读写都在这个线程上，大量图像数据不会占用界面线程
+    QThread io_thread;
+    std::shared_ptr<SerialFrameSource> frame_source;
+    // 以下只在 io_thread 上访问
+    serial_frame::Decoder frame_decoder;
+    std::string pending_text;
+    PendingWrite current_write;
+    qint64 current_write_remaining = 0;
+    QTimer* write_timeout_timer = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,86 @@
+// serial_frame_protocol.hpp - 有线模式下串口上的二进制帧格式
+#ifndef SERIAL_FRAME_PROTOCOL_HPP
+#define SERIAL_FRAME_PROTOCOL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 二进制帧与原有的文本数据包（A...B<类型>）共用同一个串口字节流：
+//   同步字(0xA5 0x5A) 类型(u8) 保留(u8) 长度(u32) 负载 CRC32(u32)
+// CRC32 覆盖 类型、保留、长度 和 负载，所有整数都是小端。同步字不是可打印字符，
+// 不会出现在文本数据包中，不属于二进制帧的字节原样交给文本解析
+namespace serial_frame {
+
+constexpr uint8_t SYNC0 = 0xA5;
+constexpr uint8_t SYNC1 = 0x5A;
+constexpr std::size_t HEADER_SIZE = 8;
+constexpr std::size_t TRAILER_SIZE = 4;
+// 单帧负载上限，超过即视为同步字误匹配
+constexpr uint32_t MAX_PAYLOAD = 512 * 1024;
+
+enum FrameType : uint8_t {
+    FRAME_JPEG = 1,        // 一帧完整的 JPEG 图像
+    FRAME_STATUS_JSON = 2, // 与 WebSocket 文本消息相同的设备状态 JSON
+};
+
+uint32_t crc32(const uint8_t* data, std::size_t size, uint32_t crc = 0);
+
+// 编码一帧，返回可以直接写入串口的字节
+std::vector<uint8_t> encode(FrameType type, const uint8_t* payload, std::size_t size);
+
+// 增量解析：每次读到的数据直接 feed 进来，不要求按帧边界到达。
+// 内部缓冲区在帧之间复用；回调里拿到的负载指针只在回调期间有效
+class Decoder {
+public:
+    using Clock = std::chrono::steady_clock;
+    using FrameCallback = std::function<void(FrameType type, const uint8_t* payload, std::size_t size)>;
+    using TextCallback = std::function<void(const char* data, std::size_t size)>;
+
+    Decoder(FrameCallback on_frame, TextCallback on_text);
+
+    void feed(const uint8_t* data, std::size_t size) { feed(data, size, Clock::now()); }
+    // now 为这批数据到达的时间，用于判断帧头之后的数据是否等待过久
+    void feed(const uint8_t* data, std::size_t size, Clock::time_point now);
+    void reset();
+
+    // 帧头合法但负载迟迟收不齐时，超过这个时长就认为同步字是误匹配，
+    // 把它当作文本交出并从下一个字节重新查找，避免后面的文本数据包一直被扣住。
+    // 默认 500 ms，921600 波特率下足够传完 40KB 的图像
+    void setSyncTimeout(std::chrono::milliseconds timeout) { sync_timeout = timeout; }
+
+    uint64_t framesDecoded() const { return frames_decoded; }
+    uint64_t crcErrors() const { return crc_errors; }
+    uint64_t oversizedFrames() const { return oversized_frames; }
+    // 类型未知或保留字节非 0 的帧头
+    uint64_t invalidHeaders() const { return invalid_headers; }
+    uint64_t syncTimeouts() const { return sync_timeouts; }
+
+private:
+    // 把 [0, count) 作为文本交出并从缓冲区移除
+    void flushText(std::size_t count);
+    void consume(std::size_t count);
+
+    FrameCallback on_frame;
+    TextCallback on_text;
+    std::vector<uint8_t> buffer;
+    std::size_t read_pos = 0;
+    // 已从缓冲区交出或跳过的字节总数，用来识别正在等待负载的是不是同一个帧头
+    uint64_t stream_offset = 0;
+    bool waiting = false;
+    uint64_t waiting_offset = 0;
+    Clock::time_point waiting_since;
+    std::chrono::milliseconds sync_timeout{500};
+
+    uint64_t frames_decoded = 0;
+    uint64_t crc_errors = 0;
+    uint64_t oversized_frames = 0;
+    uint64_t invalid_headers = 0;
+    uint64_t sync_timeouts = 0;
+};
+
+} // namespace serial_frame
+
+#endif // SERIAL_FRAME_PROTOCOL_HPP
@@ -0,0 +1,44 @@
+// serial_frame_source.hpp - 有线模式图像来源，由 SerialPortManager 的读取线程写入
+#ifndef SERIAL_FRAME_SOURCE_HPP
+#define SERIAL_FRAME_SOURCE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "frame_slot.hpp"
+#include "frame_source.hpp"
+#include "jpeg_validator.hpp"
+
+class SerialFrameSource : public FrameSource {
+public:
+    // 串口由 SerialPortManager 管理，这里只控制是否接收图像
+    bool start() override { enabled = true; return true; }
+    void stop() override { enabled = false; frame_slot.clear(); }
+
+    cv::Mat getLatestFrame() const override { return frame_slot.copy(); }
+    cv::Mat peekLatestFrame(uint64_t* sequence) const override { return frame_slot.peek(sequence); }
+    uint64_t getFrameSequence() const override { return frame_slot.sequence(); }
+    // 最近一秒内收到过图像即认为在传输
+    bool isStreaming() const override;
+
+    float getBatteryPercentage() const override { return battery_percentage; }
+    int getBrightnessValue() const override { return brightness_value; }
+    int getHardwareVersion() const override { return hardware_version; }
+
+    const JpegValidator& frameValidator() const { return jpeg_validator; }
+
+    // 以下由读取线程调用
+    void publishJpeg(const uint8_t* data, std::size_t size);
+    void publishStatus(const uint8_t* data, std::size_t size);
+
+private:
+    std::atomic<bool> enabled = true;
+    std::atomic<int64_t> last_frame_ms = 0;
+    FrameSlot frame_slot;
+    JpegValidator jpeg_validator;
+    std::atomic<float> battery_percentage = 0.0f;
+    std::atomic<int> brightness_value = 0;
+    std::atomic<int> hardware_version = 0;
+};
+
+#endif // SERIAL_FRAME_SOURCE_HPP
@@ -0,0 +1,73 @@
+// serial_packet_parser.hpp - 串口文本数据包（A<类型>...B<类型>）的增量解析
+#ifndef SERIAL_PACKET_PARSER_HPP
+#define SERIAL_PACKET_PARSER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+// 设备状态包 A5[亮度][IP]POWER[电量]VERSION[版本]B5 的解析结果
+struct DeviceStatusPacket {
+    // 已格式化为点分十进制，指向解析器内部缓冲区，只在回调期间有效
+    std::string_view ip;
+    int brightness = 0;
+    int power = 0;
+    int version = 0;
+};
+
+// 各类数据包的处理函数，未设置的类型解析后直接丢弃。
+// 回调里的 string_view 都指向解析器内部缓冲区，只在回调期间有效
+struct SerialPacketHandlers {
+    std::function<void()> on_wifi_setup;                                          // A101B1
+    std::function<void(std::string_view ssid, std::string_view pwd)> on_wifi_config; // A2SSID..PWD..B2
+    std::function<void()> on_wifi_confirm;                                        // A303B3
+    std::function<void(std::string_view ssid, std::string_view pwd)> on_wifi_connecting; // A4SSID..PWD..B4
+    std::function<void(const DeviceStatusPacket& status)> on_device_status;       // A5...B5
+    std::function<void(int brightness)> on_light_control;                         // A6[亮度]B6
+};
+
+// 逐字节状态机：等待 'A' -> 收集包体直到 'B' -> 读取类型字符后校验并分发。
+// 包体写入固定大小的缓冲区，跨多次 feed 的数据包也能正确拼接，解析过程不分配内存
+class SerialPacketParser {
+public:
+    // 固件最长的数据包是带 SSID 和密码的配置包，远小于这个长度
+    static constexpr std::size_t MAX_PACKET_SIZE = 256;
+
+    explicit SerialPacketParser(SerialPacketHandlers handlers = {});
+
+    void setHandlers(SerialPacketHandlers new_handlers) { handlers = std::move(new_handlers); }
+
+    void feed(const char* data, std::size_t size);
+    void feed(std::string_view data) { feed(data.data(), data.size()); }
+    void reset();
+
+    uint64_t packetsParsed() const { return packets_parsed; }
+    uint64_t packetsRejected() const { return packets_rejected; }
+    uint64_t overflows() const { return overflow_count; }
+
+private:
+    enum class State : uint8_t {
+        WAIT_START, // 丢弃字节直到遇到 'A'
+        BODY,       // 收集 'A' 与 'B' 之间的内容
+        TYPE,       // 'B' 后面的一个字符是包类型
+    };
+
+    // 返回是否为合法的数据包
+    bool dispatch(std::string_view body, char type);
+    bool dispatchStatus(std::string_view body);
+
+    SerialPacketHandlers handlers;
+    State state = State::WAIT_START;
+    std::array<char, MAX_PACKET_SIZE> body_buffer{};
+    std::size_t body_size = 0;
+    // 格式化后的 IP，最长 "255.255.255.255"
+    std::array<char, 16> ip_buffer{};
+
+    uint64_t packets_parsed = 0;
+    uint64_t packets_rejected = 0;
+    uint64_t overflow_count = 0;
+};
+
+#endif // SERIAL_PACKET_PARSER_HPP
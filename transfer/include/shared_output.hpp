@@ -0,0 +1,51 @@
+// shared_output.hpp - 把追踪结果写入共享内存，同机程序不经过 OSC 直接读取
+#ifndef SHARED_OUTPUT_HPP
+#define SHARED_OUTPUT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "paper_tracker_shm.h"
+
+// 共享内存布局和读取接口见 paper_tracker_shm.h。面捕和眼追窗口的输出线程各自发布，
+// 每次发布都写入一帧同时包含两者最新结果的数据
+class SharedOutputChannel {
+public:
+    static SharedOutputChannel& instance();
+
+    // 创建共享内存，之前的 publish 调用都直接返回
+    bool open();
+    void close();
+
+    // names 为参数名，内容变化时才重新写入名字表
+    void publishFace(const std::vector<float>& values, const std::vector<std::string>& names);
+    void publishEye(const std::vector<float>& values, const std::vector<std::string>& names);
+    // 窗口关闭后调用：count 置 0 并清空名字表，另一个窗口之后发布的帧不再带着这里的旧结果
+    void clearFace();
+    void clearEye();
+
+    SharedOutputChannel(const SharedOutputChannel&) = delete;
+    SharedOutputChannel& operator=(const SharedOutputChannel&) = delete;
+
+private:
+    SharedOutputChannel() = default;
+    ~SharedOutputChannel();
+
+    void writeFrameLocked();
+
+    std::mutex mutex;
+    std::atomic<pt_shm_layout*> layout = nullptr;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+    // 两个窗口最新结果的合并，每次发布整体写入环形缓冲区的下一格
+    pt_shm_frame current{};
+    uint64_t frame_counter = 0;
+    // 已写入名字表的参数名，用来判断是否需要重写
+    std::vector<std::string> face_names;
+    std::vector<std::string> eye_names;
+};
+
+#endif // SHARED_OUTPUT_HPP
@@ -0,0 +1,72 @@
+// stream_hub.hpp - 所有设备视频流共用的网络线程
+#ifndef STREAM_HUB_HPP
+#define STREAM_HUB_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <QMutex>
+#include <QThread>
+#include <QTimer>
+
+class ESP32VideoStream;
+class FrameSource;
+class UdpFrameReceiver;
+
+// 所有 ESP32VideoStream 的 WebSocket、mDNS 查询和超时定时器都运行在同一个网络线程上，
+// 心跳检查也由这里的一个定时器统一驱动，增加摄像头不会再增加 GUI 线程的定时器和事件负载
+class StreamHub {
+public:
+    static StreamHub& instance();
+
+    // 创建一个运行在网络线程上的视频流，释放时会在网络线程上停止并销毁
+    std::shared_ptr<ESP32VideoStream> createStream();
+
+    // 创建一个在网络线程上监听 UDP 端口的图像接收器
+    std::shared_ptr<UdpFrameReceiver> createUdpReceiver(quint16 port);
+
+    QThread* thread() { return &io_thread; }
+
+    // 设置后，之后创建的视频流在连接成功时都会自动录制原始数据到该目录
+    void setRecordDirectory(const std::string& directory) { record_directory = directory; }
+
+    // 命令行指定的替代图像来源，按添加顺序分配：面捕窗口用第 0 个，眼追左眼用第 0 个、右眼用第 1 个。
+    // 配置了替代来源的窗口从它取图，不再使用设备视频流
+    void addReplaySource(const std::string& path, bool fast);
+    // 在 port 上接收 UDP 分片图像（见 udp_frame_protocol.hpp）
+    void addUdpSource(quint16 port);
+    std::size_t overrideSourceCount() const { return override_sources.size(); }
+    // 创建并启动第 index 个替代来源，没有配置时返回空
+    std::shared_ptr<FrameSource> createOverrideSource(std::size_t index);
+
+    StreamHub(const StreamHub&) = delete;
+    StreamHub& operator=(const StreamHub&) = delete;
+
+private:
+    StreamHub();
+    ~StreamHub();
+
+    void shutdown();
+    // 释放网络线程上的对象，线程已退出时直接析构
+    void destroyOnThread(QObject* object);
+    void registerStream(ESP32VideoStream* stream);
+    void unregisterStream(ESP32VideoStream* stream);
+    void tick();
+
+    static constexpr int HEARTBEAT_INTERVAL_MS = 50;
+
+    QThread io_thread;
+    QTimer* heartbeat_timer = nullptr;
+    QMutex streams_mutex;
+    std::vector<ESP32VideoStream*> streams;
+    std::string record_directory;
+
+    struct OverrideSource {
+        std::string replay_path;
+        bool replay_fast = false;
+        quint16 udp_port = 0; // 非 0 时为 UDP 接收，否则为回放文件
+    };
+    std::vector<OverrideSource> override_sources;
+};
+
+#endif // STREAM_HUB_HPP
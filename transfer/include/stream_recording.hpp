@@ -0,0 +1,100 @@
+// stream_recording.hpp - 设备原始数据流的录制文件读写
+#ifndef STREAM_RECORDING_HPP
+#define STREAM_RECORDING_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <QFile>
+
+// 文件布局（小端）：
+//   文件头   : "PTREC01\0" + 版本号(u32) + 保留(u32)
+//   数据块 * N: "CHNK" + 记录数(u32) + 数据字节数(u64)，后接若干条记录
+//   记录     : 类型(u8) + 保留(3字节) + 长度(u32) + 接收时间微秒(i64)，后接原始数据
+//   索引     : 每个数据块一项，偏移(u64) + 首条时间(i64) + 末条时间(i64) + 记录数(u32) + 保留(u32)
+//   文件尾   : 索引偏移(u64) + 数据块数(u32) + 保留(u32) + "PTRIDX01"
+// 录制中途崩溃没有写入索引时，读取端会顺序扫描数据块恢复已写入的内容
+enum class RecordType : uint8_t {
+    JPEG_FRAME = 1,   // WebSocket 二进制消息，原样保存
+    TEXT_MESSAGE = 2, // WebSocket 文本消息（电量、亮度、固件版本）
+};
+
+struct RecordView {
+    RecordType type;
+    int64_t timestamp_us;
+    const uint8_t* data;
+    uint32_t size;
+};
+
+// 在接收线程上追加记录，数据先缓存在内存中，凑满一个数据块再写盘
+class StreamRecorder {
+public:
+    StreamRecorder() = default;
+    ~StreamRecorder();
+
+    StreamRecorder(const StreamRecorder&) = delete;
+    StreamRecorder& operator=(const StreamRecorder&) = delete;
+
+    bool open(const std::string& path);
+    // 写入剩余数据块和索引
+    void close();
+    bool isOpen() const;
+
+    // 时间戳取相对于 open() 的接收时间
+    void append(RecordType type, const void* data, std::size_t size);
+
+    uint64_t recordCount() const;
+
+private:
+    struct ChunkIndex {
+        uint64_t offset;
+        int64_t first_timestamp_us;
+        int64_t last_timestamp_us;
+        uint32_t record_count;
+    };
+
+    static constexpr std::size_t CHUNK_BYTES = 1 << 20;
+
+    void flushChunk();
+
+    mutable std::mutex mutex;
+    QFile file;
+    std::chrono::steady_clock::time_point start_time;
+    std::vector<uint8_t> chunk_buffer;
+    ChunkIndex current_chunk{};
+    std::vector<ChunkIndex> chunk_index;
+    uint64_t total_records = 0;
+};
+
+// 以内存映射方式打开录制文件，记录直接指向映射内存，不做拷贝
+class StreamRecording {
+public:
+    StreamRecording() = default;
+    ~StreamRecording();
+
+    StreamRecording(const StreamRecording&) = delete;
+    StreamRecording& operator=(const StreamRecording&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return mapped != nullptr; }
+
+    // 按时间顺序排列的所有记录
+    const std::vector<RecordView>& records() const { return record_views; }
+    int64_t durationUs() const;
+
+private:
+    bool readIndex();
+    bool scanChunks();
+    bool readChunk(uint64_t offset, uint64_t* next_offset);
+
+    QFile file;
+    const uint8_t* mapped = nullptr;
+    uint64_t mapped_size = 0;
+    std::vector<RecordView> record_views;
+};
+
+#endif // STREAM_RECORDING_HPP
@@ -0,0 +1,105 @@
+// udp_frame_protocol.hpp - UDP 分片传输图像帧的报文格式，收发两端共用
+#ifndef UDP_FRAME_PROTOCOL_HPP
+#define UDP_FRAME_PROTOCOL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 每个 UDP 报文 = 16 字节头 + 分片数据（小端）
+//   magic(u16) version(u8) flags(u8) frame_id(u32) fragment_index(u16) fragment_count(u16) frame_size(u32)
+// 同一帧的分片 frame_id 相同，接收端按 fragment_index * MAX_PAYLOAD 的偏移拼回原始 JPEG
+namespace udp_frame {
+
+constexpr uint16_t MAGIC = 0x5450; // "PT"
+constexpr uint8_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 16;
+// 以太网 MTU 1500 - IP(20) - UDP(8) - 头部，留出余量避免 IP 分片
+constexpr std::size_t MAX_PAYLOAD = 1400;
+constexpr uint16_t MAX_FRAGMENTS = 512;
+
+enum Flags : uint8_t {
+    FLAG_NONE = 0,
+    FLAG_TEXT = 1, // 负载是设备状态 JSON，而不是 JPEG
+};
+
+struct Header {
+    uint16_t magic = MAGIC;
+    uint8_t version = VERSION;
+    uint8_t flags = FLAG_NONE;
+    uint32_t frame_id = 0;
+    uint16_t fragment_index = 0;
+    uint16_t fragment_count = 0;
+    uint32_t frame_size = 0;
+};
+
+inline void writeHeader(const Header& header, uint8_t* out) {
+    std::memcpy(out + 0, &header.magic, 2);
+    out[2] = header.version;
+    out[3] = header.flags;
+    std::memcpy(out + 4, &header.frame_id, 4);
+    std::memcpy(out + 8, &header.fragment_index, 2);
+    std::memcpy(out + 10, &header.fragment_count, 2);
+    std::memcpy(out + 12, &header.frame_size, 4);
+}
+
+// 报文头非法时返回 false
+inline bool readHeader(const uint8_t* data, std::size_t size, Header* header) {
+    if (size < HEADER_SIZE) {
+        return false;
+    }
+    std::memcpy(&header->magic, data + 0, 2);
+    header->version = data[2];
+    header->flags = data[3];
+    std::memcpy(&header->frame_id, data + 4, 4);
+    std::memcpy(&header->fragment_index, data + 8, 2);
+    std::memcpy(&header->fragment_count, data + 10, 2);
+    std::memcpy(&header->frame_size, data + 12, 4);
+
+    if (header->magic != MAGIC || header->version != VERSION) {
+        return false;
+    }
+    if (header->fragment_count == 0 || header->fragment_count > MAX_FRAGMENTS ||
+        header->fragment_index >= header->fragment_count) {
+        return false;
+    }
+    // 分片数必须与帧大小一致，且分片长度正确
+    const std::size_t expected_count = (header->frame_size + MAX_PAYLOAD - 1) / MAX_PAYLOAD;
+    if (header->frame_size == 0 || expected_count != header->fragment_count) {
+        return false;
+    }
+    const std::size_t offset = static_cast<std::size_t>(header->fragment_index) * MAX_PAYLOAD;
+    const std::size_t expected_payload = std::min(MAX_PAYLOAD, header->frame_size - offset);
+    return size - HEADER_SIZE == expected_payload;
+}
+
+// 把一帧拆成若干个完整的 UDP 报文
+inline std::vector<std::vector<uint8_t>> fragment(const uint8_t* data, std::size_t size,
+                                                  uint32_t frame_id, uint8_t flags = FLAG_NONE) {
+    std::vector<std::vector<uint8_t>> packets;
+    const std::size_t count = (size + MAX_PAYLOAD - 1) / MAX_PAYLOAD;
+    if (size == 0 || count > MAX_FRAGMENTS) {
+        return packets;
+    }
+    packets.reserve(count);
+    Header header;
+    header.flags = flags;
+    header.frame_id = frame_id;
+    header.fragment_count = static_cast<uint16_t>(count);
+    header.frame_size = static_cast<uint32_t>(size);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t offset = i * MAX_PAYLOAD;
+        const std::size_t length = std::min(MAX_PAYLOAD, size - offset);
+        header.fragment_index = static_cast<uint16_t>(i);
+        std::vector<uint8_t> packet(HEADER_SIZE + length);
+        writeHeader(header, packet.data());
+        std::memcpy(packet.data() + HEADER_SIZE, data + offset, length);
+        packets.push_back(std::move(packet));
+    }
+    return packets;
+}
+
+} // namespace udp_frame
+
+#endif // UDP_FRAME_PROTOCOL_HPP
@@ -0,0 +1,108 @@
+// udp_frame_receiver.hpp - 可选的 UDP 图像接收通道，丢包时丢弃迟到的帧而不是等待重传
+#ifndef UDP_FRAME_RECEIVER_HPP
+#define UDP_FRAME_RECEIVER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <QObject>
+#include <QTimer>
+#include <QUdpSocket>
+#include "frame_slot.hpp"
+#include "frame_source.hpp"
+#include "jpeg_validator.hpp"
+
+// UDP 接收统计
+struct UdpReceiveStats {
+    uint64_t packets_received = 0;
+    uint64_t packets_malformed = 0;   // 报文头非法或长度不符
+    uint64_t fragments_duplicate = 0;
+    uint64_t frames_completed = 0;    // 拼装完整并成功解码
+    uint64_t frames_incomplete = 0;   // 超过期限仍缺分片，被丢弃
+    uint64_t frames_late = 0;         // 更新的帧已经发布时仍未拼完的旧帧，直接丢弃
+    uint64_t fragments_lost = 0;      // 被丢弃的不完整帧中缺少的分片数
+};
+
+// 运行在 StreamHub 的网络线程上，请通过 StreamHub::createUdpReceiver() 创建
+class UdpFrameReceiver : public QObject, public FrameSource {
+public:
+    explicit UdpFrameReceiver(quint16 port, QObject* parent = nullptr);
+    ~UdpFrameReceiver() override;
+
+    bool start() override;
+    void stop() override;
+
+    cv::Mat getLatestFrame() const override { return frame_slot.copy(); }
+    cv::Mat peekLatestFrame(uint64_t* sequence) const override { return frame_slot.peek(sequence); }
+    uint64_t getFrameSequence() const override { return frame_slot.sequence(); }
+    bool isStreaming() const override { return receiving; }
+
+    float getBatteryPercentage() const override { return battery_percentage; }
+    int getBrightnessValue() const override { return brightness_value; }
+    int getHardwareVersion() const override { return hardware_version; }
+
+    // 不完整的帧从第一个分片到达起超过该时长即丢弃
+    void setReassemblyDeadline(std::chrono::milliseconds deadline) { reassembly_deadline = deadline; }
+
+    UdpReceiveStats getStats() const;
+    const JpegValidator& frameValidator() const { return jpeg_validator; }
+
+private:
+    // 正在拼装的一帧，缓冲区在帧之间复用，不会反复分配
+    struct ReassemblySlot {
+        bool in_use = false;
+        uint32_t frame_id = 0;
+        uint8_t flags = 0;
+        uint32_t frame_size = 0;
+        uint16_t fragment_count = 0;
+        uint16_t fragments_received = 0;
+        std::chrono::steady_clock::time_point first_arrival;
+        std::vector<uint8_t> buffer;
+        std::vector<bool> received;
+    };
+
+    // 同时拼装的帧数上限，满了时淘汰最旧的一帧
+    static constexpr std::size_t SLOT_COUNT = 4;
+    static constexpr int EXPIRE_CHECK_INTERVAL_MS = 10;
+    // 帧编号比已发布的旧超过这个数时认为发送端重启
+    static constexpr uint32_t RESYNC_GAP = 256;
+
+    void onReadyRead();
+    void handlePacket(const uint8_t* data, std::size_t size);
+    // 文本消息与图像帧各自编号，用 flags 区分
+    ReassemblySlot* acquireSlot(uint32_t frame_id, uint8_t flags);
+    void completeFrame(ReassemblySlot& slot);
+    void discardSlot(ReassemblySlot& slot);
+    void expireSlots();
+    void handleTextMessage(const uint8_t* data, std::size_t size);
+
+    // frame_id 回绕比较
+    static bool isNewer(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) > 0; }
+
+    quint16 port;
+    QUdpSocket* socket = nullptr;
+    QTimer* expire_timer = nullptr;
+    std::array<ReassemblySlot, SLOT_COUNT> slots;
+    std::vector<char> datagram;
+    std::chrono::milliseconds reassembly_deadline{100};
+    bool has_published = false;
+    uint32_t last_published_id = 0;
+    std::atomic<bool> receiving = false;
+
+    FrameSlot frame_slot;
+    JpegValidator jpeg_validator;
+    std::atomic<float> battery_percentage = 0.0f;
+    std::atomic<int> brightness_value = 0;
+    std::atomic<int> hardware_version = 0;
+
+    std::atomic<uint64_t> packets_received = 0;
+    std::atomic<uint64_t> packets_malformed = 0;
+    std::atomic<uint64_t> fragments_duplicate = 0;
+    std::atomic<uint64_t> frames_completed = 0;
+    std::atomic<uint64_t> frames_incomplete = 0;
+    std::atomic<uint64_t> frames_late = 0;
+    std::atomic<uint64_t> fragments_lost = 0;
+};
+
+#endif // UDP_FRAME_RECEIVER_HPP
@@ -0,0 +1,193 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "jpeg_validator.hpp"
+
+namespace {
+
+constexpr uint8_t MARKER_PREFIX = 0xFF;
+constexpr uint8_t MARKER_SOI = 0xD8;
+constexpr uint8_t MARKER_EOI = 0xD9;
+constexpr uint8_t MARKER_SOS = 0xDA;
+constexpr uint8_t MARKER_TEM = 0x01;
+
+// EOI 之后允许的填充字节数（部分固件会在帧尾补0）
+constexpr std::size_t MAX_TRAILING_PADDING = 64;
+
+bool isStandaloneMarker(uint8_t marker) {
+    // RST0-RST7 与 TEM 没有长度字段
+    return (marker >= 0xD0 && marker <= 0xD7) || marker == MARKER_TEM;
+}
+
+bool isStartOfFrame(uint8_t marker) {
+    // SOF0-SOF15，排除 DHT(C4)、JPG(C8)、DAC(CC)
+    return marker >= 0xC0 && marker <= 0xCF &&
+           marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+}
+
+uint16_t readU16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+bool hasEndOfImage(const uint8_t* data, std::size_t size) {
+    std::size_t end = size;
+    std::size_t padding = 0;
+    while (end >= 2 && padding <= MAX_TRAILING_PADDING) {
+        if (data[end - 2] == MARKER_PREFIX && data[end - 1] == MARKER_EOI) {
+            return true;
+        }
+        if (data[end - 1] != 0x00 && data[end - 1] != MARKER_PREFIX) {
+            return false;
+        }
+        --end;
+        ++padding;
+    }
+    return false;
+}
+
+} // namespace
+
+const char* jpegRejectReasonName(JpegRejectReason reason) {
+    switch (reason) {
+        case JpegRejectReason::NONE: return "none";
+        case JpegRejectReason::TOO_SHORT: return "too_short";
+        case JpegRejectReason::MISSING_SOI: return "missing_soi";
+        case JpegRejectReason::BAD_MARKER: return "bad_marker";
+        case JpegRejectReason::BAD_SEGMENT_LENGTH: return "bad_segment_length";
+        case JpegRejectReason::MISSING_SOF: return "missing_sof";
+        case JpegRejectReason::DIMENSION_MISMATCH: return "dimension_mismatch";
+        case JpegRejectReason::MISSING_EOI: return "missing_eoi";
+        case JpegRejectReason::DECODE_FAILED: return "decode_failed";
+        default: return "unknown";
+    }
+}
+
+void JpegValidator::setExpectedResolution(int width, int height) {
+    expected_width.store(width, std::memory_order_relaxed);
+    expected_height.store(height, std::memory_order_relaxed);
+}
+
+JpegRejectReason JpegValidator::validate(const uint8_t* data, std::size_t size, JpegInfo* info, bool count) {
+    auto result = [&](JpegRejectReason reason) {
+        if (count) {
+            record(reason);
+        }
+        return reason;
+    };
+
+    // SOI + 最小段 + EOI
+    if (data == nullptr || size < 12) {
+        return result(JpegRejectReason::TOO_SHORT);
+    }
+    if (data[0] != MARKER_PREFIX || data[1] != MARKER_SOI) {
+        return result(JpegRejectReason::MISSING_SOI);
+    }
+
+    JpegInfo frame_info;
+    bool has_sof = false;
+    std::size_t pos = 2;
+    while (true) {
+        if (pos >= size || data[pos] != MARKER_PREFIX) {
+            return result(JpegRejectReason::BAD_MARKER);
+        }
+        // 跳过填充的 0xFF
+        while (pos < size && data[pos] == MARKER_PREFIX) {
+            ++pos;
+        }
+        if (pos >= size) {
+            return result(JpegRejectReason::BAD_SEGMENT_LENGTH);
+        }
+        const uint8_t marker = data[pos++];
+        if (marker == 0x00 || marker == MARKER_SOI || marker == MARKER_EOI) {
+            // 在 SOS 之前出现 EOI/SOI 说明帧已损坏
+            return result(JpegRejectReason::BAD_MARKER);
+        }
+        if (isStandaloneMarker(marker)) {
+            continue;
+        }
+        if (pos + 2 > size) {
+            return result(JpegRejectReason::BAD_SEGMENT_LENGTH);
+        }
+        const uint16_t length = readU16(data + pos);
+        if (length < 2 || pos + length > size) {
+            return result(JpegRejectReason::BAD_SEGMENT_LENGTH);
+        }
+        if (isStartOfFrame(marker)) {
+            // 长度(2) 精度(1) 高(2) 宽(2)
+            if (length < 7) {
+                return result(JpegRejectReason::BAD_SEGMENT_LENGTH);
+            }
+            frame_info.height = readU16(data + pos + 3);
+            frame_info.width = readU16(data + pos + 5);
+            has_sof = true;
+        }
+        pos += length;
+        if (marker == MARKER_SOS) {
+            // 之后是熵编码数据，不再逐段解析
+            break;
+        }
+    }
+
+    if (!has_sof) {
+        return result(JpegRejectReason::MISSING_SOF);
+    }
+    const int want_w = expected_width.load(std::memory_order_relaxed);
+    const int want_h = expected_height.load(std::memory_order_relaxed);
+    if (frame_info.width <= 0 || frame_info.height <= 0 ||
+        (want_w > 0 && want_h > 0 && (frame_info.width != want_w || frame_info.height != want_h))) {
+        return result(JpegRejectReason::DIMENSION_MISMATCH);
+    }
+    if (!hasEndOfImage(data + pos, size - pos)) {
+        return result(JpegRejectReason::MISSING_EOI);
+    }
+    if (info) {
+        *info = frame_info;
+    }
+    return result(JpegRejectReason::NONE);
+}
+
+void JpegValidator::record(JpegRejectReason reason) {
+    if (reason == JpegRejectReason::NONE) {
+        accepted.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        reject(reason);
+    }
+}
+
+void JpegValidator::reject(JpegRejectReason reason) {
+    if (reason == JpegRejectReason::NONE || reason == JpegRejectReason::COUNT) {
+        return;
+    }
+    rejected[static_cast<std::size_t>(reason)].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t JpegValidator::rejectedCount(JpegRejectReason reason) const {
+    if (reason == JpegRejectReason::COUNT) {
+        return 0;
+    }
+    return rejected[static_cast<std::size_t>(reason)].load(std::memory_order_relaxed);
+}
+
+uint64_t JpegValidator::rejectedTotal() const {
+    uint64_t total = 0;
+    for (const auto& counter : rejected) {
+        total += counter.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void JpegValidator::resetCounters() {
+    accepted.store(0, std::memory_order_relaxed);
+    for (auto& counter : rejected) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
@@ -39,15 +39,67 @@
 #include "osc/OscOutboundPacketStream.h"
 #include "ip/UdpSocket.h"
 
-#define OUTPUT_BUFFER_SIZE 1024
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <limits>
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+OscSendOptions default_send_options;
+std::vector<OscDestination> default_destinations;
+
+constexpr char BUNDLE_TAG[8] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', '\0'};
+constexpr char FLOAT_TYPE_TAG[4] = {',', 'f', '\0', '\0'};
+
+void writeUint32(char* dst, uint32_t value)
+{
+    dst[0] = static_cast<char>(value >> 24);
+    dst[1] = static_cast<char>(value >> 16);
+    dst[2] = static_cast<char>(value >> 8);
+    dst[3] = static_cast<char>(value);
+}
+
+void writeUint64(char* dst, uint64_t value)
+{
+    writeUint32(dst, static_cast<uint32_t>(value >> 32));
+    writeUint32(dst + 4, static_cast<uint32_t>(value));
+}
+
+void appendBytes(std::vector<char>& bytes, const void* data, std::size_t size)
+{
+    const auto* begin = static_cast<const char*>(data);
+    bytes.insert(bytes.end(), begin, begin + size);
+}
+
+void appendUint32(std::vector<char>& bytes, uint32_t value)
+{
+    char buffer[4];
+    writeUint32(buffer, value);
+    appendBytes(bytes, buffer, sizeof(buffer));
+}
+
+// OSC 字符串以 \0 结尾并补齐到 4 字节
+std::size_t paddedStringSize(std::size_t length)
+{
+    return (length + 4) & ~std::size_t(3);
+}
+}
 
 OscManager::OscManager()
     : address_("127.0.0.1"),
       port_(8888),
       location_prefix_(""),
-      multiplier_(1.0f),
-      socket_(nullptr)
+      multiplier_(1.0f)
 {
+    // 乘数在运行中不变，最大裁剪值只需计算一次
+    max_clip_value_ = std::pow(10.0f, std::floor(std::log10(multiplier_)));
+    setSendOptions(default_send_options);
 }
 
 OscManager::~OscManager() {
@@ -55,57 +107,168 @@ OscManager::~OscManager() {
 }
 
 bool OscManager::init(const std::string& address, int port) {
+    std::lock_guard<std::mutex> lock(mutex_);
     address_ = address;
     port_ = port;
+    destinations_.clear();
 
-    try {
-        socket_ = std::make_unique<UdpTransmitSocket>(
-            IpEndpointName(address_.c_str(), port_)
-        );
-        return true;
-    } catch (const std::exception& e) {
-        LOG_ERROR("OSC初始化错误: {}", e.what());
+#ifdef __linux__
+    if (batch_socket_ < 0) {
+        batch_socket_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (batch_socket_ < 0) {
+            LOG_WARN("无法创建 OSC 批量发送套接字，改为逐个发送");
+        }
+    }
+#endif
+
+    OscDestination primary;
+    primary.address = address_;
+    primary.port = port_;
+    primary.prefix = location_prefix_;
+    if (!addDestinationLocked(primary)) {
         return false;
     }
+    for (const auto& destination : default_destinations) {
+        addDestinationLocked(destination);
+    }
+    return true;
 }
 
 void OscManager::setLocationPrefix(const std::string& prefix) {
     std::lock_guard<std::mutex> lock(mutex_);
     location_prefix_ = prefix;
+    if (!destinations_.empty()) {
+        destinations_.front()->config.prefix = prefix;
+        destinations_.front()->compiled.clear();
+    }
 }
 
-bool OscManager::sendModelOutput(const std::vector<float>& output, const std::vector<std::string>& blend_shapes) {
-    if (!socket_) {
-        LOG_ERROR("OSC socket未初始化");
+bool OscManager::addDestination(const OscDestination& destination) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return addDestinationLocked(destination);
+}
+
+void OscManager::addDefaultDestination(const OscDestination& destination) {
+    default_destinations.push_back(destination);
+}
+
+bool OscManager::addDestinationLocked(const OscDestination& destination) {
+    try {
+        // IpEndpointName 负责解析主机名，批量发送复用解析结果
+        const IpEndpointName endpoint(destination.address.c_str(), destination.port);
+        auto entry = std::make_unique<Destination>();
+        entry->config = destination;
+        entry->socket = std::make_unique<UdpTransmitSocket>(endpoint);
+        entry->ip = static_cast<uint32_t>(endpoint.address);
+        destinations_.push_back(std::move(entry));
+        LOG_INFO("OSC 接收端: {}:{} 前缀 \"{}\"", destination.address, destination.port, destination.prefix);
+        return true;
+    } catch (const std::exception& e) {
+        LOG_ERROR("OSC初始化错误: {}", e.what());
         return false;
     }
+}
 
+void OscManager::setDefaultSendOptions(const OscSendOptions& options) {
+    default_send_options = options;
+}
+
+void OscManager::setSendOptions(const OscSendOptions& options) {
     std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    for (auto& destination : destinations_) {
+        destination->compiled.clear();
+    }
+    // 预留一帧的容量，之后的帧不再分配
+    batch_buffer_.clear();
+    batch_buffer_.reserve(4 * (options_.max_packet_size + 1024));
+    if (options_.use_bundle) {
+        LOG_INFO("OSC 使用 bundle 发送，单包上限 {} 字节", options_.max_packet_size);
+    }
+}
 
-    try {
-        // 计算最大裁剪值
-        float max_clip_value = std::powf(10, std::floor(std::log10(multiplier_)));
+OscSendOptions OscManager::sendOptions() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
 
-        // 循环发送每个输出值
-        for (size_t i = 0; i < output.size() && i < blend_shapes.size(); ++i) {
-            // 应用乘数并限制范围
-            float value = std::min(output[i] * multiplier_, max_clip_value);
+void OscManager::setParameterEpsilon(const std::string& name, float epsilon) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    parameter_epsilons_[name] = epsilon;
+    for (auto& destination : destinations_) {
+        for (auto& compiled : destination->compiled) {
+            for (std::size_t i = 0; i < compiled.elements.size(); ++i) {
+                if (compiled.names[compiled.elements[i].source_index] == name) {
+                    compiled.epsilons[i] = epsilon;
+                }
+            }
+        }
+    }
+}
 
-            // 构建完整地址
-            std::string address = location_prefix_ + blend_shapes[i];
+const std::vector<std::string>& EyeOutputFrame::parameterNames() {
+    static const std::vector<std::string> names = {
+        "/avatar/parameters/v2/EyeLidLeft",
+        "/avatar/parameters/v2/EyeLeftX",
+        "/avatar/parameters/v2/EyeLeftY",
+        "/avatar/parameters/v2/EyeLidRight",
+        "/avatar/parameters/v2/EyeRightX",
+        "/avatar/parameters/v2/EyeRightY",
+        "/avatar/parameters/v2/PupilDilation"
+    };
+    return names;
+}
 
-            // 创建OSC消息
-            char buffer[OUTPUT_BUFFER_SIZE];
-            osc::OutboundPacketStream p(buffer, OUTPUT_BUFFER_SIZE);
+void EyeOutputFrame::toValues(std::vector<float>& values) const {
+    values.resize(SIZE);
+    values[0] = lid_left;
+    values[1] = x_left;
+    values[2] = y_left;
+    values[3] = lid_right;
+    values[4] = x_right;
+    values[5] = y_right;
+    values[6] = pupil_dilation;
+}
 
-            p << osc::BeginMessage(address.c_str())
-              << value
-              << osc::EndMessage;
+EyeOutputFrame EyeOutputFrame::fromValues(const std::vector<float>& values) {
+    EyeOutputFrame frame;
+    float* fields[SIZE] = {&frame.lid_left, &frame.x_left, &frame.y_left,
+                           &frame.lid_right, &frame.x_right, &frame.y_right, &frame.pupil_dilation};
+    for (std::size_t i = 0; i < std::min(values.size(), SIZE); ++i) {
+        *fields[i] = values[i];
+    }
+    return frame;
+}
 
-            // 发送OSC消息
-            socket_->Send(p.Data(), p.Size());
-        }
+bool OscManager::sendModelOutput(const std::vector<float>& output, const std::vector<std::string>& blend_shapes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sendLocked(output, blend_shapes);
+}
+
+bool OscManager::sendEyeFrame(const EyeOutputFrame& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame.toValues(eye_frame_values_);
+    return sendLocked(eye_frame_values_, EyeOutputFrame::parameterNames());
+}
 
+bool OscManager::sendLocked(const std::vector<float>& output, const std::vector<std::string>& blend_shapes) {
+    if (destinations_.empty()) {
+        LOG_ERROR("OSC socket未初始化");
+        return false;
+    }
+
+    try {
+        const std::size_t count = std::min(output.size(), blend_shapes.size());
+        const auto now = std::chrono::steady_clock::now();
+        // 同一次调用拆出的所有 bundle 共用一个 timetag，接收端可以据此把它们视为同一帧
+        const uint64_t time_tag = options_.use_bundle && options_.frame_timetag ? currentTimeTag() : 1;
+
+        batch_.clear();
+        batch_buffer_.clear();
+        for (auto& destination : destinations_) {
+            encodeFor(*destination, output, blend_shapes, count, now, time_tag);
+        }
+        flushBatch();
         return true;
     } catch (const std::exception& e) {
         LOG_ERROR("发送OSC消息错误: {}", e.what());
@@ -113,8 +276,199 @@ bool OscManager::sendModelOutput(const std::vector<float>& output, const std::ve
     }
 }
 
-void OscManager::close() {
-    socket_.reset();
+OscSendStats OscManager::getStats() const {
+    OscSendStats stats;
+    stats.messages_sent = messages_sent_.load(std::memory_order_relaxed);
+    stats.messages_suppressed = messages_suppressed_.load(std::memory_order_relaxed);
+    stats.packets_sent = packets_sent_.load(std::memory_order_relaxed);
+    stats.keyframes = keyframes_.load(std::memory_order_relaxed);
+    stats.batch_calls = batch_calls_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void OscManager::encodeFor(Destination& destination, const std::vector<float>& output, const std::vector<std::string>& blend_shapes,
+                           std::size_t count, std::chrono::steady_clock::time_point now, uint64_t time_tag) {
+    CompiledParameters& compiled = compiledFor(destination, blend_shapes, count);
+    const bool keyframe = now - compiled.last_keyframe >= std::chrono::milliseconds(options_.keyframe_interval_ms);
+
+    uint64_t sent = 0;
+    uint64_t suppressed = 0;
+    for (std::size_t i = 0; i < compiled.elements.size(); ++i) {
+        const auto& element = compiled.elements[i];
+        // 应用乘数并限制范围
+        const float value = std::min(output[element.source_index] * multiplier_, max_clip_value_);
+        // 上次的值为 NaN 时比较结果为 false，必定发送
+        if (!keyframe && std::fabs(value - compiled.last_sent[i]) <= compiled.epsilons[i]) {
+            ++suppressed;
+            continue;
+        }
+        writeUint32(compiled.bytes.data() + element.value_offset, std::bit_cast<uint32_t>(value));
+        compiled.last_sent[i] = value;
+        queueElement(destination, compiled, element, time_tag);
+        ++sent;
+    }
+    closeBundle(destination);
+
+    if (keyframe) {
+        compiled.last_keyframe = now;
+        keyframes_.fetch_add(1, std::memory_order_relaxed);
+    }
+    messages_sent_.fetch_add(sent, std::memory_order_relaxed);
+    messages_suppressed_.fetch_add(suppressed, std::memory_order_relaxed);
+}
+
+void OscManager::queueElement(const Destination& destination, const CompiledParameters& compiled,
+                              const CompiledParameters::Element& element, uint64_t time_tag) {
+    const char* data = compiled.bytes.data() + element.offset;
+    if (!options_.use_bundle) {
+        // 模板在本帧发送完之前不会变化，直接引用
+        batch_.push_back({&destination, data, 0, element.size});
+        return;
+    }
+    // 下一条消息会超出单包上限时先结束当前 bundle，单条超长消息仍单独成包
+    if (open_bundle_ != NO_BUNDLE &&
+        batch_buffer_.size() - open_bundle_ + element.size > options_.max_packet_size) {
+        closeBundle(destination);
+    }
+    if (open_bundle_ == NO_BUNDLE) {
+        open_bundle_ = batch_buffer_.size();
+        appendBytes(batch_buffer_, BUNDLE_TAG, sizeof(BUNDLE_TAG));
+        batch_buffer_.resize(open_bundle_ + BUNDLE_HEADER_SIZE);
+        writeUint64(batch_buffer_.data() + open_bundle_ + sizeof(BUNDLE_TAG), time_tag);
+    }
+    appendBytes(batch_buffer_, data, element.size);
+}
+
+void OscManager::closeBundle(const Destination& destination) {
+    if (open_bundle_ == NO_BUNDLE) {
+        return;
+    }
+    batch_.push_back({&destination, nullptr, open_bundle_, batch_buffer_.size() - open_bundle_});
+    open_bundle_ = NO_BUNDLE;
 }
 
+void OscManager::flushBatch() {
+    if (batch_.empty()) {
+        return;
+    }
+    packets_sent_.fetch_add(batch_.size(), std::memory_order_relaxed);
+
+#ifdef __linux__
+    if (batch_socket_ >= 0) {
+        // 整帧的数据包，包括所有接收端的，通过一次 sendmmsg 发出
+        static thread_local std::vector<mmsghdr> messages;
+        static thread_local std::vector<iovec> vectors;
+        static thread_local std::vector<sockaddr_in> addresses;
+        messages.resize(batch_.size());
+        vectors.resize(batch_.size());
+        addresses.resize(batch_.size());
+        for (std::size_t i = 0; i < batch_.size(); ++i) {
+            const Datagram& datagram = batch_[i];
+            addresses[i] = {};
+            addresses[i].sin_family = AF_INET;
+            addresses[i].sin_port = htons(static_cast<uint16_t>(datagram.destination->config.port));
+            addresses[i].sin_addr.s_addr = htonl(datagram.destination->ip);
+            vectors[i].iov_base = const_cast<char*>(datagram.data ? datagram.data : batch_buffer_.data() + datagram.offset);
+            vectors[i].iov_len = datagram.size;
+            messages[i] = {};
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        std::size_t done = 0;
+        while (done < batch_.size()) {
+            const int sent = ::sendmmsg(batch_socket_, messages.data() + done, static_cast<unsigned>(batch_.size() - done), 0);
+            batch_calls_.fetch_add(1, std::memory_order_relaxed);
+            if (sent <= 0) {
+                // 发送缓冲区满等错误与逐个发送时一样直接丢弃，UDP 本身不保证送达
+                break;
+            }
+            done += static_cast<std::size_t>(sent);
+        }
+        return;
+    }
+#endif
+
+    for (const Datagram& datagram : batch_) {
+        datagram.destination->socket->Send(datagram.data ? datagram.data : batch_buffer_.data() + datagram.offset, datagram.size);
+    }
+}
 
+OscManager::CompiledParameters& OscManager::compiledFor(Destination& destination, const std::vector<std::string>& blend_shapes, std::size_t count) {
+    for (auto& compiled : destination.compiled) {
+        if (compiled.names.size() == count &&
+            std::equal(compiled.names.begin(), compiled.names.end(), blend_shapes.begin())) {
+            return compiled;
+        }
+    }
+
+    if (destination.compiled.size() >= MAX_COMPILED_SETS) {
+        destination.compiled.erase(destination.compiled.begin());
+    }
+    CompiledParameters& compiled = destination.compiled.emplace_back();
+    compiled.names.assign(blend_shapes.begin(), blend_shapes.begin() + count);
+    compile(destination, compiled);
+    return compiled;
+}
+
+void OscManager::compile(const Destination& destination, CompiledParameters& compiled) const {
+    const auto& subset = destination.config.parameters;
+    std::vector<char>& bytes = compiled.bytes;
+    for (std::size_t index = 0; index < compiled.names.size(); ++index) {
+        const std::string& name = compiled.names[index];
+        if (!subset.empty() && std::find(subset.begin(), subset.end(), name) == subset.end()) {
+            continue;
+        }
+        const std::string address = destination.config.prefix + name;
+        const std::size_t message_size = paddedStringSize(address.size()) + sizeof(FLOAT_TYPE_TAG) + 4;
+
+        CompiledParameters::Element element{};
+        element.source_index = index;
+        element.offset = bytes.size();
+        // bundle 内每个元素前有 4 字节长度
+        if (options_.use_bundle) {
+            appendUint32(bytes, static_cast<uint32_t>(message_size));
+        }
+        appendBytes(bytes, address.data(), address.size());
+        bytes.resize(bytes.size() + paddedStringSize(address.size()) - address.size(), '\0');
+        appendBytes(bytes, FLOAT_TYPE_TAG, sizeof(FLOAT_TYPE_TAG));
+        element.value_offset = bytes.size();
+        appendUint32(bytes, 0);
+        element.size = bytes.size() - element.offset;
+        compiled.elements.push_back(element);
+
+        const auto epsilon = parameter_epsilons_.find(name);
+        compiled.epsilons.push_back(epsilon != parameter_epsilons_.end() ? epsilon->second : options_.default_epsilon);
+    }
+    compiled.last_sent.assign(compiled.elements.size(), std::numeric_limits<float>::quiet_NaN());
+}
+
+uint64_t OscManager::currentTimeTag() {
+    // NTP 格式：高 32 位为 1900 年起的秒数，低 32 位为秒的小数部分
+    constexpr uint64_t NTP_UNIX_OFFSET = 2208988800ULL;
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now);
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(now - seconds);
+    const uint64_t fraction = (static_cast<uint64_t>(nanoseconds.count()) << 32) / 1000000000ULL;
+    return ((static_cast<uint64_t>(seconds.count()) + NTP_UNIX_OFFSET) << 32) | fraction;
+}
+
+void OscManager::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+#ifdef __linux__
+    if (batch_socket_ >= 0) {
+        ::close(batch_socket_);
+        batch_socket_ = -1;
+    }
+#endif
+    if (destinations_.empty()) {
+        return;
+    }
+    destinations_.clear();
+    const OscSendStats stats = getStats();
+    if (stats.messages_sent + stats.messages_suppressed > 0) {
+        LOG_INFO("OSC 发送统计: 发送 {} 条，死区跳过 {} 条，数据包 {} 个，关键帧 {} 次",
+                 stats.messages_sent, stats.messages_suppressed, stats.packets_sent, stats.keyframes);
+    }
+}
@@ -0,0 +1,137 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "replay_stream.hpp"
+#include <chrono>
+#include <opencv2/imgcodecs.hpp>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "logger.hpp"
+#include "thread_policy.hpp"
+
+ReplayStream::ReplayStream(std::string path, Timing timing, bool loop)
+    : path(std::move(path)), timing(timing), loop(loop)
+{
+}
+
+ReplayStream::~ReplayStream()
+{
+    stop();
+}
+
+bool ReplayStream::start()
+{
+    if (running) {
+        LOG_WARN("回放已经在运行中");
+        return false;
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (!recording.isOpen() && !recording.open(path)) {
+        return false;
+    }
+    reached_end = false;
+    running = true;
+    worker = std::thread([this]() {
+        utils::ThreadPolicies::apply("decode");
+        run();
+    });
+    return true;
+}
+
+void ReplayStream::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        running = false;
+    }
+    wait_cv.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void ReplayStream::waitUntilFinished()
+{
+    std::unique_lock<std::mutex> lock(wait_mutex);
+    wait_cv.wait(lock, [this]() { return !running; });
+}
+
+void ReplayStream::run()
+{
+    using clock = std::chrono::steady_clock;
+    const auto& records = recording.records();
+
+    do {
+        const auto start_time = clock::now();
+        const int64_t first_timestamp = records.empty() ? 0 : records.front().timestamp_us;
+        for (const auto& record : records) {
+            if (!running) {
+                break;
+            }
+            if (timing == Timing::ORIGINAL) {
+                // 等待到录制时的相对时间点，stop() 可以随时打断
+                const auto due = start_time + std::chrono::microseconds(record.timestamp_us - first_timestamp);
+                std::unique_lock<std::mutex> lock(wait_mutex);
+                wait_cv.wait_until(lock, due, [this]() { return !running; });
+                if (!running) {
+                    break;
+                }
+            }
+
+            if (record.type == RecordType::TEXT_MESSAGE) {
+                handleTextMessage(record.data, record.size);
+                continue;
+            }
+            if (record.type != RecordType::JPEG_FRAME) {
+                continue;
+            }
+            if (jpeg_validator.validate(record.data, record.size, nullptr) != JpegRejectReason::NONE) {
+                continue;
+            }
+            const cv::Mat encoded(1, static_cast<int>(record.size), CV_8UC1, const_cast<uint8_t*>(record.data));
+            cv::Mat frame = cv::imdecode(encoded, cv::IMREAD_COLOR);
+            if (frame.empty()) {
+                jpeg_validator.reject(JpegRejectReason::DECODE_FAILED);
+                continue;
+            }
+            frame_slot.publish(std::move(frame));
+        }
+    } while (loop && running);
+
+    LOG_INFO("回放结束: {}，发布 {} 帧，丢弃 {} 帧", path, frame_slot.sequence(), jpeg_validator.rejectedTotal());
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        // 被 stop() 打断时不算播放完毕
+        reached_end = running.load();
+        running = false;
+    }
+    wait_cv.notify_all();
+}
+
+void ReplayStream::handleTextMessage(const uint8_t* data, uint32_t size)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(reinterpret_cast<const char*>(data),
+                                                                         static_cast<qsizetype>(size)));
+    if (!doc.isObject()) {
+        return;
+    }
+    QJsonObject obj = doc.object();
+    if (obj.contains("battery")) {
+        battery_percentage = static_cast<float>(obj["battery"].toDouble());
+    }
+    if (obj.contains("brightness")) {
+        brightness_value = obj["brightness"].toInt();
+    }
+    hardware_version = obj.contains("hardware_version") ? obj["hardware_version"].toInt() : -1;
+}
@@ -20,31 +20,130 @@
 #pragma once
 
 #include "serial.hpp"
-#include <regex>
-#include <windows.h>
-#include <setupapi.h>
-#include <devguid.h>    // 包含 GUID_DEVCLASS_PORTS
+#include <algorithm>
 #include <string>
-#include <cstring>      // for strstr()
 #include <QMessageBox>
 #include <QProcess>
 #include <QProgressDialog>
 #include <QTimer>
 #include <thread>
-
-#define COM_PORT "COM111"  // 指定要打开的串口号
-
+#include "thread_policy.hpp"
 
 
 // 修改SerialPortManager的构造函数
-SerialPortManager::SerialPortManager(QObject* parent) : QObject(parent), serialPort(new QSerialPort(parent)), heartBeatTimer(nullptr) {
+SerialPortManager::SerialPortManager(QObject* parent)
+    : QObject(parent), serialPort(nullptr), heartBeatTimer(nullptr),
+      frame_source(std::make_shared<SerialFrameSource>()),
+      frame_decoder(
+          [this](serial_frame::FrameType type, const uint8_t* payload, std::size_t size) {
+              if (type == serial_frame::FRAME_JPEG) {
+                  frame_source->publishJpeg(payload, size);
+              } else if (type == serial_frame::FRAME_STATUS_JSON) {
+                  frame_source->publishStatus(payload, size);
+              }
+          },
+          [this](const char* data, std::size_t size) { pending_text.append(data, size); })
+{
     m_status = SerialStatus::CLOSED;
+    setupPacketHandlers();
+    io_thread.setObjectName("SerialIO");
+    // 有线图像的读取和解码都在读取线程上进行
+    QObject::connect(&io_thread, &QThread::started, []() { utils::ThreadPolicies::apply("decode"); });
+    io_thread.start();
+}
+
+namespace {
+
+// 固定使用的串口，非空时忽略设备发现结果
+std::string port_override;
+
+// ESP32-S3 的 USB 串口（VID 303A / PID 1001）的第 0 个接口
+bool isTrackerDevice(const SerialDeviceInfo& device)
+{
+    return device.vendor_id == 0x303A && device.product_id == 0x1001 && device.interface_number <= 0;
+}
+
+} // namespace
+
+void SerialPortManager::setPortOverride(const std::string& port)
+{
+    port_override = port;
 }
 
 void SerialPortManager::init()
 {
-    LOG_DEBUG("正在搜索Paper_Tracker设备...");
-    std::string portName = FindEsp32S3Port();
+    if (!heartBeatTimer)
+    {
+        heartBeatTimer = new QTimer();
+        connect(heartBeatTimer, &QTimer::timeout, this, &SerialPortManager::heartBeatTimeout);
+    }
+    if (discovery_id == 0)
+    {
+        // 设备枚举和热插拔监听都在发现线程上进行，首次枚举完成后在 onDeviceEvent 中打开串口
+        LOG_DEBUG("正在搜索Paper_Tracker设备...");
+        discovery_id = DeviceDiscovery::instance().subscribe(this, [this](const SerialDeviceEvent& event) {
+            onDeviceEvent(event);
+        });
+        return;
+    }
+    openPort();
+}
+
+void SerialPortManager::onDeviceEvent(const SerialDeviceEvent& event)
+{
+    switch (event.type) {
+    case SerialDeviceEvent::ATTACHED:
+        if (!port_override.empty() || !isTrackerDevice(event.device))
+        {
+            return;
+        }
+        if (m_status == SerialStatus::OPENED && currentPort == event.device.port)
+        {
+            return;
+        }
+        LOG_INFO("找到paper_tracker设备的COM端口: {}", event.device.port);
+        currentPort = event.device.port;
+        // 首次枚举中的设备等 ENUMERATED 时统一打开
+        if (enumerated)
+        {
+            stop();
+            openPort();
+        }
+        break;
+    case SerialDeviceEvent::DETACHED:
+        if (!port_override.empty() || event.device.port != currentPort)
+        {
+            return;
+        }
+        LOG_INFO("Paper_Tracker设备已断开: {}", currentPort);
+        stop();
+        currentPort.clear();
+        m_status = SerialStatus::FAILED;
+        reportConnection();
+        break;
+    case SerialDeviceEvent::ENUMERATED:
+        enumerated = true;
+        if (!port_override.empty())
+        {
+            currentPort = port_override;
+        }
+        if (currentPort.empty())
+        {
+            LOG_DEBUG("无法找到Paper_Tracker设备");
+        }
+        openPort();
+        break;
+    }
+}
+
+void SerialPortManager::openPort()
+{
+    if (currentPort.empty())
+    {
+        m_status = SerialStatus::FAILED;
+        reportConnection();
+        return;
+    }
     serialPort = new QSerialPort(nullptr);
     serialPort->setBaudRate(QSerialPort::Baud115200);
     serialPort->setParity(QSerialPort::NoParity);
@@ -54,24 +153,29 @@ void SerialPortManager::init()
     // 添加以下代码，禁用DTR和RTS信号
     serialPort->setDataTerminalReady(false);
     serialPort->setRequestToSend(false);
-    if (portName.empty()) {
-        LOG_DEBUG("无法找到Paper_Tracker设备");
-        serialPort->setPortName(COM_PORT);
-    } else {
-        currentPort = portName;
-        //("尝试连接到Paper_Tracker设备: {}", portName);
-        serialPort->setPortName(QString::fromStdString(portName));
-    }
-
-    if (!heartBeatTimer)
-    {
-        heartBeatTimer = new QTimer();
-        connect(heartBeatTimer, &QTimer::timeout, this, &SerialPortManager::heartBeatTimeout);
-    }
-
-    connect(serialPort, &QSerialPort::readyRead, this, &SerialPortManager::onReadyRead);  // 确保读取线程开始后读取数据
-
-    if (serialPort->open(QIODevice::ReadWrite))
+    // 有线图像数据量较大，放大读取缓冲区（USB-CDC 的实际速率与波特率无关）
+    serialPort->setReadBufferSize(1 << 20);
+    serialPort->setPortName(QString::fromStdString(currentPort));
+    // 串口对象移到读取线程，readyRead 在读取线程上处理
+    serialPort->moveToThread(&io_thread);
+    QSerialPort* port = serialPort;
+    connect(port, &QSerialPort::readyRead, port, [this, port]() { onReadyRead(port); });
+    connect(port, &QSerialPort::bytesWritten, port, [this, port](qint64 bytes) { onBytesWritten(port, bytes); });
+
+    bool opened = false;
+    QMetaObject::invokeMethod(port, [this, port, &opened]() {
+        frame_decoder.reset();
+        pending_text.clear();
+        // 写超时定时器属于读取线程，随串口对象一起销毁
+        write_timeout_timer = new QTimer(port);
+        write_timeout_timer->setSingleShot(true);
+        connect(write_timeout_timer, &QTimer::timeout, port, [this, port]() {
+            port->clear(QSerialPort::Output);
+            finishWrite(port, SerialWriteResult::FAILED);
+        });
+        opened = port->open(QIODevice::ReadWrite);
+    }, Qt::BlockingQueuedConnection);
+    if (opened)
     {
         LOG_DEBUG("有线模式设备打开成功");
         m_status = SerialStatus::OPENED;
@@ -80,141 +184,93 @@ void SerialPortManager::init()
         //LOG_ERROR("串口打开失败: " + serialPort->errorString().toStdString());
         m_status = SerialStatus::FAILED;
     }
+    reportConnection();
     if (!heartBeatTimer->isActive())
     {
         heartBeatTimer->start(20);
     }
 }
 
-SerialPortManager::~SerialPortManager()
+void SerialPortManager::reportConnection()
 {
-    if (m_status == SerialStatus::OPENED)
+    const int connected = m_status == SerialStatus::OPENED ? 1 : 0;
+    if (connected == reported_connected)
     {
-        // 只改变状态，不实际调用stop()
-        m_status = SerialStatus::CLOSED;
-        // 可以选择不删除serialPort对象，但这可能导致内存泄漏
+        return;
+    }
+    reported_connected = connected;
+    if (connectionCallback)
+    {
+        connectionCallback(connected == 1);
     }
 }
 
-std::string SerialPortManager::FindEsp32S3Port() {
-
-    std::string targetPort;
-
-    // 设备标识符 - 支持两种可能的ID格式
-    const char* targetDeviceIds[] = {
-        "USB\\VID_303A&PID_1001&REV_0101&MI_00",
-        "USB\\VID_303A&PID_1001&MI_00"
+void SerialPortManager::setupPacketHandlers()
+{
+    SerialPacketHandlers handlers;
+    handlers.on_wifi_setup = []() {
+        LOG_INFO("[WiFi 配置提示] 请配置 WiFi");
     };
-
-    // 获取设备信息集句柄
-    HDEVINFO hDevInfo = SetupDiGetClassDevs(
-        &GUID_DEVCLASS_PORTS,  // 过滤为串口设备类
-        nullptr,                  // 不指定枚举器字符串
-        nullptr,                  // 父窗口句柄
-        DIGCF_PRESENT          // 仅获取当前存在的设备
-    );
-
-    if (hDevInfo == INVALID_HANDLE_VALUE) {
-        LOG_ERROR("获取设备信息集失败，错误码: {}", std::to_string(GetLastError()));
-        return "";
-    }
-
-    // 枚举设备
-    SP_DEVINFO_DATA devInfoData;
-    devInfoData.cbSize = sizeof(SP_DEVINFO_DATA);
-
-    for (DWORD i = 0; SetupDiEnumDeviceInfo(hDevInfo, i, &devInfoData); i++) {
-        // 获取设备实例ID
-        char instanceId[256] = {0};
-        if (!SetupDiGetDeviceInstanceIdA(hDevInfo, &devInfoData, instanceId, sizeof(instanceId), nullptr)) {
-            continue;
+    handlers.on_wifi_config = [](std::string_view ssid, std::string_view pwd) {
+        LOG_DEBUG("匹配到包类型2 (WiFi 配置数据): SSID = {}, PWD = {}", ssid, pwd);
+        LOG_INFO("[WiFi 配置] 发送 SSID/PWD...");
+    };
+    handlers.on_wifi_confirm = []() {
+        LOG_INFO("[WiFi 配置成功]");
+    };
+    handlers.on_wifi_connecting = [](std::string_view ssid, std::string_view pwd) {
+        if (ssid == "paper")
+        {
+            LOG_INFO("设备正在开机中，如果长时间开机失败则为未进行WiFi配置，请输入WIFI信息并点击发送。");
+            LOG_INFO("当前配置的WIFI信息为SSID = {}, PWD = {},请检查是否有误", ssid, pwd);
         }
-        LOG_DEBUG("检查设备: {}", instanceId);
-        // 检查是否是目标设备 - 尝试所有可能的ID
-        bool isTargetDevice = false;
-        for (const char* targetDeviceId : targetDeviceIds) {
-            if (strstr(instanceId, targetDeviceId) != nullptr) {
-                isTargetDevice = true;
-                LOG_DEBUG("匹配成功，找到目标设备: {}", targetDeviceId);
-                break;
-            }
+        else
+        {
+            LOG_INFO("(网络连接中): 当前WIFI为 {}, 密码为 {}, 如果长时间连接失败，请检查是否有误", ssid, pwd);
         }
-
-        if (isTargetDevice) {
-            // 获取串口名称
-            HKEY hKey = SetupDiOpenDevRegKey(
-                hDevInfo,
-                &devInfoData,
-                DICS_FLAG_GLOBAL,
-                0,
-                DIREG_DEV,
-                KEY_READ
-            );
-
-            if (hKey != INVALID_HANDLE_VALUE) {
-                char portName[16] = {0};
-                DWORD dwSize = sizeof(portName);
-                DWORD dwType = 0;
-
-                if (RegQueryValueExA(hKey, "PortName", nullptr, &dwType, reinterpret_cast<LPBYTE>(portName), &dwSize) == ERROR_SUCCESS) {
-                    targetPort = portName;
-                    LOG_INFO("找到paper_tracker设备的COM端口: {}", targetPort);
-                }
-
-                RegCloseKey(hKey);
-                break;
-            }
+    };
+    // 设备状态包发送频繁，这里不打日志，只转给界面
+    handlers.on_device_status = [this](const DeviceStatusPacket& status) {
+        if (deviceStatusCallback) {
+            deviceStatusCallback(std::string(status.ip), status.brightness, status.power, status.version);
         }
-    }
-
-    // 调试：遍历所有可用的COM端口
-    SP_DEVINFO_DATA devInfoData2;
-    devInfoData2.cbSize = sizeof(SP_DEVINFO_DATA);
-    LOG_DEBUG("系统中所有可用的COM端口: ");
-    for (DWORD i = 0; SetupDiEnumDeviceInfo(hDevInfo, i, &devInfoData2); i++) {
-        HKEY hKey = SetupDiOpenDevRegKey(
-            hDevInfo,
-            &devInfoData2,
-            DICS_FLAG_GLOBAL,
-            0,
-            DIREG_DEV,
-            KEY_READ
-        );
-
-        if (hKey != INVALID_HANDLE_VALUE) {
-            char portName[16] = {0};
-            DWORD dwSize = sizeof(portName);
-            DWORD dwType = 0;
-
-            if (RegQueryValueExA(hKey, "PortName", nullptr, &dwType, reinterpret_cast<LPBYTE>(portName), &dwSize) == ERROR_SUCCESS) {
-                // 获取友好名称
-                char friendlyName[256] = {0};
-                DWORD nameSize = sizeof(friendlyName);
-                if (SetupDiGetDeviceRegistryPropertyA(
-                    hDevInfo,
-                    &devInfoData2,
-                    SPDRP_FRIENDLYNAME,
-                    nullptr,
-                    reinterpret_cast<PBYTE>(friendlyName),
-                    nameSize,
-                    nullptr)) {
-                    LOG_DEBUG(" - {} ({})", portName, friendlyName);
-                } else {
-                    LOG_DEBUG(" - {}", portName);
-                }
-            }
+    };
+    handlers.on_light_control = [](int brightness) {
+        LOG_INFO("[补光灯设置] 调整亮度: {}", brightness);
+    };
+    packet_parser.setHandlers(std::move(handlers));
+}
 
-            RegCloseKey(hKey);
-        }
+SerialPortManager::~SerialPortManager()
+{
+    if (m_status == SerialStatus::OPENED)
+    {
+        // 只改变状态，不实际调用stop()
+        m_status = SerialStatus::CLOSED;
     }
-
-    SetupDiDestroyDeviceInfoList(hDevInfo);
-
-    if (targetPort.empty()) {
-        LOG_DEBUG("未找到设备的COM端口");
+    if (discovery_id != 0) {
+        DeviceDiscovery::instance().unsubscribe(discovery_id);
     }
+    if (serialPort) {
+        // 串口对象在读取线程退出时随延迟删除事件一起销毁
+        serialPort->deleteLater();
+        serialPort = nullptr;
+    }
+    io_thread.quit();
+    io_thread.wait();
+}
 
-    return targetPort;
+std::string SerialPortManager::FindEsp32S3Port() {
+    if (!port_override.empty()) {
+        return port_override;
+    }
+    for (const auto& device : DeviceDiscovery::instance().devices()) {
+        if (isTrackerDevice(device)) {
+            return device.port;
+        }
+    }
+    LOG_DEBUG("未找到设备的COM端口");
+    return "";
 }
 
 void SerialPortManager::stop()
@@ -225,226 +281,173 @@ void SerialPortManager::stop()
     }
     m_status = SerialStatus::CLOSED;
     if (serialPort) {
-        if (serialPort->isOpen())
-        {
-            // 禁用自动RTS和DTR控制
-            serialPort->setDataTerminalReady(false);
-            serialPort->setRequestToSend(false);
-
-            // 添加小延迟
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-            serialPort->close();
-        }
-        delete serialPort;
+        QSerialPort* port = serialPort;
+        serialPort = nullptr;
+        // 串口属于读取线程，必须在读取线程上关闭
+        QMetaObject::invokeMethod(port, [this, port]() {
+            abortWrites();
+            write_timeout_timer = nullptr;
+            if (port->isOpen())
+            {
+                // 禁用自动RTS和DTR控制
+                port->setDataTerminalReady(false);
+                port->setRequestToSend(false);
+
+                // 添加小延迟
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+                port->close();
+            }
+        }, Qt::BlockingQueuedConnection);
+        port->deleteLater();
     }
 }
 
-// 处理接收到的数据
-void SerialPortManager::processReceivedData(std::string& receivedData)
+void SerialPortManager::write_data(const std::string& data, WriteCallback callback)
 {
-    // 处理粘包问题 - 循环处理所有可能的完整数据包
-    while (true) {
-        // 查找包起始字符 'A'
-        size_t startPos = receivedData.find('A');
-        if (startPos == std::string::npos) {
-            // 没有找到起始符，清空缓冲区
-            receivedData.clear();
-            break;
-        }
-
-        // 如果起始符不在第一个位置，移除前面的无效数据
-        if (startPos > 0) {
-            receivedData = receivedData.substr(startPos);
-        }
+    // 可能在任意线程调用，只读原子状态；QSerialPort 的状态只在它所在的 IO 线程（startNextWrite）里检查
+    QSerialPort* port = serialPort;
+    if (!port || m_status != SerialStatus::OPENED)
+    {
+        notifyWrite(std::move(callback), SerialWriteResult::FAILED);
+        return ;
+    }
 
-        // 查找包结束字符 'B'
-        size_t endPos = receivedData.find('B', 1); // 从A后面开始查找
-        if (endPos == std::string::npos) {
-            // 没有找到完整的数据包，等待更多数据
-            break;
-        }
+    // A<t>...B<t> 格式的命令可以合并，只保留同类型的最新一条
+    char packet_type = 0;
+    if (data.size() >= 4 && data.front() == 'A' && data[data.size() - 2] == 'B' && data[1] == data.back())
+    {
+        packet_type = data[1];
+    }
 
-        // 确保在B后面有至少一个字符作为包类型
-        if (endPos + 1 >= receivedData.length()) {
-            // 包不完整，等待更多数据
-            break;
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(write_lock);
+        auto it = packet_type == 0 ? write_queue.end()
+            : std::find_if(write_queue.begin(), write_queue.end(),
+                           [packet_type](const PendingWrite& w) { return w.packet_type == packet_type; });
+        if (it != write_queue.end())
+        {
+            notifyWrite(std::move(it->callback), SerialWriteResult::COALESCED);
+            it->data = data;
+            it->callback = std::move(callback);
+            return;
         }
-
-        // 提取完整的数据包，确保包括起始A和结束B及其后的类型字符
-        std::string packet = receivedData.substr(0, endPos + 2);
-
-        // 从缓冲区中移除已处理的数据包
-        receivedData = receivedData.substr(endPos + 2);
-
-        // 处理提取出的数据包
-
-        LOG_DEBUG("接收到数据包: {}", packet);
-
-        // 根据类型执行不同操作
-        switch (parsePacket(packet)) {
-        case PACKET_WIFI_SETUP:
-            LOG_INFO("[WiFi 配置提示] 请配置 WiFi");
-            break;
-        case PACKET_WIFI_SSID_PWD:
-            LOG_INFO("[WiFi 配置] 发送 SSID/PWD...");
-            break;
-        case PACKET_WIFI_CONFIRM:
-            LOG_INFO("[WiFi 配置成功]");
-            break;
-        case PACKET_WIFI_ERROR:
-            //LOG_INFO("[WiFi 配置错误] SSID 或密码错误");
-            break;
-        case PACKET_DEVICE_STATUS:
-            LOG_DEBUG("[设备状态] 更新设备信息...");
-            break;
-        case PACKET_LIGHT_CONTROL:
-            LOG_INFO("[补光灯设置] 调整亮度");
-            break;
-        default:
-            ;
-            //LOG_WARN("[未知数据包]: " + QString(packet.c_str()));
+        if (write_queue.size() >= MAX_PENDING_WRITES)
+        {
+            LOG_WARN("串口写队列已满，丢弃数据: {}", data);
+            notifyWrite(std::move(callback), SerialWriteResult::DROPPED);
+            return;
         }
+        write_queue.push_back({data, packet_type, std::move(callback)});
+        schedule = !write_in_progress;
+    }
+    if (schedule)
+    {
+        QMetaObject::invokeMethod(port, [this, port]() { startNextWrite(port); }, Qt::QueuedConnection);
     }
 }
 
-void SerialPortManager::write_data(const std::string& data)
+void SerialPortManager::startNextWrite(QSerialPort* port)
 {
-    if (!serialPort || !serialPort->isOpen())
     {
-        return ;
-    }
-    QMetaObject::invokeMethod(serialPort, [this, data]() {
         std::lock_guard<std::mutex> lock(write_lock);
-        serialPort->write(data.c_str(), data.size());
-        serialPort->flush();
-        if (!serialPort->waitForBytesWritten(1000)) {
-            m_status = SerialStatus::FAILED;
-            LOG_ERROR("发送数据失败: {}", data);
-            // timeout_count = 1000;
-        } else {
-            m_status = SerialStatus::OPENED;
+        if (write_in_progress || write_queue.empty())
+        {
+            return;
         }
-    }, Qt::QueuedConnection);
+        if (!port->isOpen())
+        {
+            return;
+        }
+        current_write = std::move(write_queue.front());
+        write_queue.pop_front();
+        write_in_progress = true;
+    }
+    const auto size = static_cast<qint64>(current_write.data.size());
+    // 只放入 QSerialPort 的发送缓冲区，实际写出后通过 bytesWritten 通知
+    if (port->write(current_write.data.data(), size) != size)
+    {
+        finishWrite(port, SerialWriteResult::FAILED);
+        return;
+    }
+    current_write_remaining = size;
+    if (write_timeout_timer)
+    {
+        write_timeout_timer->start(WRITE_TIMEOUT_MS);
+    }
 }
 
-static std::string trim(const std::string& str) {
-    const std::string whitespace = " \t\n\r";
-    size_t start = str.find_first_not_of(whitespace);
-    if (start == std::string::npos)
-        return ""; // 全部为空白
-    size_t end = str.find_last_not_of(whitespace);
-    return str.substr(start, end - start + 1);
+void SerialPortManager::onBytesWritten(QSerialPort* port, qint64 bytes)
+{
+    if (current_write_remaining <= 0)
+    {
+        return;
+    }
+    current_write_remaining -= bytes;
+    if (current_write_remaining <= 0)
+    {
+        finishWrite(port, SerialWriteResult::WRITTEN);
+    }
 }
 
-PacketType SerialPortManager::parsePacket(const std::string& packet)
+void SerialPortManager::finishWrite(QSerialPort* port, SerialWriteResult result)
 {
-    // 先将收到的字符串去除首尾空白（例如换行符、空格）
-    std::string trimmedPacket = trim(packet);
-    //LOG_DEBUG("Parsing packet: [" + QString(trimmedPacket.c_str()) + "]");
-
-    // 基本验证：检查包格式是否有效（A开头，B结尾加数字）
-    if (trimmedPacket.length() < 3 || trimmedPacket[0] != 'A' ||
-        trimmedPacket[trimmedPacket.length() - 2] != 'B') {
-        LOG_DEBUG("无效包格式");
-        return PACKET_UNKNOWN;
+    if (write_timeout_timer)
+    {
+        write_timeout_timer->stop();
     }
+    current_write_remaining = 0;
+    if (result == SerialWriteResult::FAILED)
+    {
+        m_status = SerialStatus::FAILED;
+        LOG_ERROR("发送数据失败: {}", current_write.data);
+    } else
+    {
+        m_status = SerialStatus::OPENED;
+    }
+    notifyWrite(std::move(current_write.callback), result);
+    current_write = {};
+    {
+        std::lock_guard<std::mutex> lock(write_lock);
+        write_in_progress = false;
+    }
+    startNextWrite(port);
+}
 
-    // 获取包类型（B后面的数字）
-    char packetType = trimmedPacket[trimmedPacket.length() - 1];
-
-    std::smatch match;
-
-    // 根据包类型选择正则表达式
-    switch (packetType) {
-        case '1': // 数据包1：A101B1
-            if (std::regex_match(trimmedPacket, std::regex("^A1(01)B1$"))) {
-                LOG_DEBUG("匹配到包类型1 (WiFi 配置提示)");
-                handlePacket(PACKET_WIFI_SETUP, {});
-                return PACKET_WIFI_SETUP;
-            }
-            break;
-
-        case '2': // 数据包2：A2SSID[SSID内容]PWD[PWD]B2
-            if (std::regex_match(trimmedPacket, match, std::regex("^A2SSID(.*?)PWD(.*?)B2$"))) {
-                LOG_DEBUG("匹配到包类型2 (WiFi 配置数据): SSID = {}, PWD = {}", match[1].str(), match[2].str());
-                handlePacket(PACKET_WIFI_SETUP, {match[1].str(), match[2].str()});
-                return PACKET_WIFI_SSID_PWD;
-            }
-            break;
+void SerialPortManager::abortWrites()
+{
+    if (write_timeout_timer)
+    {
+        write_timeout_timer->stop();
+    }
+    std::deque<PendingWrite> dropped;
+    {
+        std::lock_guard<std::mutex> lock(write_lock);
+        dropped.swap(write_queue);
+        if (write_in_progress)
+        {
+            dropped.push_front(std::move(current_write));
+            write_in_progress = false;
+        }
+    }
+    current_write = {};
+    current_write_remaining = 0;
+    for (auto& write : dropped)
+    {
+        notifyWrite(std::move(write.callback), SerialWriteResult::FAILED);
+    }
+}
 
-        case '3': // 数据包3：A303B3
-            if (std::regex_match(trimmedPacket, std::regex("^A303B3$"))) {
-                LOG_DEBUG("匹配到包类型3 (WiFi 配置成功确认)");
-                handlePacket(PACKET_WIFI_CONFIRM, {});
-                return PACKET_WIFI_CONFIRM;
-            }
-            break;
-
-        case '4': // 数据包4：A4SSID[SSID内容]PWD[PWD]B4
-            if (std::regex_match(trimmedPacket, match, std::regex("^A4SSID(.*?)PWD(.*?)B4$"))) {
-                if (match[1].str() == "paper")
-                {
-                    LOG_INFO("设备正在开机中，如果长时间开机失败则为未进行WiFi配置，请输入WIFI信息并点击发送。");
-                    LOG_INFO("当前配置的WIFI信息为SSID = {}, PWD = {},请检查是否有误", match[1].str(), match[2].str());
-                }
-                else
-                {
-                    LOG_INFO("(网络连接中): 当前WIFI为 {}, 密码为 {}, 如果长时间连接失败，请检查是否有误", match[1].str(), match[2].str());
-                }
-                handlePacket(PACKET_WIFI_CONFIRM, {match[1].str(), match[2].str()});
-                return PACKET_WIFI_ERROR;
-            }
-            break;
-
-        case '5': // 数据包5：A5[亮度][IP地址]POWER[电量]VERSION[固件版本]B5
-            if (std::regex_match(trimmedPacket, match,
-                std::regex(R"(^A5(\d{1,3})(\d+)POWER(\d{1,3})VERSION(\d{1,3})B5$)"))) {
-                // 获取数字形式的IP地址
-                std::string rawIp = match[2];
-
-                // 格式化为标准IPv4地址 (169031168192 -> 169.031.168.192)
-                std::string formattedIp;
-                try {
-                    // 确保IP长度足够，如果不够则前面补0
-                    std::string paddedIp = rawIp;
-                    while (paddedIp.length() < 12) {
-                        paddedIp = "0" + paddedIp;
-                    }
-
-                    // 以3位一组分割，然后转换为标准IPv4格式
-                    // 修改IP格式化逻辑，反转四组数字的顺序
-                    formattedIp =
-                        std::to_string(std::stoi(paddedIp.substr(0, 3))) + "." +
-                        std::to_string(std::stoi(paddedIp.substr(3, 3))) + "." +
-                        std::to_string(std::stoi(paddedIp.substr(6, 3))) + "." +
-                        std::to_string(std::stoi(paddedIp.substr(9, 3)));
-                    // 调用回调函数
-                    int brightness = std::stoi(match[1]);
-                    int power = std::stoi(match[3]);
-                    int version = std::stoi(match[4]);
-                    handlePacket(PACKET_DEVICE_STATUS, {formattedIp, brightness, power, version});
-                } catch (const std::exception& e) {
-                    LOG_ERROR("IP格式转换失败: {}", e.what());
-                    formattedIp = rawIp; // 转换失败时使用原始IP
-                }
-                LOG_DEBUG("匹配到包类型5 (设备状态): 亮度 = {}, IP = {}, 电量 = {}, 固件版本 = {}", match[1].str(), formattedIp, match[3].str(), match[4].str());
-                return PACKET_DEVICE_STATUS;
-                }
-            break;
-
-        case '6': // 数据包6：A6[亮度]B6
-            if (std::regex_match(trimmedPacket, match, std::regex("^A6(\\d{1,3})B6$"))) {
-                LOG_DEBUG("匹配到包类型6 (补光灯控制): 亮度 = {}", match[1].str());
-                return PACKET_LIGHT_CONTROL;
-            }
-            break;
-        default:
-            break;
+void SerialPortManager::notifyWrite(WriteCallback callback, SerialWriteResult result)
+{
+    if (!callback)
+    {
+        return;
     }
-    // LOG_DEBUG("未匹配任何数据包类型: {}", packetType);
-    return PACKET_UNKNOWN;
+    QMetaObject::invokeMethod(this, [callback = std::move(callback), result]() { callback(result); }, Qt::QueuedConnection);
 }
+
 void SerialPortManager::sendWiFiConfig(const std::string& ssid, const std::string& pwd)
 {
     std::string packet = "A2SSID" + ssid + "PWD" + pwd + "B2";
@@ -699,27 +702,31 @@ void SerialPortManager::restartESP32(QWidget* window)
     }
 }
 
-void SerialPortManager::onReadyRead()
+void SerialPortManager::onReadyRead(QSerialPort* port)
 {
-    if (!serialPort)
+    timeout_count = 0;
+    QByteArray data = port->readAll();
+    if (data.isEmpty())
     {
         m_status = SerialStatus::FAILED;
         return;
     }
-    timeout_count = 0;
-    QByteArray data = serialPort->readAll();
-    if (!data.isEmpty())
-    {
-        m_status = SerialStatus::OPENED;
-        auto receivedData = QString::fromLocal8Bit(data).toStdString();
+    m_status = SerialStatus::OPENED;
+
+    // 二进制图像帧在这里直接解码发布，剩下的文本字节收集到 pending_text
+    frame_decoder.feed(reinterpret_cast<const uint8_t*>(data.constData()), static_cast<std::size_t>(data.size()));
+    if (pending_text.empty()) {
+        return;
+    }
+
+    // 回调会操作界面，转到 SerialPortManager 所在的线程执行
+    QMetaObject::invokeMethod(this, [this, text = QByteArray(pending_text.data(), static_cast<qsizetype>(pending_text.size()))]() {
         if (rawDataCallback) {
-            rawDataCallback(receivedData);
+            rawDataCallback(QString::fromLocal8Bit(text).toStdString());
         }
-        processReceivedData(receivedData);
-    } else
-    {
-        m_status = SerialStatus::FAILED;
-    }
+        packet_parser.feed(text.constData(), static_cast<std::size_t>(text.size()));
+    }, Qt::QueuedConnection);
+    pending_text.clear();
 }
 
 void SerialPortManager::heartBeatTimeout()
@@ -727,18 +734,27 @@ void SerialPortManager::heartBeatTimeout()
     if (timeout_count++ > 100)
     {
         timeout_count = 0;
+        // 没有设备时等待设备发现的接入事件，不反复重试
+        if (currentPort.empty())
+        {
+            return;
+        }
         stop();
         init();
     }
 }
 
-void SerialPortManager::handlePacket(PacketType packetType, const std::vector<std::any>& params) {
-    auto it = callbacks.find(packetType);
-    if (it != callbacks.end()) {
-        it->second(params);
-    }
-}
 void SerialPortManager::registerRawDataCallback(std::function<void(const std::string&)> callback)
 {
     rawDataCallback = callback;
+}
+
+void SerialPortManager::registerConnectionCallback(std::function<void(bool connected)> callback)
+{
+    connectionCallback = std::move(callback);
+}
+
+void SerialPortManager::registerDeviceStatusCallback(std::function<void(const std::string& ip, int brightness, int power, int version)> callback)
+{
+    deviceStatusCallback = std::move(callback);
 }
\ No newline at end of file
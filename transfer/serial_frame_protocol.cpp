@@ -0,0 +1,172 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "serial_frame_protocol.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace serial_frame {
+
+namespace {
+
+// 缓冲区前部已消费的数据超过这个大小才整体前移，避免每次读取都搬移半帧数据
+constexpr std::size_t COMPACT_THRESHOLD = 64 * 1024;
+
+constexpr std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+constexpr auto CRC_TABLE = makeCrcTable();
+
+uint32_t readU32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void appendU32(std::vector<uint8_t>& out, uint32_t value) {
+    const auto* p = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), p, p + sizeof(value));
+}
+
+} // namespace
+
+uint32_t crc32(const uint8_t* data, std::size_t size, uint32_t crc) {
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+std::vector<uint8_t> encode(FrameType type, const uint8_t* payload, std::size_t size) {
+    std::vector<uint8_t> out;
+    out.reserve(HEADER_SIZE + size + TRAILER_SIZE);
+    out.push_back(SYNC0);
+    out.push_back(SYNC1);
+    out.push_back(type);
+    out.push_back(0);
+    appendU32(out, static_cast<uint32_t>(size));
+    out.insert(out.end(), payload, payload + size);
+    appendU32(out, crc32(out.data() + 2, out.size() - 2));
+    return out;
+}
+
+Decoder::Decoder(FrameCallback on_frame, TextCallback on_text)
+    : on_frame(std::move(on_frame)), on_text(std::move(on_text))
+{
+}
+
+void Decoder::reset() {
+    buffer.clear();
+    read_pos = 0;
+    waiting = false;
+}
+
+void Decoder::flushText(std::size_t count) {
+    if (count > 0 && on_text) {
+        on_text(reinterpret_cast<const char*>(buffer.data() + read_pos), count);
+    }
+    consume(count);
+}
+
+void Decoder::consume(std::size_t count) {
+    read_pos += count;
+    stream_offset += count;
+}
+
+void Decoder::feed(const uint8_t* data, std::size_t size, Clock::time_point now) {
+    buffer.insert(buffer.end(), data, data + size);
+
+    while (read_pos < buffer.size()) {
+        const uint8_t* begin = buffer.data() + read_pos;
+        const std::size_t available = buffer.size() - read_pos;
+
+        const auto* sync = static_cast<const uint8_t*>(std::memchr(begin, SYNC0, available));
+        if (!sync) {
+            flushText(available);
+            break;
+        }
+        flushText(static_cast<std::size_t>(sync - begin));
+
+        const std::size_t remaining = buffer.size() - read_pos;
+        if (remaining < 2) {
+            break;
+        }
+        const uint8_t* frame = buffer.data() + read_pos;
+        if (frame[1] != SYNC1) {
+            flushText(1);
+            continue;
+        }
+        if (remaining < HEADER_SIZE) {
+            break;
+        }
+        // 帧头自身能判断的错误不等负载到达，立即重新同步
+        if ((frame[2] != FRAME_JPEG && frame[2] != FRAME_STATUS_JSON) || frame[3] != 0) {
+            ++invalid_headers;
+            flushText(1);
+            continue;
+        }
+        const uint32_t length = readU32(frame + 4);
+        if (length > MAX_PAYLOAD) {
+            ++oversized_frames;
+            flushText(1);
+            continue;
+        }
+        const std::size_t total = HEADER_SIZE + length + TRAILER_SIZE;
+        if (remaining < total) {
+            if (!waiting || waiting_offset != stream_offset) {
+                waiting = true;
+                waiting_offset = stream_offset;
+                waiting_since = now;
+            } else if (now - waiting_since > sync_timeout) {
+                ++sync_timeouts;
+                waiting = false;
+                flushText(1);
+                continue;
+            }
+            // 等待剩余数据，下次从帧头继续
+            break;
+        }
+        const uint32_t expected = readU32(frame + HEADER_SIZE + length);
+        if (crc32(frame + 2, HEADER_SIZE - 2 + length) != expected) {
+            // 同步字误匹配或数据损坏，跳过这个字节重新同步
+            ++crc_errors;
+            consume(1);
+            continue;
+        }
+        ++frames_decoded;
+        if (on_frame) {
+            on_frame(static_cast<FrameType>(frame[2]), frame + HEADER_SIZE, length);
+        }
+        consume(total);
+    }
+
+    if (read_pos == buffer.size()) {
+        buffer.clear();
+        read_pos = 0;
+    } else if (read_pos >= COMPACT_THRESHOLD) {
+        buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(read_pos));
+        read_pos = 0;
+    }
+}
+
+} // namespace serial_frame
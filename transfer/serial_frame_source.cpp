@@ -0,0 +1,70 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "serial_frame_source.hpp"
+#include <chrono>
+#include <opencv2/imgcodecs.hpp>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "logger.hpp"
+
+namespace {
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+bool SerialFrameSource::isStreaming() const
+{
+    const int64_t last = last_frame_ms.load(std::memory_order_relaxed);
+    return enabled && last != 0 && nowMs() - last < 1000;
+}
+
+void SerialFrameSource::publishJpeg(const uint8_t* data, std::size_t size)
+{
+    if (!enabled) {
+        return;
+    }
+    if (jpeg_validator.validate(data, size, nullptr) != JpegRejectReason::NONE) {
+        return;
+    }
+    // 直接在读取缓冲区上解码，不做额外拷贝
+    const cv::Mat encoded(1, static_cast<int>(size), CV_8UC1, const_cast<uint8_t*>(data));
+    cv::Mat frame = cv::imdecode(encoded, cv::IMREAD_COLOR);
+    if (frame.empty()) {
+        jpeg_validator.reject(JpegRejectReason::DECODE_FAILED);
+        LOG_WARN("有线模式图像解码失败");
+        return;
+    }
+    frame_slot.publish(std::move(frame));
+    last_frame_ms.store(nowMs(), std::memory_order_relaxed);
+}
+
+void SerialFrameSource::publishStatus(const uint8_t* data, std::size_t size)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(reinterpret_cast<const char*>(data),
+                                                                         static_cast<qsizetype>(size)));
+    if (!doc.isObject()) {
+        return;
+    }
+    QJsonObject obj = doc.object();
+    if (obj.contains("battery")) {
+        battery_percentage = static_cast<float>(obj["battery"].toDouble());
+    }
+    if (obj.contains("brightness")) {
+        brightness_value = obj["brightness"].toInt();
+    }
+    hardware_version = obj.contains("hardware_version") ? obj["hardware_version"].toInt() : -1;
+}
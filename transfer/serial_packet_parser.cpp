@@ -0,0 +1,240 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "serial_packet_parser.hpp"
+#include <algorithm>
+#include <charconv>
+
+namespace {
+
+bool isDigits(std::string_view s) {
+    return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// 1 到 3 位十进制数
+bool parseSmallInt(std::string_view s, int& value) {
+    if (s.size() > 3 || !isDigits(s)) {
+        return false;
+    }
+    return std::from_chars(s.data(), s.data() + s.size(), value).ec == std::errc();
+}
+
+// 从 s 开头取出连续数字
+std::string_view takeDigits(std::string_view s) {
+    std::size_t n = 0;
+    while (n < s.size() && s[n] >= '0' && s[n] <= '9') {
+        ++n;
+    }
+    return s.substr(0, n);
+}
+
+// 解析 "SSID<ssid>PWD<pwd>"，SSID 取到第一个 "PWD" 为止
+bool splitWifiConfig(std::string_view s, std::string_view& ssid, std::string_view& pwd) {
+    constexpr std::string_view SSID = "SSID";
+    constexpr std::string_view PWD = "PWD";
+    if (s.substr(0, SSID.size()) != SSID) {
+        return false;
+    }
+    s.remove_prefix(SSID.size());
+    const std::size_t pos = s.find(PWD);
+    if (pos == std::string_view::npos) {
+        return false;
+    }
+    ssid = s.substr(0, pos);
+    pwd = s.substr(pos + PWD.size());
+    return true;
+}
+
+} // namespace
+
+SerialPacketParser::SerialPacketParser(SerialPacketHandlers handlers) : handlers(std::move(handlers))
+{
+}
+
+void SerialPacketParser::reset()
+{
+    state = State::WAIT_START;
+    body_size = 0;
+}
+
+void SerialPacketParser::feed(const char* data, std::size_t size)
+{
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end) {
+        switch (state) {
+        case State::WAIT_START: {
+            const char* start = std::find(p, end, 'A');
+            if (start == end) {
+                return;
+            }
+            p = start + 1;
+            body_size = 0;
+            state = State::BODY;
+            break;
+        }
+        case State::BODY: {
+            // 整段拷贝到下一个 'B' 之前的内容
+            const char* stop = std::find(p, end, 'B');
+            const auto count = static_cast<std::size_t>(stop - p);
+            if (body_size + count > body_buffer.size()) {
+                // 超长说明丢失了结束符。包体里的 'A' 可能是下一个包的开头，从第一个 'A' 之后重新收集；
+                // 已缓存的部分没有 'A' 时从当前位置重新等待 'A'，不能直接跳到 'B' 把中间的包也丢掉
+                ++overflow_count;
+                char* const buffered_end = body_buffer.data() + body_size;
+                char* const restart = std::find(body_buffer.data(), buffered_end, 'A');
+                if (restart != buffered_end) {
+                    body_size = static_cast<std::size_t>(std::copy(restart + 1, buffered_end, body_buffer.data()) -
+                                                         body_buffer.data());
+                    break;
+                }
+                reset();
+                break;
+            }
+            std::copy(p, stop, body_buffer.data() + body_size);
+            body_size += count;
+            p = stop;
+            if (stop != end) {
+                ++p;
+                state = State::TYPE;
+            }
+            break;
+        }
+        case State::TYPE: {
+            const char type = *p++;
+            if (dispatch(std::string_view(body_buffer.data(), body_size), type)) {
+                ++packets_parsed;
+            } else {
+                ++packets_rejected;
+            }
+            reset();
+            break;
+        }
+        }
+    }
+}
+
+bool SerialPacketParser::dispatch(std::string_view body, char type)
+{
+    // 包体以类型字符开头，例如 A5...B5 的包体是 "5..."
+    if (body.empty() || body.front() != type) {
+        return false;
+    }
+    const std::string_view content = body.substr(1);
+    std::string_view ssid;
+    std::string_view pwd;
+    int value = 0;
+
+    switch (type) {
+    case '1':
+        if (content != "01") {
+            return false;
+        }
+        if (handlers.on_wifi_setup) {
+            handlers.on_wifi_setup();
+        }
+        return true;
+    case '2':
+        if (!splitWifiConfig(content, ssid, pwd)) {
+            return false;
+        }
+        if (handlers.on_wifi_config) {
+            handlers.on_wifi_config(ssid, pwd);
+        }
+        return true;
+    case '3':
+        if (content != "03") {
+            return false;
+        }
+        if (handlers.on_wifi_confirm) {
+            handlers.on_wifi_confirm();
+        }
+        return true;
+    case '4':
+        if (!splitWifiConfig(content, ssid, pwd)) {
+            return false;
+        }
+        if (handlers.on_wifi_connecting) {
+            handlers.on_wifi_connecting(ssid, pwd);
+        }
+        return true;
+    case '5':
+        return dispatchStatus(content);
+    case '6':
+        if (!parseSmallInt(content, value)) {
+            return false;
+        }
+        if (handlers.on_light_control) {
+            handlers.on_light_control(value);
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool SerialPacketParser::dispatchStatus(std::string_view content)
+{
+    constexpr std::string_view POWER = "POWER";
+    constexpr std::string_view VERSION = "VERSION";
+
+    // 亮度(1-3 位)和 IP 数字之间没有分隔符：亮度取前面最多 3 位，至少给 IP 留 1 位
+    const std::string_view digits = takeDigits(content);
+    if (digits.size() < 2) {
+        return false;
+    }
+    content.remove_prefix(digits.size());
+    if (content.substr(0, POWER.size()) != POWER) {
+        return false;
+    }
+    content.remove_prefix(POWER.size());
+    const std::string_view power_digits = takeDigits(content);
+    content.remove_prefix(power_digits.size());
+    if (content.substr(0, VERSION.size()) != VERSION) {
+        return false;
+    }
+    content.remove_prefix(VERSION.size());
+
+    DeviceStatusPacket status;
+    const std::size_t brightness_len = std::min<std::size_t>(3, digits.size() - 1);
+    if (!parseSmallInt(digits.substr(0, brightness_len), status.brightness) ||
+        !parseSmallInt(power_digits, status.power) ||
+        !parseSmallInt(content, status.version)) {
+        return false;
+    }
+
+    // IP 以 12 位数字传输（如 192168001100），不足 12 位时前面补 0，每 3 位一段并去掉前导 0
+    const std::string_view raw_ip = digits.substr(brightness_len);
+    std::array<char, 12> padded{};
+    std::fill(padded.begin(), padded.end(), '0');
+    const std::size_t used = std::min<std::size_t>(raw_ip.size(), padded.size());
+    if (raw_ip.size() < padded.size()) {
+        std::copy(raw_ip.begin(), raw_ip.end(), padded.end() - static_cast<std::ptrdiff_t>(used));
+    } else {
+        std::copy_n(raw_ip.begin(), used, padded.begin());
+    }
+    char* out = ip_buffer.data();
+    char* const out_end = ip_buffer.data() + ip_buffer.size();
+    for (int group = 0; group < 4; ++group) {
+        if (group > 0) {
+            *out++ = '.';
+        }
+        const int octet = (padded[group * 3] - '0') * 100 + (padded[group * 3 + 1] - '0') * 10 + (padded[group * 3 + 2] - '0');
+        out = std::to_chars(out, out_end, octet).ptr;
+    }
+    status.ip = std::string_view(ip_buffer.data(), static_cast<std::size_t>(out - ip_buffer.data()));
+
+    if (handlers.on_device_status) {
+        handlers.on_device_status(status);
+    }
+    return true;
+}
@@ -0,0 +1,215 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "shared_output.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "logger.hpp"
+
+namespace {
+
+uint32_t copyValues(float* dst, std::size_t capacity, const std::vector<float>& values)
+{
+    const std::size_t count = std::min(capacity, values.size());
+    std::copy_n(values.begin(), count, dst);
+    return static_cast<uint32_t>(count);
+}
+
+// 名字表与每一格一样用 seqlock 保护，读取方拷贝期间被改写时会重试。返回更新后的版本号
+uint32_t copyNames(pt_shm_layout* mapped, char (*table)[PT_SHM_NAME_LENGTH], std::size_t capacity,
+                   const std::vector<std::string>& names)
+{
+    std::atomic_ref<uint32_t> seq(mapped->names_seq);
+    const uint32_t start = seq.load(std::memory_order_relaxed);
+    seq.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < capacity; ++i) {
+        std::memset(table[i], 0, PT_SHM_NAME_LENGTH);
+        if (i < names.size()) {
+            std::memcpy(table[i], names[i].data(), std::min<std::size_t>(names[i].size(), PT_SHM_NAME_LENGTH - 1));
+        }
+    }
+    seq.store(start + 2, std::memory_order_release);
+    return start + 2;
+}
+
+} // namespace
+
+SharedOutputChannel& SharedOutputChannel::instance()
+{
+    static SharedOutputChannel channel;
+    return channel;
+}
+
+SharedOutputChannel::~SharedOutputChannel()
+{
+    close();
+}
+
+bool SharedOutputChannel::open()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (layout.load()) {
+        return true;
+    }
+
+    pt_shm_layout* mapped = nullptr;
+#ifdef _WIN32
+    HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                       sizeof(pt_shm_layout), PT_SHM_NAME);
+    if (!handle) {
+        LOG_ERROR("创建共享内存失败，错误码: {}", GetLastError());
+        return false;
+    }
+    mapped = static_cast<pt_shm_layout*>(MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(pt_shm_layout)));
+    if (!mapped) {
+        LOG_ERROR("映射共享内存失败，错误码: {}", GetLastError());
+        CloseHandle(handle);
+        return false;
+    }
+    mapping = handle;
+#else
+    const int fd = shm_open(PT_SHM_NAME, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        LOG_ERROR("创建共享内存失败: {}", PT_SHM_NAME);
+        return false;
+    }
+    if (ftruncate(fd, sizeof(pt_shm_layout)) != 0) {
+        LOG_ERROR("设置共享内存大小失败: {}", PT_SHM_NAME);
+        ::close(fd);
+        return false;
+    }
+    void* address = mmap(nullptr, sizeof(pt_shm_layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        LOG_ERROR("映射共享内存失败: {}", PT_SHM_NAME);
+        return false;
+    }
+    mapped = static_cast<pt_shm_layout*>(address);
+#endif
+
+    // 上次异常退出时残留的内容全部清掉，magic 最后写入，读取方看到 magic 时其余字段已就绪
+    std::memset(mapped, 0, sizeof(pt_shm_layout));
+    mapped->version = PT_SHM_VERSION;
+    mapped->ring_size = PT_SHM_RING_SIZE;
+    mapped->frame_size = sizeof(pt_shm_frame);
+    std::atomic_ref<uint32_t>(mapped->magic).store(PT_SHM_MAGIC, std::memory_order_release);
+
+    current = {};
+    frame_counter = 0;
+    face_names.clear();
+    eye_names.clear();
+    layout.store(mapped);
+    LOG_INFO("追踪结果共享内存已创建: {}", PT_SHM_NAME);
+    return true;
+}
+
+void SharedOutputChannel::close()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pt_shm_layout* mapped = layout.exchange(nullptr);
+    if (!mapped) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(mapped);
+    CloseHandle(static_cast<HANDLE>(mapping));
+    mapping = nullptr;
+#else
+    munmap(mapped, sizeof(pt_shm_layout));
+    // 已经打开的读取方仍保留映射，新的读取方会得到“未运行”
+    shm_unlink(PT_SHM_NAME);
+#endif
+}
+
+void SharedOutputChannel::publishFace(const std::vector<float>& values, const std::vector<std::string>& names)
+{
+    if (!layout.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    pt_shm_layout* mapped = layout.load();
+    if (!mapped) {
+        return;
+    }
+    if (face_names != names) {
+        current.names_version = copyNames(mapped, mapped->face_names, PT_SHM_MAX_FACE, names);
+        face_names = names;
+    }
+    current.face_count = copyValues(current.face, PT_SHM_MAX_FACE, values);
+    writeFrameLocked();
+}
+
+void SharedOutputChannel::publishEye(const std::vector<float>& values, const std::vector<std::string>& names)
+{
+    if (!layout.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    pt_shm_layout* mapped = layout.load();
+    if (!mapped) {
+        return;
+    }
+    if (eye_names != names) {
+        current.names_version = copyNames(mapped, mapped->eye_names, PT_SHM_MAX_EYE, names);
+        eye_names = names;
+    }
+    current.eye_count = copyValues(current.eye, PT_SHM_MAX_EYE, values);
+    writeFrameLocked();
+}
+
+void SharedOutputChannel::clearFace()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    current.face_count = 0;
+    face_names.clear();
+    pt_shm_layout* mapped = layout.load();
+    if (!mapped) {
+        return;
+    }
+    current.names_version = copyNames(mapped, mapped->face_names, PT_SHM_MAX_FACE, face_names);
+    // 立即写一帧，读取方不必等另一个窗口的下一次发布就能看到设备已断开
+    writeFrameLocked();
+}
+
+void SharedOutputChannel::clearEye()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    current.eye_count = 0;
+    eye_names.clear();
+    pt_shm_layout* mapped = layout.load();
+    if (!mapped) {
+        return;
+    }
+    current.names_version = copyNames(mapped, mapped->eye_names, PT_SHM_MAX_EYE, eye_names);
+    // 立即写一帧，读取方不必等另一个窗口的下一次发布就能看到设备已断开
+    writeFrameLocked();
+}
+
+void SharedOutputChannel::writeFrameLocked()
+{
+    pt_shm_layout* mapped = layout.load();
+    current.frame_id = ++frame_counter;
+    current.timestamp_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+
+    // seqlock：先把 seq 置为奇数再写数据，写完置为下一个偶数，读取方据此发现被覆盖的拷贝
+    pt_shm_slot& slot = mapped->slots[current.frame_id % PT_SHM_RING_SIZE];
+    std::atomic_ref<uint32_t> seq(slot.seq);
+    const uint32_t start = seq.load(std::memory_order_relaxed);
+    seq.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.frame, &current, sizeof(current));
+    seq.store(start + 2, std::memory_order_release);
+    std::atomic_ref<uint64_t>(mapped->latest_frame_id).store(current.frame_id, std::memory_order_release);
+}
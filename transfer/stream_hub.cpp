@@ -0,0 +1,163 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "stream_hub.hpp"
+#include <algorithm>
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include "image_downloader.hpp"
+#include "replay_stream.hpp"
+#include "udp_frame_receiver.hpp"
+#include "logger.hpp"
+#include "thread_policy.hpp"
+
+StreamHub& StreamHub::instance()
+{
+    static StreamHub hub;
+    return hub;
+}
+
+StreamHub::StreamHub()
+{
+    io_thread.setObjectName("StreamHub");
+    // 视频流的接收和 JPEG 解码都在网络线程上进行
+    QObject::connect(&io_thread, &QThread::started, []() { utils::ThreadPolicies::apply("decode"); });
+    io_thread.start();
+
+    // 定时器必须在它所属的线程里启动
+    heartbeat_timer = new QTimer();
+    heartbeat_timer->moveToThread(&io_thread);
+    QObject::connect(heartbeat_timer, &QTimer::timeout, heartbeat_timer, [this]() { tick(); });
+    QMetaObject::invokeMethod(heartbeat_timer, [this]() {
+        heartbeat_timer->start(HEARTBEAT_INTERVAL_MS);
+    }, Qt::QueuedConnection);
+
+    // 在事件循环结束前退出网络线程，避免静态析构时 QCoreApplication 已经销毁
+    if (QCoreApplication::instance()) {
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, [this]() {
+            shutdown();
+        });
+    }
+    LOG_DEBUG("视频流网络线程已启动");
+}
+
+StreamHub::~StreamHub()
+{
+    shutdown();
+}
+
+void StreamHub::shutdown()
+{
+    if (!io_thread.isRunning()) {
+        return;
+    }
+    QMetaObject::invokeMethod(heartbeat_timer, [this]() {
+        heartbeat_timer->stop();
+        delete heartbeat_timer;
+        heartbeat_timer = nullptr;
+    }, Qt::BlockingQueuedConnection);
+    io_thread.quit();
+    io_thread.wait();
+}
+
+std::shared_ptr<ESP32VideoStream> StreamHub::createStream()
+{
+    auto* stream = new ESP32VideoStream();
+    stream->setRecordDirectory(record_directory);
+    stream->moveToThread(&io_thread);
+    registerStream(stream);
+    return std::shared_ptr<ESP32VideoStream>(stream, [](ESP32VideoStream* s) {
+        auto& hub = StreamHub::instance();
+        hub.unregisterStream(s);
+        hub.destroyOnThread(s);
+    });
+}
+
+std::shared_ptr<UdpFrameReceiver> StreamHub::createUdpReceiver(quint16 port)
+{
+    auto* receiver = new UdpFrameReceiver(port);
+    receiver->moveToThread(&io_thread);
+    return std::shared_ptr<UdpFrameReceiver>(receiver, [](UdpFrameReceiver* r) {
+        StreamHub::instance().destroyOnThread(r);
+    });
+}
+
+void StreamHub::addReplaySource(const std::string& path, bool fast)
+{
+    OverrideSource source;
+    source.replay_path = path;
+    source.replay_fast = fast;
+    override_sources.push_back(std::move(source));
+}
+
+void StreamHub::addUdpSource(quint16 port)
+{
+    OverrideSource source;
+    source.udp_port = port;
+    override_sources.push_back(std::move(source));
+}
+
+std::shared_ptr<FrameSource> StreamHub::createOverrideSource(std::size_t index)
+{
+    if (index >= override_sources.size()) {
+        return nullptr;
+    }
+    const auto& config = override_sources[index];
+    if (config.udp_port != 0) {
+        auto receiver = createUdpReceiver(config.udp_port);
+        if (!receiver->start()) {
+            return nullptr;
+        }
+        LOG_INFO("使用 UDP 端口 {} 作为图像来源", config.udp_port);
+        return receiver;
+    }
+    auto replay = std::make_shared<ReplayStream>(
+        config.replay_path, config.replay_fast ? ReplayStream::Timing::AS_FAST_AS_POSSIBLE : ReplayStream::Timing::ORIGINAL);
+    if (!replay->start()) {
+        LOG_ERROR("无法打开回放文件: {}", config.replay_path);
+        return nullptr;
+    }
+    LOG_INFO("使用回放文件作为图像来源: {}{}", config.replay_path, config.replay_fast ? "（不限速）" : "");
+    return replay;
+}
+
+void StreamHub::destroyOnThread(QObject* object)
+{
+    if (io_thread.isRunning()) {
+        // 在网络线程上停止并销毁，套接字不能跨线程析构
+        object->deleteLater();
+    } else {
+        delete object;
+    }
+}
+
+void StreamHub::registerStream(ESP32VideoStream* stream)
+{
+    QMutexLocker locker(&streams_mutex);
+    streams.push_back(stream);
+}
+
+void StreamHub::unregisterStream(ESP32VideoStream* stream)
+{
+    QMutexLocker locker(&streams_mutex);
+    streams.erase(std::remove(streams.begin(), streams.end(), stream), streams.end());
+}
+
+void StreamHub::tick()
+{
+    QMutexLocker locker(&streams_mutex);
+    for (auto* stream : streams) {
+        if (stream->heartbeatEnabled()) {
+            stream->checkHeartBeat();
+        }
+    }
+}
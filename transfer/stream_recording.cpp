@@ -0,0 +1,312 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "stream_recording.hpp"
+#include <cstring>
+#include "logger.hpp"
+
+namespace {
+
+constexpr char FILE_MAGIC[8] = {'P', 'T', 'R', 'E', 'C', '0', '1', '\0'};
+constexpr char CHUNK_MAGIC[4] = {'C', 'H', 'N', 'K'};
+constexpr char INDEX_MAGIC[8] = {'P', 'T', 'R', 'I', 'D', 'X', '0', '1'};
+constexpr uint32_t FORMAT_VERSION = 1;
+
+constexpr std::size_t FILE_HEADER_SIZE = 16;
+constexpr std::size_t CHUNK_HEADER_SIZE = 16;
+constexpr std::size_t RECORD_HEADER_SIZE = 16;
+constexpr std::size_t INDEX_ENTRY_SIZE = 32;
+constexpr std::size_t FOOTER_SIZE = 24;
+
+// 所有支持的平台都是小端，直接按内存布局读写
+template<typename T>
+void put(std::vector<uint8_t>& out, T value) {
+    const auto* p = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+template<typename T>
+T get(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+StreamRecorder::~StreamRecorder()
+{
+    close();
+}
+
+bool StreamRecorder::open(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file.isOpen()) {
+        LOG_WARN("录制文件已经打开: {}", file.fileName().toStdString());
+        return false;
+    }
+    file.setFileName(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        LOG_ERROR("无法创建录制文件: {}: {}", path, file.errorString().toStdString());
+        return false;
+    }
+
+    std::vector<uint8_t> header(FILE_MAGIC, FILE_MAGIC + sizeof(FILE_MAGIC));
+    put<uint32_t>(header, FORMAT_VERSION);
+    put<uint32_t>(header, 0);
+    file.write(reinterpret_cast<const char*>(header.data()), static_cast<qint64>(header.size()));
+
+    start_time = std::chrono::steady_clock::now();
+    chunk_buffer.clear();
+    chunk_buffer.reserve(CHUNK_BYTES + RECORD_HEADER_SIZE);
+    current_chunk = {};
+    chunk_index.clear();
+    total_records = 0;
+    LOG_INFO("开始录制原始数据流: {}", path);
+    return true;
+}
+
+void StreamRecorder::close()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file.isOpen()) {
+        return;
+    }
+    flushChunk();
+
+    std::vector<uint8_t> trailer;
+    trailer.reserve(chunk_index.size() * INDEX_ENTRY_SIZE + FOOTER_SIZE);
+    const auto index_offset = static_cast<uint64_t>(file.pos());
+    for (const auto& chunk : chunk_index) {
+        put<uint64_t>(trailer, chunk.offset);
+        put<int64_t>(trailer, chunk.first_timestamp_us);
+        put<int64_t>(trailer, chunk.last_timestamp_us);
+        put<uint32_t>(trailer, chunk.record_count);
+        put<uint32_t>(trailer, 0);
+    }
+    put<uint64_t>(trailer, index_offset);
+    put<uint32_t>(trailer, static_cast<uint32_t>(chunk_index.size()));
+    put<uint32_t>(trailer, 0);
+    trailer.insert(trailer.end(), INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC));
+    file.write(reinterpret_cast<const char*>(trailer.data()), static_cast<qint64>(trailer.size()));
+
+    LOG_INFO("录制结束: {}，共 {} 条记录", file.fileName().toStdString(), total_records);
+    file.close();
+}
+
+bool StreamRecorder::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return file.isOpen();
+}
+
+void StreamRecorder::append(RecordType type, const void* data, std::size_t size)
+{
+    const auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file.isOpen()) {
+        return;
+    }
+    const auto timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(now - start_time).count();
+
+    if (current_chunk.record_count == 0) {
+        current_chunk.first_timestamp_us = timestamp_us;
+    }
+    current_chunk.last_timestamp_us = timestamp_us;
+    ++current_chunk.record_count;
+    ++total_records;
+
+    chunk_buffer.push_back(static_cast<uint8_t>(type));
+    chunk_buffer.insert(chunk_buffer.end(), 3, 0);
+    put<uint32_t>(chunk_buffer, static_cast<uint32_t>(size));
+    put<int64_t>(chunk_buffer, timestamp_us);
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    chunk_buffer.insert(chunk_buffer.end(), bytes, bytes + size);
+
+    if (chunk_buffer.size() >= CHUNK_BYTES) {
+        flushChunk();
+    }
+}
+
+uint64_t StreamRecorder::recordCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return total_records;
+}
+
+void StreamRecorder::flushChunk()
+{
+    if (current_chunk.record_count == 0) {
+        return;
+    }
+    current_chunk.offset = static_cast<uint64_t>(file.pos());
+
+    std::vector<uint8_t> header(CHUNK_MAGIC, CHUNK_MAGIC + sizeof(CHUNK_MAGIC));
+    put<uint32_t>(header, current_chunk.record_count);
+    put<uint64_t>(header, static_cast<uint64_t>(chunk_buffer.size()));
+    file.write(reinterpret_cast<const char*>(header.data()), static_cast<qint64>(header.size()));
+    if (file.write(reinterpret_cast<const char*>(chunk_buffer.data()),
+                   static_cast<qint64>(chunk_buffer.size())) != static_cast<qint64>(chunk_buffer.size())) {
+        LOG_ERROR("写入录制文件失败: {}", file.errorString().toStdString());
+    }
+    file.flush();
+
+    chunk_index.push_back(current_chunk);
+    current_chunk = {};
+    chunk_buffer.clear();
+}
+
+StreamRecording::~StreamRecording()
+{
+    close();
+}
+
+bool StreamRecording::open(const std::string& path)
+{
+    close();
+    file.setFileName(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        LOG_ERROR("无法打开录制文件: {}: {}", path, file.errorString().toStdString());
+        return false;
+    }
+    mapped_size = static_cast<uint64_t>(file.size());
+    if (mapped_size < FILE_HEADER_SIZE) {
+        LOG_ERROR("录制文件过短: {}", path);
+        close();
+        return false;
+    }
+    mapped = file.map(0, static_cast<qint64>(mapped_size));
+    if (!mapped) {
+        LOG_ERROR("无法映射录制文件: {}: {}", path, file.errorString().toStdString());
+        close();
+        return false;
+    }
+    if (std::memcmp(mapped, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+        get<uint32_t>(mapped + sizeof(FILE_MAGIC)) != FORMAT_VERSION) {
+        LOG_ERROR("不是有效的录制文件: {}", path);
+        close();
+        return false;
+    }
+
+    if (!readIndex()) {
+        LOG_WARN("录制文件缺少索引，顺序扫描恢复: {}", path);
+        record_views.clear();
+        scanChunks();
+    }
+    LOG_INFO("已加载录制文件: {}，共 {} 条记录，时长 {} 秒", path, record_views.size(),
+             durationUs() / 1000000.0);
+    return true;
+}
+
+void StreamRecording::close()
+{
+    record_views.clear();
+    if (mapped) {
+        file.unmap(const_cast<uchar*>(mapped));
+        mapped = nullptr;
+    }
+    mapped_size = 0;
+    if (file.isOpen()) {
+        file.close();
+    }
+}
+
+int64_t StreamRecording::durationUs() const
+{
+    if (record_views.empty()) {
+        return 0;
+    }
+    return record_views.back().timestamp_us - record_views.front().timestamp_us;
+}
+
+bool StreamRecording::readIndex()
+{
+    if (mapped_size < FILE_HEADER_SIZE + FOOTER_SIZE) {
+        return false;
+    }
+    const uint8_t* footer = mapped + mapped_size - FOOTER_SIZE;
+    if (std::memcmp(footer + 16, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        return false;
+    }
+    const auto index_offset = get<uint64_t>(footer);
+    const auto chunk_count = get<uint32_t>(footer + 8);
+    if (index_offset + static_cast<uint64_t>(chunk_count) * INDEX_ENTRY_SIZE + FOOTER_SIZE != mapped_size) {
+        return false;
+    }
+
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < chunk_count; ++i) {
+        total += get<uint32_t>(mapped + index_offset + i * INDEX_ENTRY_SIZE + 24);
+    }
+    record_views.reserve(total);
+    for (uint32_t i = 0; i < chunk_count; ++i) {
+        const auto offset = get<uint64_t>(mapped + index_offset + i * INDEX_ENTRY_SIZE);
+        uint64_t next = 0;
+        if (offset >= index_offset || !readChunk(offset, &next) || next > index_offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StreamRecording::scanChunks()
+{
+    uint64_t offset = FILE_HEADER_SIZE;
+    while (offset + CHUNK_HEADER_SIZE <= mapped_size &&
+           std::memcmp(mapped + offset, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) == 0) {
+        uint64_t next = 0;
+        if (!readChunk(offset, &next)) {
+            // 最后一个数据块写了一半，丢弃
+            break;
+        }
+        offset = next;
+    }
+    return !record_views.empty();
+}
+
+bool StreamRecording::readChunk(uint64_t offset, uint64_t* next_offset)
+{
+    if (offset + CHUNK_HEADER_SIZE > mapped_size ||
+        std::memcmp(mapped + offset, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0) {
+        return false;
+    }
+    const auto record_count = get<uint32_t>(mapped + offset + 4);
+    const auto payload_bytes = get<uint64_t>(mapped + offset + 8);
+    const uint64_t begin = offset + CHUNK_HEADER_SIZE;
+    const uint64_t end = begin + payload_bytes;
+    if (end > mapped_size) {
+        return false;
+    }
+
+    const std::size_t first_record = record_views.size();
+    uint64_t pos = begin;
+    for (uint32_t i = 0; i < record_count; ++i) {
+        if (pos + RECORD_HEADER_SIZE > end) {
+            record_views.resize(first_record);
+            return false;
+        }
+        RecordView view{};
+        view.type = static_cast<RecordType>(mapped[pos]);
+        view.size = get<uint32_t>(mapped + pos + 4);
+        view.timestamp_us = get<int64_t>(mapped + pos + 8);
+        view.data = mapped + pos + RECORD_HEADER_SIZE;
+        pos += RECORD_HEADER_SIZE + view.size;
+        if (pos > end) {
+            record_views.resize(first_record);
+            return false;
+        }
+        record_views.push_back(view);
+    }
+    *next_offset = end;
+    return true;
+}
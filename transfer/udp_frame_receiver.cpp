@@ -0,0 +1,247 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "udp_frame_receiver.hpp"
+#include <algorithm>
+#include <opencv2/imgcodecs.hpp>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include "udp_frame_protocol.hpp"
+#include "logger.hpp"
+
+UdpFrameReceiver::UdpFrameReceiver(quint16 port, QObject* parent)
+    : QObject(parent), port(port)
+{
+    datagram.resize(udp_frame::HEADER_SIZE + udp_frame::MAX_PAYLOAD + 64);
+}
+
+UdpFrameReceiver::~UdpFrameReceiver()
+{
+    stop();
+}
+
+bool UdpFrameReceiver::start()
+{
+    if (QThread::currentThread() != thread() && thread()->isRunning()) {
+        bool result = false;
+        QMetaObject::invokeMethod(this, [&]() { result = start(); }, Qt::BlockingQueuedConnection);
+        return result;
+    }
+    if (socket) {
+        LOG_WARN("UDP 接收已经在运行中");
+        return false;
+    }
+    socket = new QUdpSocket(this);
+    if (!socket->bind(QHostAddress::Any, port)) {
+        LOG_ERROR("UDP 端口 {} 绑定失败: {}", port, socket->errorString().toStdString());
+        socket->deleteLater();
+        socket = nullptr;
+        return false;
+    }
+    // 接收缓冲区放大一些，避免突发的整帧分片在系统层被丢弃
+    socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 1 << 20);
+    connect(socket, &QUdpSocket::readyRead, this, &UdpFrameReceiver::onReadyRead);
+
+    expire_timer = new QTimer(this);
+    connect(expire_timer, &QTimer::timeout, this, &UdpFrameReceiver::expireSlots);
+    expire_timer->start(EXPIRE_CHECK_INTERVAL_MS);
+
+    for (auto& slot : slots) {
+        slot.in_use = false;
+    }
+    has_published = false;
+    LOG_INFO("UDP 图像接收已启动，端口 {}", port);
+    return true;
+}
+
+void UdpFrameReceiver::stop()
+{
+    if (QThread::currentThread() != thread() && thread()->isRunning()) {
+        QMetaObject::invokeMethod(this, [this]() { stop(); }, Qt::BlockingQueuedConnection);
+        return;
+    }
+    receiving = false;
+    if (expire_timer) {
+        expire_timer->stop();
+        expire_timer->deleteLater();
+        expire_timer = nullptr;
+    }
+    if (socket) {
+        socket->close();
+        socket->deleteLater();
+        socket = nullptr;
+    }
+    frame_slot.clear();
+}
+
+UdpReceiveStats UdpFrameReceiver::getStats() const
+{
+    UdpReceiveStats stats;
+    stats.packets_received = packets_received.load(std::memory_order_relaxed);
+    stats.packets_malformed = packets_malformed.load(std::memory_order_relaxed);
+    stats.fragments_duplicate = fragments_duplicate.load(std::memory_order_relaxed);
+    stats.frames_completed = frames_completed.load(std::memory_order_relaxed);
+    stats.frames_incomplete = frames_incomplete.load(std::memory_order_relaxed);
+    stats.frames_late = frames_late.load(std::memory_order_relaxed);
+    stats.fragments_lost = fragments_lost.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void UdpFrameReceiver::onReadyRead()
+{
+    while (socket && socket->hasPendingDatagrams()) {
+        const qint64 size = socket->readDatagram(datagram.data(), static_cast<qint64>(datagram.size()));
+        if (size <= 0) {
+            continue;
+        }
+        handlePacket(reinterpret_cast<const uint8_t*>(datagram.data()), static_cast<std::size_t>(size));
+    }
+}
+
+void UdpFrameReceiver::handlePacket(const uint8_t* data, std::size_t size)
+{
+    packets_received.fetch_add(1, std::memory_order_relaxed);
+    udp_frame::Header header;
+    if (!udp_frame::readHeader(data, size, &header)) {
+        packets_malformed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    receiving = true;
+
+    // 比已发布的帧更旧的分片没有意义，直接丢弃
+    if (!(header.flags & udp_frame::FLAG_TEXT) && has_published && !isNewer(header.frame_id, last_published_id)) {
+        if (last_published_id - header.frame_id <= RESYNC_GAP) {
+            return;
+        }
+        // 编号倒退太多说明发送端重启了，重新同步
+        LOG_INFO("UDP 发送端帧编号重置，重新同步");
+        has_published = false;
+    }
+
+    ReassemblySlot* slot = acquireSlot(header.frame_id, header.flags);
+    if (!slot->in_use) {
+        slot->in_use = true;
+        slot->frame_id = header.frame_id;
+        slot->flags = header.flags;
+        slot->frame_size = header.frame_size;
+        slot->fragment_count = header.fragment_count;
+        slot->fragments_received = 0;
+        slot->first_arrival = std::chrono::steady_clock::now();
+        slot->buffer.resize(header.frame_size);
+        slot->received.assign(header.fragment_count, false);
+    } else if (slot->frame_size != header.frame_size || slot->fragment_count != header.fragment_count) {
+        packets_malformed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (slot->received[header.fragment_index]) {
+        fragments_duplicate.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const std::size_t offset = static_cast<std::size_t>(header.fragment_index) * udp_frame::MAX_PAYLOAD;
+    std::copy(data + udp_frame::HEADER_SIZE, data + size, slot->buffer.begin() + static_cast<std::ptrdiff_t>(offset));
+    slot->received[header.fragment_index] = true;
+    if (++slot->fragments_received == slot->fragment_count) {
+        completeFrame(*slot);
+    }
+}
+
+UdpFrameReceiver::ReassemblySlot* UdpFrameReceiver::acquireSlot(uint32_t frame_id, uint8_t flags)
+{
+    ReassemblySlot* free_slot = nullptr;
+    ReassemblySlot* oldest = nullptr;
+    for (auto& slot : slots) {
+        if (slot.in_use && slot.frame_id == frame_id && slot.flags == flags) {
+            return &slot;
+        }
+        if (!slot.in_use) {
+            if (!free_slot) {
+                free_slot = &slot;
+            }
+        } else if (!oldest || slot.first_arrival < oldest->first_arrival) {
+            oldest = &slot;
+        }
+    }
+    if (free_slot) {
+        return free_slot;
+    }
+    // 槽位用完，淘汰最早开始拼装的一帧
+    discardSlot(*oldest);
+    frames_incomplete.fetch_add(1, std::memory_order_relaxed);
+    return oldest;
+}
+
+void UdpFrameReceiver::completeFrame(ReassemblySlot& slot)
+{
+    slot.in_use = false;
+    if (slot.flags & udp_frame::FLAG_TEXT) {
+        handleTextMessage(slot.buffer.data(), slot.buffer.size());
+        return;
+    }
+
+    // 更旧的帧已经没有机会发布了
+    for (auto& other : slots) {
+        if (other.in_use && !(other.flags & udp_frame::FLAG_TEXT) && isNewer(slot.frame_id, other.frame_id)) {
+            discardSlot(other);
+            frames_late.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    has_published = true;
+    last_published_id = slot.frame_id;
+
+    if (jpeg_validator.validate(slot.buffer.data(), slot.buffer.size(), nullptr) != JpegRejectReason::NONE) {
+        return;
+    }
+    const cv::Mat encoded(1, static_cast<int>(slot.buffer.size()), CV_8UC1, slot.buffer.data());
+    cv::Mat frame = cv::imdecode(encoded, cv::IMREAD_COLOR);
+    if (frame.empty()) {
+        jpeg_validator.reject(JpegRejectReason::DECODE_FAILED);
+        return;
+    }
+    frame_slot.publish(std::move(frame));
+    frames_completed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UdpFrameReceiver::discardSlot(ReassemblySlot& slot)
+{
+    fragments_lost.fetch_add(slot.fragment_count - slot.fragments_received, std::memory_order_relaxed);
+    slot.in_use = false;
+}
+
+void UdpFrameReceiver::expireSlots()
+{
+    const auto now = std::chrono::steady_clock::now();
+    for (auto& slot : slots) {
+        if (slot.in_use && now - slot.first_arrival > reassembly_deadline) {
+            discardSlot(slot);
+            frames_incomplete.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void UdpFrameReceiver::handleTextMessage(const uint8_t* data, std::size_t size)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(reinterpret_cast<const char*>(data),
+                                                                         static_cast<qsizetype>(size)));
+    if (!doc.isObject()) {
+        return;
+    }
+    QJsonObject obj = doc.object();
+    if (obj.contains("battery")) {
+        battery_percentage = static_cast<float>(obj["battery"].toDouble());
+    }
+    if (obj.contains("brightness")) {
+        brightness_value = obj["brightness"].toInt();
+    }
+    hardware_version = obj.contains("hardware_version") ? obj["hardware_version"].toInt() : -1;
+}
@@ -15,6 +15,8 @@
 #include <QFontMetrics>
 
 #include "opencv2/imgcodecs.hpp"
+#include "stream_hub.hpp"
+#include "shared_output.hpp"
 
 static bool is_show_tip[EYE_NUM] = {false, false};
 
@@ -150,14 +152,18 @@ PaperEyeTrackerWindow::PaperEyeTrackerWindow(QWidget* parent) :
 
     // 初始化串口和wifi
     for (int i = 0; i < EYE_NUM; i++) {
-        image_stream[i] = std::make_shared<ESP32VideoStream>();
+        image_stream[i] = StreamHub::instance().createStream();
     }
+    // 只指定了一个替代来源时左右眼共用同一个
+    override_source[LEFT_TAG] = StreamHub::instance().createOverrideSource(0);
+    override_source[RIGHT_TAG] = StreamHub::instance().overrideSourceCount() > 1
+                                     ? StreamHub::instance().createOverrideSource(1)
+                                     : override_source[LEFT_TAG];
     serial_port_ = std::make_shared<SerialPortManager>();
 
     serial_port_->init();
     // init serial port manager
-    serial_port_->registerCallback(
-        PACKET_DEVICE_STATUS,
+    serial_port_->registerDeviceStatusCallback(
         [this](const std::string& ip, int brightness, int power, int version) {
             current_esp32_version = version;
             if (version != LEFT_VERSION && version != RIGHT_VERSION) {
@@ -186,61 +192,10 @@ PaperEyeTrackerWindow::PaperEyeTrackerWindow(QWidget* parent) :
     );
 
 
-    while (serial_port_->status() == SerialStatus::CLOSED) {}
-
-    if (serial_port_->status() == SerialStatus::FAILED) {
-        LOG_WARN("没有检测到眼追设备，尝试从配置文件中读取地址...");
-        if (!config.left_ip.empty()) {
-            LOG_INFO("从配置文件中读取左眼地址成功");
-            current_ip[LEFT_TAG] = config.left_ip;
-            start_image_download(LEFT_TAG);
-        }
-        else {
-            QMessageBox msgBox;
-            msgBox.setWindowIcon(this->windowIcon());
-            msgBox.setText(QApplication::translate("PaperTrackerMainWindow","未找到左眼配置文件信息，请将设备通过数据线连接到电脑进行首次配置"));
-            msgBox.exec();
-        }
-        if (!config.right_ip.empty()) {
-            LOG_INFO("从配置文件中读取右眼地址成功");
-            current_ip[RIGHT_TAG] = config.right_ip;
-            start_image_download(RIGHT_TAG);
-        }
-        else {
-            QMessageBox msgBox;
-            msgBox.setWindowIcon(this->windowIcon());
-            msgBox.setText(QApplication::translate("PaperTrackerMainWindow","未找到右眼配置文件信息，请将设备通过数据线连接到电脑进行首次配置"));
-            msgBox.exec();
-        }
-    }
-    else {
-        if (current_ip[LEFT_TAG].empty() && !config.left_ip.empty()) {
-            current_ip[LEFT_TAG] = config.left_ip;
-            start_image_download(LEFT_TAG);
-        }
-        else {
-            if (config.left_ip.empty()) {
-                QMessageBox msgBox;
-                msgBox.setWindowIcon(this->windowIcon());
-                msgBox.setText(QApplication::translate("PaperTrackerMainWindow","未找到左眼配置文件信息，请将设备通过数据线连接到电脑进行首次配置"));
-                msgBox.exec();
-            }
-        }
-        if (current_ip[RIGHT_TAG].empty() && !config.right_ip.empty()) {
-            current_ip[RIGHT_TAG] = config.right_ip;
-            start_image_download(RIGHT_TAG);
-        }
-        else {
-            if (config.right_ip.empty()) {
-                QMessageBox msgBox;
-                msgBox.setWindowIcon(this->windowIcon());
-                msgBox.setText(QApplication::translate("PaperTrackerMainWindow","未找到右眼配置文件信息，请将设备通过数据线连接到电脑进行首次配置"));
-                msgBox.exec();
-            }
-        }
-        LOG_INFO("有线模式眼追连接成功");
-        setSerialStatusLabel("有线模式眼追连接成功");
-    }
+    // 设备枚举在后台进行，首次枚举完成后再决定是否回退到配置文件中的地址
+    serial_port_->registerConnectionCallback([this](bool connected) {
+        onSerialConnectionChanged(connected);
+    });
 
     // 初始化滚动条的值
     LeftRotateBar->setValue(current_rotate_angle[LEFT_TAG]);
@@ -253,9 +208,21 @@ PaperEyeTrackerWindow::PaperEyeTrackerWindow(QWidget* parent) :
     // 创建自动保存配置的定时器
     auto_save_timer = new QTimer(this);
     connect(auto_save_timer, &QTimer::timeout, this, [this]() {
+        // 上一次还没写完时跳过这一轮，避免两个任务同时写同一个文件
+        if (auto_save_result.valid() &&
+            auto_save_result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
         config = generate_config();
-        config_writer->write_config(config);
-        LOG_DEBUG("眼追配置已自动保存");
+        // 界面线程只生成配置，写文件交给后台线程池，磁盘慢时界面不会卡顿
+        auto_save_result = utils::background_pool().submit_with_priority(utils::TaskPriority::LOW,
+            [writer = config_writer, snapshot = config]() {
+                if (writer->write_config(snapshot)) {
+                    LOG_DEBUG("眼追配置已自动保存");
+                } else {
+                    LOG_WARN("眼追配置自动保存失败");
+                }
+            });
     });
     auto_save_timer->start(10000); // 10000毫秒 = 10秒
     // 根据配置文件设置校准状态
@@ -271,7 +238,7 @@ PaperEyeTrackerWindow::PaperEyeTrackerWindow(QWidget* parent) :
     this, &PaperEyeTrackerWindow::retranslateUI);
 }
 
-void PaperEyeTrackerWindow::setVideoImage(int version, const cv::Mat& image) {
+void PaperEyeTrackerWindow::setVideoImage(int version, cv::Mat image) {
     auto image_label = version == LEFT_TAG ? LeftEyeImage : RightEyeImage;
     auto setting_image_label = version == LEFT_TAG ?
         page_2->findChild<QLabel*>("leftEyeVideoLabel") :
@@ -290,7 +257,8 @@ void PaperEyeTrackerWindow::setVideoImage(int version, const cv::Mat& image) {
         return;
     }
 
-    QMetaObject::invokeMethod(this, [this, image = image.clone(), image_label, setting_image_label]() {
+    // image 由调用方交出，不再拷贝一次
+    QMetaObject::invokeMethod(this, [this, image = std::move(image), image_label, setting_image_label]() {
         auto qimage = QImage(image.data, image.cols, image.rows, image.step, QImage::Format_RGB888);
         auto pix_map = QPixmap::fromImage(qimage);
 
@@ -310,290 +278,206 @@ void PaperEyeTrackerWindow::setVideoImage(int version, const cv::Mat& image) {
 
 void PaperEyeTrackerWindow::create_sub_thread() {
     for (int i = 0; i < EYE_NUM; i++) {
-        update_ui_thread[i] = std::thread([this, version = i]() {
-            auto last_time = std::chrono::high_resolution_clock::now();
-            double fps_total = 0;
-            double fps_count = 0;
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            while (is_running()) {
-                updateWifiLabel(version);
-                updateBatteryStatus(version);
-                checkHardwareVersion(version);
-                updateSerialLabel(current_esp32_version);
-                auto start_time = std::chrono::high_resolution_clock::now();
-                try {
-                    if (fps_total > 1000) {
-                        fps_count = 0;
-                        fps_total = 0;
-                    }
-                    // caculate fps
-                    auto start = std::chrono::high_resolution_clock::now();
-                    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(start - last_time);
-                    last_time = start;
-                    auto fps = 1000.0 / static_cast<double>(duration.count());
-                    fps_total += fps;
-                    fps_count += 1;
-                    fps = fps_total / fps_count;
-                    cv::Mat frame = getVideoImage(version);
-                    // draw rect on frame
-                    cv::Mat show_image;
-                    if (!frame.empty()) {
-                        cv::resize(frame, frame, cv::Size(LeftEyeImage->size().width(), LeftEyeImage->size().height()), cv::INTER_NEAREST);
-                        {
-                            // 添加旋转处理
-                            auto rotate_angle = getRotateAngle(version);
-                            if (rotate_angle != 0) {
-                                int y = frame.rows / 2;
-                                int x = frame.cols / 2;
-                                auto rotate_matrix = cv::getRotationMatrix2D(cv::Point(x, y), rotate_angle, 1);
-                                cv::warpAffine(frame, frame, rotate_matrix, frame.size(), cv::INTER_NEAREST);
-                            }
-                            std::lock_guard<std::mutex> lock_guard(outputs_mutex[version]);
-                            if (!outputs[version].empty()) {
-                                for (int j = 0; j < EYE_OUTPUT_SIZE; j += 2) {
-                                    cv::Point2f point;
-                                    point.x = outputs[version][j];
-                                    point.y = outputs[version][j + 1];
-                                    if (j == EYE_OUTPUT_SIZE - 2) {
-                                        cv::circle(frame, point, 2, cv::Scalar(0, 255, 0), 2);
-                                    }
-                                    else {
-                                        // draw eye points
-                                        cv::circle(frame, point, 2, cv::Scalar(0, 0, 255), 2);
-                                    }
+        const std::string side = i == LEFT_TAG ? "left" : "right";
+        pipeline.addStage(side + " preview", {[this]() { return static_cast<double>(min(get_max_fps() + 30, 50)); }, std::chrono::milliseconds(100), "preview"},
+            [this, version = i](utils::StageContext&) {
+            updateWifiLabel(version);
+            updateBatteryStatus(version);
+            checkHardwareVersion(version);
+            updateSerialLabel(current_esp32_version);
+            try {
+                // 窗口不可见时不做预览，变换只由推理阶段按需计算
+                if (!preview_visible.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                // 变换结果和推理阶段共享，特征点和 ROI 框画在预览自己的拷贝上。
+                // 和推理使用同一个尺寸，特征点坐标不需要换算，显示时由标签缩放
+                cv::Mat frame = getTransformedImage(version);
+                cv::Mat show_image;
+                if (!frame.empty()) {
+                    frame = frame.clone();
+                    {
+                        EyeLandmarks latest;
+                        landmarks[version].load(latest);
+                        if (latest.valid) {
+                            const auto& points = latest.points;
+                            for (int j = 0; j < EYE_OUTPUT_SIZE; j += 2) {
+                                cv::Point2f point;
+                                point.x = points[j];
+                                point.y = points[j + 1];
+                                if (j == EYE_OUTPUT_SIZE - 2) {
+                                    cv::circle(frame, point, 2, cv::Scalar(0, 255, 0), 2);
                                 }
-                                for (int j = 0; j < EYE_OUTPUT_SIZE - 2; j += 2) {
-                                    cv::Point2f point;
-                                    point.x = outputs[version][j];
-                                    point.y = outputs[version][j + 1];
-                                    cv::Point2f next_point;
-                                    next_point.x = outputs[version][(j + 2) % (EYE_OUTPUT_SIZE - 2)];
-                                    next_point.y = outputs[version][(j + 3) % (EYE_OUTPUT_SIZE - 2)];
-                                    cv::line(frame, point, next_point, cv::Scalar(0, 255, 0), 2);
+                                else {
+                                    // draw eye points
+                                    cv::circle(frame, point, 2, cv::Scalar(0, 0, 255), 2);
                                 }
                             }
+                            for (int j = 0; j < EYE_OUTPUT_SIZE - 2; j += 2) {
+                                cv::Point2f point;
+                                point.x = points[j];
+                                point.y = points[j + 1];
+                                cv::Point2f next_point;
+                                next_point.x = points[(j + 2) % (EYE_OUTPUT_SIZE - 2)];
+                                next_point.y = points[(j + 3) % (EYE_OUTPUT_SIZE - 2)];
+                                cv::line(frame, point, next_point, cv::Scalar(0, 255, 0), 2);
+                            }
                         }
-                        cv::rectangle(frame, roi_rect[version].rect, cv::Scalar(0, 255, 0), 2);
-                        show_image = frame;
                     }
-                    setVideoImage(version, show_image);
-                    // 控制帧率
-                }
-                catch (const std::exception& e) {
-                    // 使用Qt方式记录日志，而不是minilog
-                    QMetaObject::invokeMethod(this, [&e]() {
-                        LOG_ERROR("错误, 视频处理异常: {}", e.what());
-                        }, Qt::QueuedConnection);
+                    cv::rectangle(frame, roi_rect[version].rect, cv::Scalar(0, 255, 0), 2);
+                    show_image = std::move(frame);
                 }
-                auto end_time = std::chrono::high_resolution_clock::now();
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-                int delay_ms = max(0, static_cast<int>(1000.0 / min(get_max_fps() + 30, 50) - elapsed));
-                // LOG_DEBUG("UIFPS:" +  std::to_string(min(get_max_fps() + 30, 60)));
-                std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+                setVideoImage(version, std::move(show_image));
+                // 控制帧率
+            }
+            catch (const std::exception& e) {
+                // 使用Qt方式记录日志，而不是minilog
+                QMetaObject::invokeMethod(this, [&e]() {
+                    LOG_ERROR("错误, 视频处理异常: {}", e.what());
+                    }, Qt::QueuedConnection);
             }
             });
 
-        inference_thread[i] = std::thread([this, version = i]() {
-            auto last_time = std::chrono::high_resolution_clock::now();
-            double fps_total = 0;
-            double fps_count = 0;
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            while (is_running()) {
-                if (fps_total > 1000) {
-                    fps_count = 0;
-                    fps_total = 0;
+        pipeline.addStage(side + " infer", {[this]() { return static_cast<double>(get_max_fps()); }, std::chrono::milliseconds(100), "inference"},
+            [this, version = i](utils::StageContext& context) {
+            // 设置时间序列
+            inference_[version]->set_dt(context.interval());
+
+            const cv::Mat frame = getTransformedImage(version);
+            // 推理处理
+            if (!frame.empty()) {
+                // 变换结果和预览阶段共享，推理只读取，不需要拷贝
+                cv::Mat infer_frame = frame;
+                auto roi_rect = getRoiRect(version);
+                if (!roi_rect.rect.empty() && roi_rect.is_roi_end) {
+                    infer_frame = frame(roi_rect.rect);
                 }
-                // calculate fps
-                auto start = std::chrono::high_resolution_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(start - last_time);
-                last_time = start;
-                auto fps = 1000.0 / static_cast<double>(duration.count());
-                fps_total += fps;
-                fps_count += 1;
-                fps = fps_total / fps_count;
-                // LOG_DEBUG("模型FPS： {}", fps);
-
-                auto start_time = std::chrono::high_resolution_clock::now();
-                // 设置时间序列
-                inference_[version]->set_dt(duration.count() / 1000.0);
-
-                auto frame = getVideoImage(version);
-                // 推理处理
-                if (!frame.empty()) {
-                    auto rotate_angle = getRotateAngle(version);
-                    cv::resize(frame, frame, cv::Size(350, 259), cv::INTER_NEAREST);
-                    int y = frame.rows / 2;
-                    int x = frame.cols / 2;
-                    auto rotate_matrix = cv::getRotationMatrix2D(cv::Point(x, y), rotate_angle, 1);
-                    cv::warpAffine(frame, frame, rotate_matrix, frame.size(), cv::INTER_NEAREST);
-                    cv::Mat infer_frame;
-                    infer_frame = frame.clone();
-                    auto roi_rect = getRoiRect(version);
-                    if (!roi_rect.rect.empty() && roi_rect.is_roi_end) {
-                        infer_frame = infer_frame(roi_rect.rect);
-                    }
-                    if (version == LEFT_TAG) {
-                    // 水平翻转图像（沿y轴对称）
-                    cv::flip(infer_frame, infer_frame, 1);  // 参数1表示水平翻转
-                    }
-                    inference_[version]->inference(infer_frame);
-                    auto temp = inference_[version]->get_output();
-                    if (temp.empty()) {
-                        continue;
+                if (version == LEFT_TAG) {
+                    // 水平翻转图像（沿y轴对称），写入新的 Mat，不改动共享的帧
+                    cv::Mat flipped;
+                    cv::flip(infer_frame, flipped, 1);  // 参数1表示水平翻转
+                    infer_frame = flipped;
+                }
+                inference_[version]->inference(infer_frame);
+                auto temp = inference_[version]->get_output();
+                if (temp.empty()) {
+                    return;
+                }
+                if (version == LEFT_TAG) {
+                    // 对每个坐标点进行处理
+                    for (int j = 0; j < temp.size(); j += 2) {
+                        // 只调整x坐标 (水平翻转)
+                        temp[j] = 1.0f - temp[j];  // 图像宽度减去x坐标值
                     }
-                    if (version == LEFT_TAG) {
-                        // 对每个坐标点进行处理
-                        for (int j = 0; j < temp.size(); j += 2) {
-                            // 只调整x坐标 (水平翻转)
-                            temp[j] = 1.0f - temp[j];  // 图像宽度减去x坐标值
-                        }
+                }
+                {
+                    outputs[version] = temp;
+                    EyeLandmarks published;
+                    for (int j = 0; j < EYE_OUTPUT_SIZE; j += 2) {
+                        outputs[version][j] = outputs[version][j] * roi_rect.rect.width + roi_rect.rect.x;
+                        outputs[version][j + 1] = outputs[version][j + 1] * roi_rect.rect.height + roi_rect.rect.y;
+                        published.points[j] = outputs[version][j];
+                        published.points[j + 1] = outputs[version][j + 1];
                     }
-                    {
-                        std::lock_guard<std::mutex> lock_guard(outputs_mutex[version]);
-                        outputs[version] = temp;
-                        for (int j = 0; j < EYE_OUTPUT_SIZE; j += 2) {
-                            outputs[version][j] = outputs[version][j] * roi_rect.rect.width + roi_rect.rect.x;
-                            outputs[version][j + 1] = outputs[version][j + 1] * roi_rect.rect.height + roi_rect.rect.y;
-                        }
+                    published.valid = true;
+                    landmarks[version].store(published);
+                }
+                // 后处理逻辑
+                double dist_1 = cv::norm(outputs[version][1] - outputs[version][3]);
+                double dist_2 = cv::norm(outputs[version][2] - outputs[version][4]);
+                double dist = (dist_1 + dist_2) / 2;
+                {
+                std::lock_guard<std::mutex> lock_guard(results_mutex[version]);
+
+                    // 原始眼睛开合度值，不再使用百分位计算
+                    eye_open[version] = dist;
+
+                    // 处理瞳孔位置
+                    pupil[version].x = outputs[version][EYE_OUTPUT_SIZE - 2];
+                    pupil[version].y = outputs[version][EYE_OUTPUT_SIZE - 1];
+
+                    EyeResult result;
+                    result.eye_open = dist;
+                    result.pupil_x = pupil[version].x;
+                    result.pupil_y = pupil[version].y;
+                    result.time = std::chrono::steady_clock::now();
+                    eye_results[version].store(result);
+
+                    // 记录校准数据
+                    if (is_calibrating) {
+                        // 只更新位置校准数据
+                        eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
+                        eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
+                        eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
+                        eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
                     }
-                    // 后处理逻辑
-                    double dist_1 = cv::norm(outputs[version][1] - outputs[version][3]);
-                    double dist_2 = cv::norm(outputs[version][2] - outputs[version][4]);
-                    double dist = (dist_1 + dist_2) / 2;
-                    {
-                    std::lock_guard<std::mutex> lock_guard(results_mutex[version]);
-
-                        // 原始眼睛开合度值，不再使用百分位计算
-                        eye_open[version] = dist;
-
-                        // 处理瞳孔位置
-                        pupil[version].x = outputs[version][EYE_OUTPUT_SIZE - 2];
-                        pupil[version].y = outputs[version][EYE_OUTPUT_SIZE - 1];
-
-                        // 记录校准数据
-                        if (is_calibrating) {
-                            // 只更新位置校准数据
-                            eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
-                            eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
-                            eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
-                            eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
-                        }
 
 
-                    // 同时更新坐标校准数据，使用pupil[version]而不是pupil_point
+                // 同时更新坐标校准数据，使用pupil[version]而不是pupil_point
+                eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
+                eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
+                eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
+                eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
+
+                // 如果是首个校准样本，设置中心点
+                if (open_list[version].size() == 1) {
+                    eye_calib_data[version].calib_XOFF = pupil[version].x;
+                    eye_calib_data[version].calib_YOFF = pupil[version].y;
+                }
+
+                    // if (open_list[version].size() > CALIBRATION_SAMPLES) {
+                    //     if (is_calibrating) {
+                    //         calibrated[version] = true;
+                    //         eye_calib_data[version].has_calibration = true;
+                    //         LOG_INFO("眼睛{}校准完成：已收集足够样本数据 ({} 个样本点)",
+                    //                 version == LEFT_TAG ? "左" : "右",
+                    //                 open_list[version].size());
+                    //         is_calibrating = false; // 结束校准状态
+                    //     }
+                    // }
+            }
+
+                    pupil[version].x = outputs[version][EYE_OUTPUT_SIZE - 2];
+                    pupil[version].y = outputs[version][EYE_OUTPUT_SIZE - 1];
+
+                if (is_calibrating) {
+                // 对当前处理的眼睛进行校准数据收集，由于左右眼是两个不同的线程，这里不会有冲突
+                std::lock_guard<std::mutex> lock(results_mutex[version]);
+
+                // 只在有效瞳孔位置时更新校准数据
+                if (pupil[version].x > 0 && pupil[version].y > 0) {
+                    // 更新坐标范围
                     eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
                     eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
                     eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
                     eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
 
                     // 如果是首个校准样本，设置中心点
-                    if (open_list[version].size() == 1) {
+                    if (open_list[version].empty()) {
                         eye_calib_data[version].calib_XOFF = pupil[version].x;
                         eye_calib_data[version].calib_YOFF = pupil[version].y;
                     }
-
-                        // if (open_list[version].size() > CALIBRATION_SAMPLES) {
-                        //     if (is_calibrating) {
-                        //         calibrated[version] = true;
-                        //         eye_calib_data[version].has_calibration = true;
-                        //         LOG_INFO("眼睛{}校准完成：已收集足够样本数据 ({} 个样本点)",
-                        //                 version == LEFT_TAG ? "左" : "右",
-                        //                 open_list[version].size());
-                        //         is_calibrating = false; // 结束校准状态
-                        //     }
-                        // }
                 }
-
-                        pupil[version].x = outputs[version][EYE_OUTPUT_SIZE - 2];
-                        pupil[version].y = outputs[version][EYE_OUTPUT_SIZE - 1];
-
-                    if (is_calibrating) {
-                    // 对当前处理的眼睛进行校准数据收集，由于左右眼是两个不同的线程，这里不会有冲突
-                    std::lock_guard<std::mutex> lock(results_mutex[version]);
-
-                    // 只在有效瞳孔位置时更新校准数据
-                    if (pupil[version].x > 0 && pupil[version].y > 0) {
-                        // 更新坐标范围
-                        eye_calib_data[version].calib_XMIN = min(eye_calib_data[version].calib_XMIN, pupil[version].x);
-                        eye_calib_data[version].calib_XMAX = max(eye_calib_data[version].calib_XMAX, pupil[version].x);
-                        eye_calib_data[version].calib_YMIN = min(eye_calib_data[version].calib_YMIN, pupil[version].y);
-                        eye_calib_data[version].calib_YMAX = max(eye_calib_data[version].calib_YMAX, pupil[version].y);
-
-                        // 如果是首个校准样本，设置中心点
-                        if (open_list[version].empty()) {
-                            eye_calib_data[version].calib_XOFF = pupil[version].x;
-                            eye_calib_data[version].calib_YOFF = pupil[version].y;
-                        }
-                    }
-                }
-                }
-                auto end_time = std::chrono::high_resolution_clock::now();
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-                int delay_ms = max(0, static_cast<int>(1000.0 / get_max_fps() - elapsed));
-                std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+            }
             }
             });
     }
 
-   osc_send_thread = std::thread([this] ()
-{
     int debug_counter = 0;
 
-    // 从60Hz计算帧间隔时间，毫秒
-    const int frame_interval_ms = 1000 / 60;
-
-    // 插帧相关变量
-    const int interpolation_frames = 3; // 每两个真实数据帧之间插入的帧数
-    int current_interp_frame = 0;
-
-    // 存储插值用的目标状态
+    // 发送频率由重采样频率决定，默认 60Hz
+    const double send_rate = max(1.0, output_resampler.options().output_rate);
 
-    bool hasValidStartState = false;
+    // 已交给重采样器的推理结果序号
+    uint64_t pushed_seq[EYE_NUM] = {};
 
-    // 用于卡尔曼滤波的状态变量
     struct EyeState {
         double eyeLidValue = 0.0;
         double eyeXValue = 0.0;
         double eyeYValue = 0.0;
-        double eyeLidVelocity = 0.0;
-        double eyeXVelocity = 0.0;
-        double eyeYVelocity = 0.0;
         double pupilDilation = 0.5; // 新增瞳孔扩张参数
-
-        // 用于平滑过渡
-        void update(double targetLid, double targetX, double targetY, double dt, double targetDilation = 0.5) {
-            // 简单的一阶卡尔曼滤波（这里简化为低通滤波）
-            const double smoothFactor = 0.0;  // 平滑系数，值越大越平滑但越滞后
-
-            // 计算速度（增量/时间）
-            eyeLidVelocity = (targetLid - eyeLidValue) / dt;
-            eyeXVelocity = (targetX - eyeXValue) / dt;
-            eyeYVelocity = (targetY - eyeYValue) / dt;
-
-            // 平滑更新位置
-            eyeLidValue += (targetLid - eyeLidValue) * (1.0 - smoothFactor);
-            eyeXValue += (targetX - eyeXValue) * (1.0 - smoothFactor);
-            eyeYValue += (targetY - eyeYValue) * (1.0 - smoothFactor);
-
-            // 平滑更新瞳孔扩张
-            pupilDilation += (targetDilation - pupilDilation) * (1.0 - smoothFactor);
-        }
-
-        // 线性插值方法
-        void interpolate(const EyeState& start, const EyeState& end, float t) {
-            eyeLidValue = start.eyeLidValue + t * (end.eyeLidValue - start.eyeLidValue);
-            eyeXValue = start.eyeXValue + t * (end.eyeXValue - start.eyeXValue);
-            eyeYValue = start.eyeYValue + t * (end.eyeYValue - start.eyeYValue);
-            pupilDilation = start.pupilDilation + t * (end.pupilDilation - start.pupilDilation);
-
-            // 速度也可以插值，但通常不需要
-            eyeLidVelocity = start.eyeLidVelocity + t * (end.eyeLidVelocity - start.eyeLidVelocity);
-            eyeXVelocity = start.eyeXVelocity + t * (end.eyeXVelocity - start.eyeXVelocity);
-            eyeYVelocity = start.eyeYVelocity + t * (end.eyeYVelocity - start.eyeYVelocity);
-        }
     };
     EyeState targetLeftEyeState, targetRightEyeState;
-    EyeState startLeftEyeState, startRightEyeState;
     auto calculateEyeOpenness = [this](double currentValue, int eyeIndex) {
         // 获取完全张开和完全闭合的校准值
         double fullyOpen = eye_fully_open[eyeIndex];
@@ -612,75 +496,40 @@ void PaperEyeTrackerWindow::create_sub_thread() {
     };
 
 
-    // 记录上次发送的值，用于瞳孔扩张计算
-    double lastLeftPupilDilation = 0.5;
-    double lastRightPupilDilation = 0.5;
+    // 校准期间发送固定的居中(0,0)位置、0.75开度值和默认瞳孔扩张值
+    const EyeOutputFrame calibration_frame;
+    // 两个缓冲区在迭代之间复用，每帧不再分配内存
+    std::vector<float> eye_values;
+    std::vector<float> target_values;
 
-    while (is_running())
+    // 发送时刻直接影响接收端看到的抖动，只有这个阶段自旋等待
+    pipeline.addStage("emit", {[send_rate]() { return send_rate; }, std::chrono::milliseconds(0), "emit", true},
+        [=, this](utils::StageContext&) mutable
     {
-        auto start_time = std::chrono::high_resolution_clock::now();
+        // 每帧发送的参数，顺序与 EyeOutputFrame::toValues 一一对应
+        const std::vector<std::string>& eye_parameters = EyeOutputFrame::parameterNames();
 
         if (is_calibrating) {
-            // 发送固定的居中(0,0)位置和0.75开度值
-            // 左眼眼睑值固定为0.75
-            osc_manager->sendModelOutput(
-                { 0.75f },
-                { "/avatar/parameters/v2/EyeLidLeft" }
-            );
-
-            // 左眼X轴值固定为0.0
-            osc_manager->sendModelOutput(
-                { 0.0f },
-                { "/avatar/parameters/v2/EyeLeftX" }
-            );
-
-            // 右眼眼睑值固定为0.75
-            osc_manager->sendModelOutput(
-                { 0.75f },
-                { "/avatar/parameters/v2/EyeLidRight" }
-            );
-
-            // 右眼X轴值固定为0.0
-            osc_manager->sendModelOutput(
-                { 0.0f },
-                { "/avatar/parameters/v2/EyeRightX" }
-            );
-
-            // Y轴值固定为0.0
-            osc_manager->sendModelOutput(
-                { 0.0f },
-                { "/avatar/parameters/v2/EyeLeftY" }
-            );
-
-            osc_manager->sendModelOutput(
-                { 0.0f },
-                { "/avatar/parameters/v2/EyeRightY" }
-            );
-
-            // 瞳孔扩张默认值
-            osc_manager->sendModelOutput(
-                { 0.5f },
-                { "/avatar/parameters/v2/PupilDilation" }
-            );
-
-            // 控制循环时间
-            auto end_time = std::chrono::high_resolution_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-            int delay_ms = max(0, frame_interval_ms - static_cast<int>(elapsed));
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-            continue;  // 跳过后面的正常处理
+            osc_manager->sendEyeFrame(calibration_frame);
+            calibration_frame.toValues(eye_values);
+            SharedOutputChannel::instance().publishEye(eye_values, eye_parameters);
+            return;  // 跳过后面的正常处理
         }
 
-        // 是否是真实数据帧（每interpolation_frames+1帧中的第一帧）
-        bool is_real_data_frame = (current_interp_frame == 0);
-
-        if (is_real_data_frame) {
-            // 保存当前状态作为新的起始状态
-            if (hasValidStartState) {
-                startLeftEyeState = targetLeftEyeState;
-                startRightEyeState = targetRightEyeState;
+        // 只有推理线程产生了新结果时才重新计算目标值，其余周期由重采样器插值或预测
+        bool has_new_result = false;
+        auto result_time = std::chrono::steady_clock::time_point();
+        EyeResult latest[EYE_NUM];
+        for (int i = 0; i < EYE_NUM; i++) {
+            const uint64_t version = eye_results[i].load(latest[i]);
+            if (version != pushed_seq[i]) {
+                pushed_seq[i] = version;
+                result_time = latest[i].time > result_time ? latest[i].time : result_time;
+                has_new_result = true;
             }
+        }
 
+        if (has_new_result) {
             // 处理实际数据
             double eye_data[EYE_NUM][4]; // 存储[眼睛开合度,X轴,Y轴,瞳孔扩张]
             bool eye_active[EYE_NUM] = {false, false}; // 标记哪些眼睛有数据
@@ -690,17 +539,16 @@ void PaperEyeTrackerWindow::create_sub_thread() {
                 double blink_vec;
                 double eye_open_value;
 
-                // 获取最新的眼睛状态
+                // 使用本周期读到的最新眼睛状态
+                const cv::Point2f pupil_point(latest[i].pupil_x, latest[i].pupil_y);
                 {
-                    std::lock_guard<std::mutex> lock_guard(results_mutex[i]);
-
                     // 检查这只眼睛是否有数据
-                    if (pupil[i].x == 0 && pupil[i].y == 0) {
+                    if (pupil_point.x == 0 && pupil_point.y == 0) {
                         continue; // 没有有效数据，跳过此眼睛
                     }
 
                     // 使用校准值计算眼睛开合度
-                    double raw_open = eye_open[i];
+                    double raw_open = latest[i].eye_open;
                     eye_open_value = calculateEyeOpenness(raw_open, i);
 
                     blink_vec = min(std::abs(eye_open_value - last_eye_open[i]), 1.0);
@@ -734,10 +582,10 @@ void PaperEyeTrackerWindow::create_sub_thread() {
                     if (calib_diff_y_MIN == 0) calib_diff_y_MIN = -1;
 
                     // 计算偏移量
-                    double xl = (pupil[i].x - eye_calib_data[i].calib_XOFF) / calib_diff_x_MAX;
-                    double xr = (pupil[i].x - eye_calib_data[i].calib_XOFF) / calib_diff_x_MIN;
-                    double yu = (pupil[i].y - eye_calib_data[i].calib_YOFF) / calib_diff_y_MIN;
-                    double yd = (pupil[i].y - eye_calib_data[i].calib_YOFF) / calib_diff_y_MAX;
+                    double xl = (pupil_point.x - eye_calib_data[i].calib_XOFF) / calib_diff_x_MAX;
+                    double xr = (pupil_point.x - eye_calib_data[i].calib_XOFF) / calib_diff_x_MIN;
+                    double yu = (pupil_point.y - eye_calib_data[i].calib_YOFF) / calib_diff_y_MIN;
+                    double yd = (pupil_point.y - eye_calib_data[i].calib_YOFF) / calib_diff_y_MAX;
 
                     // Y轴映射，根据flip_y_axis决定方向
                     if (flip_y_axis) {
@@ -933,65 +781,29 @@ void PaperEyeTrackerWindow::create_sub_thread() {
                 targetRightEyeState.eyeYValue = eye_data[RIGHT_TAG][2];
                 targetRightEyeState.pupilDilation = eye_data[RIGHT_TAG][3];
             }
+        }
 
-            // 如果这是第一帧，初始化起始状态等于目标状态
-            if (!hasValidStartState) {
-                startLeftEyeState = targetLeftEyeState;
-                startRightEyeState = targetRightEyeState;
-                hasValidStartState = true;
-            }
+        EyeOutputFrame target_frame;
+        target_frame.lid_left = static_cast<float>(targetLeftEyeState.eyeLidValue);
+        target_frame.x_left = static_cast<float>(targetLeftEyeState.eyeXValue);
+        target_frame.y_left = static_cast<float>(targetLeftEyeState.eyeYValue);
+        target_frame.lid_right = static_cast<float>(targetRightEyeState.eyeLidValue);
+        target_frame.x_right = static_cast<float>(targetRightEyeState.eyeXValue);
+        target_frame.y_right = static_cast<float>(targetRightEyeState.eyeYValue);
+        // 瞳孔扩张使用两眼平均值
+        target_frame.pupil_dilation = static_cast<float>((targetLeftEyeState.pupilDilation + targetRightEyeState.pupilDilation) / 2.0);
+        target_frame.toValues(target_values);
+        if (has_new_result) {
+            output_resampler.push(result_time, target_values);
+        }
+        // 还没有任何推理结果时直接发送默认目标值
+        if (!output_resampler.sample(std::chrono::steady_clock::now(), eye_values)) {
+            eye_values = target_values;
         }
 
-        // 计算当前插值位置（0.0 - 1.0）
-        float t = static_cast<float>(current_interp_frame) / (interpolation_frames + 1);
-
-        // 创建当前插值状态
-        EyeState currentLeftEyeState, currentRightEyeState;
-        currentLeftEyeState.interpolate(startLeftEyeState, targetLeftEyeState, t);
-        currentRightEyeState.interpolate(startRightEyeState, targetRightEyeState, t);
-
-        // 左眼数据发送
-        osc_manager->sendModelOutput(
-            { static_cast<float>(currentLeftEyeState.eyeLidValue) },
-            { "/avatar/parameters/v2/EyeLidLeft" }
-        );
-
-        osc_manager->sendModelOutput(
-            { static_cast<float>(currentLeftEyeState.eyeXValue) },
-            { "/avatar/parameters/v2/EyeLeftX" }
-        );
-
-        osc_manager->sendModelOutput(
-            { static_cast<float>(currentLeftEyeState.eyeYValue) },
-            { "/avatar/parameters/v2/EyeLeftY" }
-        );
-
-        lastLeftPupilDilation = currentLeftEyeState.pupilDilation;
-
-        // 右眼数据发送
-        osc_manager->sendModelOutput(
-            { static_cast<float>(currentRightEyeState.eyeLidValue) },
-            { "/avatar/parameters/v2/EyeLidRight" }
-        );
-
-        osc_manager->sendModelOutput(
-            { static_cast<float>(currentRightEyeState.eyeXValue) },
-            { "/avatar/parameters/v2/EyeRightX" }
-        );
-
-        osc_manager->sendModelOutput(
-            { static_cast<float>(currentRightEyeState.eyeYValue) },
-            { "/avatar/parameters/v2/EyeRightY" }
-        );
-
-        lastRightPupilDilation = currentRightEyeState.pupilDilation;
-
-        // 发送瞳孔扩张数据（使用两眼平均值）
-        float pupilDilationValue = (lastLeftPupilDilation + lastRightPupilDilation) / 2.0f;
-        osc_manager->sendModelOutput(
-            { pupilDilationValue },
-            { "/avatar/parameters/v2/PupilDilation" }
-        );
+        // 两眼数据一次加锁发送，bundle 模式下合并为一个数据包
+        osc_manager->sendEyeFrame(EyeOutputFrame::fromValues(eye_values));
+        SharedOutputChannel::instance().publishEye(eye_values, eye_parameters);
 
         debug_counter++;
 
@@ -1002,18 +814,19 @@ void PaperEyeTrackerWindow::create_sub_thread() {
         if (image_stream[1]->isStreaming()){
             updateEyePosition(RIGHT_TAG);
         }
+    });
 
+    pipeline.start();
+}
 
-        // 更新插帧计数器
-        current_interp_frame = (current_interp_frame + 1) % (interpolation_frames + 1);
+void PaperEyeTrackerWindow::showEvent(QShowEvent* event) {
+    preview_visible = true;
+    QWidget::showEvent(event);
+}
 
-        // 控制循环时间，确保60Hz的发送帧率
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        int delay_ms = max(0, frame_interval_ms - static_cast<int>(elapsed));
-        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
-    }
-});
+void PaperEyeTrackerWindow::hideEvent(QHideEvent* event) {
+    preview_visible = false;
+    QWidget::hideEvent(event);
 }
 
 PaperEyeTrackerWindow::~PaperEyeTrackerWindow() {
@@ -1025,26 +838,22 @@ PaperEyeTrackerWindow::~PaperEyeTrackerWindow() {
         delete auto_save_timer;
         auto_save_timer = nullptr;
     }
-    // join threads
+    // 停止所有阶段，正在等待节拍的阶段会被立即唤醒
+    pipeline.stop();
+    SharedOutputChannel::instance().clearEye();
     for (int i = 0; i < EYE_NUM; i++) {
-        if (update_ui_thread[i].joinable()) {
-            update_ui_thread[i].join();
-        }
-        if (inference_thread[i].joinable()) {
-            inference_thread[i].join();
-        }
         if (image_stream[i]->isStreaming()) {
             image_stream[i]->stop();
         }
     }
-    if (osc_send_thread.joinable()) {
-        osc_send_thread.join();
-    }
     // clean resources
     if (serial_port_->status() == SerialStatus::OPENED) {
         serial_port_->stop();
     }
     osc_manager->close();
+    if (auto_save_result.valid()) {
+        auto_save_result.wait();
+    }
     config = generate_config();
     config_writer->write_config(config);
     LOG_INFO("系统已安全关闭");
@@ -1735,9 +1544,12 @@ void PaperEyeTrackerWindow::onSendBrightnessValue() {
         brightness_str = std::string("0") + brightness_str;
     }
     std::string packet = "A6" + brightness_str + "B6";
-    serial_port_->write_data(packet);
-    // 记录操作
-    LOG_INFO("已设置亮度: {}", brightness_str);
+    // 异步写入，写完后再记录；拖动滑条产生的旧值会被新值合并掉
+    serial_port_->write_data(packet, [brightness_str](SerialWriteResult result) {
+        if (result == SerialWriteResult::WRITTEN) {
+            LOG_INFO("已设置亮度: {}", brightness_str);
+        }
+    });
 }
 
 std::string PaperEyeTrackerWindow::getSSID() const {
@@ -1875,6 +1687,68 @@ void PaperEyeTrackerWindow::updateWifiLabel(int version) {
     }, Qt::QueuedConnection);
 }
 
+void PaperEyeTrackerWindow::onSerialConnectionChanged(bool connected) {
+    if (serial_connection_checked) {
+        // 之后的插拔只更新状态显示
+        updateSerialLabel(current_esp32_version);
+        return;
+    }
+    serial_connection_checked = true;
+    if (!connected) {
+        LOG_WARN("没有检测到眼追设备，尝试从配置文件中读取地址...");
+        if (!config.left_ip.empty()) {
+            LOG_INFO("从配置文件中读取左眼地址成功");
+            current_ip[LEFT_TAG] = config.left_ip;
+            start_image_download(LEFT_TAG);
+        }
+        else {
+            QMessageBox msgBox;
+            msgBox.setWindowIcon(this->windowIcon());
+            msgBox.setText(QApplication::translate("PaperTrackerMainWindow","未找到左眼配置文件信息，请将设备通过数据线连接到电脑进行首次配置"));
+            msgBox.exec();
+        }
+        if (!config.right_ip.empty()) {
+            LOG_INFO("从配置文件中读取右眼地址成功");
+            current_ip[RIGHT_TAG] = config.right_ip;
+            start_image_download(RIGHT_TAG);
+        }
+        else {
+            QMessageBox msgBox;
+            msgBox.setWindowIcon(this->windowIcon());
+            msgBox.setText(QApplication::translate("PaperTrackerMainWindow","未找到右眼配置文件信息，请将设备通过数据线连接到电脑进行首次配置"));
+            msgBox.exec();
+        }
+    }
+    else {
+        if (current_ip[LEFT_TAG].empty() && !config.left_ip.empty()) {
+            current_ip[LEFT_TAG] = config.left_ip;
+            start_image_download(LEFT_TAG);
+        }
+        else {
+            if (config.left_ip.empty()) {
+                QMessageBox msgBox;
+                msgBox.setWindowIcon(this->windowIcon());
+                msgBox.setText(QApplication::translate("PaperTrackerMainWindow","未找到左眼配置文件信息，请将设备通过数据线连接到电脑进行首次配置"));
+                msgBox.exec();
+            }
+        }
+        if (current_ip[RIGHT_TAG].empty() && !config.right_ip.empty()) {
+            current_ip[RIGHT_TAG] = config.right_ip;
+            start_image_download(RIGHT_TAG);
+        }
+        else {
+            if (config.right_ip.empty()) {
+                QMessageBox msgBox;
+                msgBox.setWindowIcon(this->windowIcon());
+                msgBox.setText(QApplication::translate("PaperTrackerMainWindow","未找到右眼配置文件信息，请将设备通过数据线连接到电脑进行首次配置"));
+                msgBox.exec();
+            }
+        }
+        LOG_INFO("有线模式眼追连接成功");
+        setSerialStatusLabel("有线模式眼追连接成功");
+    }
+}
+
 void PaperEyeTrackerWindow::updateSerialLabel(int version) {
     QMetaObject::invokeMethod(this, [this, version]() {
     if (serial_port_->status() == SerialStatus::OPENED) {
@@ -1892,9 +1766,20 @@ void PaperEyeTrackerWindow::updateSerialLabel(int version) {
 }
 
 cv::Mat PaperEyeTrackerWindow::getVideoImage(int version) const {
+    if (override_source[version]) {
+        return override_source[version]->getLatestFrame();
+    }
     return std::move(image_stream[version]->getLatestFrame());
 }
 
+cv::Mat PaperEyeTrackerWindow::getTransformedImage(int version) {
+    const FrameSource* source = override_source[version] ? override_source[version].get()
+                                                         : static_cast<const FrameSource*>(image_stream[version].get());
+    uint64_t sequence = 0;
+    const cv::Mat frame = source->peekLatestFrame(&sequence);
+    return frame_transform[version].get(source, sequence, frame, cv::Size(350, 259), getRotateAngle(version));
+}
+
 void PaperEyeTrackerWindow::setSerialStatusLabel(const QString& text) const {
     EyeWindowSerialStatus->setText(QApplication::translate("PaperTrackerMainWindow",text.toUtf8().constData()));
 }
@@ -2237,7 +2122,7 @@ void PaperEyeTrackerWindow::centerEye(int eyeIndex) {
 }
 void PaperEyeTrackerWindow::updateEyePosition(int eyeIndex)
 {
-    // 这个函数会被 osc_send_thread 线程调用，用来更新眼睛位置显示
+    // 这个函数会被流水线的发送阶段调用，用来更新眼睛位置显示
     if (!app_is_running)
         return;
 
@@ -34,6 +34,8 @@
 #include <QGroupBox>
 
 #include "opencv2/imgcodecs.hpp"
+#include "stream_hub.hpp"
+#include "shared_output.hpp"
 
 static bool is_show_tip = false;
 
@@ -145,12 +147,12 @@ PaperFaceTrackerWindow::PaperFaceTrackerWindow(QWidget *parent)
     }
     // 初始化串口和wifi
     serial_port_manager = std::make_shared<SerialPortManager>();
-    image_downloader = std::make_shared<ESP32VideoStream>();
+    image_downloader = StreamHub::instance().createStream();
+    override_source = StreamHub::instance().createOverrideSource(0);
     LOG_INFO("初始化有线模式");
     serial_port_manager->init();
     // init serial port manager
-    serial_port_manager->registerCallback(
-        PACKET_DEVICE_STATUS,
+    serial_port_manager->registerDeviceStatusCallback(
         [this](const std::string& ip, int brightness, int power, int version) {
             if (version != 1)
             {
@@ -190,31 +192,10 @@ PaperFaceTrackerWindow::PaperFaceTrackerWindow(QWidget *parent)
             LOG_INFO("串口原始数据: {}", data);
         }
     });
-    LOG_DEBUG("等待有线模式面捕连接");
-    while (serial_port_manager->status() == SerialStatus::CLOSED) {}
-    LOG_DEBUG("有线模式面捕连接完毕");
-
-    if (serial_port_manager->status() == SerialStatus::FAILED)
-    {
-        setSerialStatusLabel("有线模式面捕连接失败");
-        LOG_WARN("有线模式面捕未连接，尝试从配置文件中读取地址...");
-        if (!config.wifi_ip.empty())
-        {
-            LOG_INFO("从配置文件中读取地址成功");
-            current_ip_ = config.wifi_ip;
-            start_image_download();
-        } else
-        {
-            QMessageBox msgBox;
-            msgBox.setWindowIcon(this->windowIcon());
-            msgBox.setText(Translator::tr("未找到配置文件信息，请将面捕通过数据线连接到电脑进行首次配置"));
-            msgBox.exec();
-        }
-    } else
-    {
-        LOG_INFO("有线模式面捕连接成功");
-        setSerialStatusLabel("有线模式面捕连接成功");
-    }
+    // 设备枚举在后台进行，首次枚举完成后再决定是否回退到配置文件中的地址
+    serial_port_manager->registerConnectionCallback([this](bool connected) {
+        onSerialConnectionChanged(connected);
+    });
     // 读取配置文件
     set_config();
     // setupKalmanFilterControls();
@@ -222,9 +203,21 @@ PaperFaceTrackerWindow::PaperFaceTrackerWindow(QWidget *parent)
     // 创建自动保存配置的定时器
     auto_save_timer = new QTimer(this);
     connect(auto_save_timer, &QTimer::timeout, this, [this]() {
+        // 上一次还没写完时跳过这一轮，避免两个任务同时写同一个文件
+        if (auto_save_result.valid() &&
+            auto_save_result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
         config = generate_config();
-        config_writer->write_config(config);
-        LOG_DEBUG("面捕配置已自动保存");
+        // 界面线程只生成配置，写文件交给后台线程池，磁盘慢时界面不会卡顿
+        auto_save_result = utils::background_pool().submit_with_priority(utils::TaskPriority::LOW,
+            [writer = config_writer, snapshot = config]() {
+                if (writer->write_config(snapshot)) {
+                    LOG_DEBUG("面捕配置已自动保存");
+                } else {
+                    LOG_WARN("面捕配置自动保存失败");
+                }
+            });
     });
     auto_save_timer->start(10000); // 10000毫秒 = 10秒
     retranslateUI();
@@ -968,7 +961,7 @@ void PaperFaceTrackerWindow::checkHardwareVersion()
 
 }
 
-void PaperFaceTrackerWindow::setVideoImage(const cv::Mat& image)
+void PaperFaceTrackerWindow::setVideoImage(cv::Mat image)
 {
     if (image.empty())
     {
@@ -984,7 +977,8 @@ void PaperFaceTrackerWindow::setVideoImage(const cv::Mat& image)
         }, Qt::QueuedConnection);
         return ;
     }
-    QMetaObject::invokeMethod(this, [this, image = image.clone()]() {
+    // image 由调用方交出，不再拷贝一次
+    QMetaObject::invokeMethod(this, [this, image = std::move(image)]() {
         auto qimage = QImage(image.data, image.cols, image.rows, image.step, QImage::Format_RGB888);
         auto pix_map = QPixmap::fromImage(qimage);
         if (stackedWidget->currentIndex() == 0)
@@ -1007,6 +1001,9 @@ PaperFaceTrackerWindow::~PaperFaceTrackerWindow() {
         delete auto_save_timer;
         auto_save_timer = nullptr;
     }
+    if (auto_save_result.valid()) {
+        auto_save_result.wait();
+    }
     config = generate_config();
     config_writer->write_config(config);
     LOG_INFO("正在关闭VRCFT");
@@ -1034,6 +1031,18 @@ void PaperFaceTrackerWindow::bound_pages() {
 }
 
 // 添加事件过滤器实现
+void PaperFaceTrackerWindow::showEvent(QShowEvent *event)
+{
+    preview_visible = true;
+    QWidget::showEvent(event);
+}
+
+void PaperFaceTrackerWindow::hideEvent(QHideEvent *event)
+{
+    preview_visible = false;
+    QWidget::hideEvent(event);
+}
+
 bool PaperFaceTrackerWindow::eventFilter(QObject *obj, QEvent *event)
 {
     // 处理焦点获取事件
@@ -1371,9 +1380,12 @@ void PaperFaceTrackerWindow::onSendBrightnessValue() const
         brightness_str = std::string("0") + brightness_str;
     }
     std::string packet = "A6" + brightness_str + "B6";
-    serial_port_manager->write_data(packet);
-    // 记录操作
-    LOG_INFO("已设置亮度: {}", current_brightness);
+    // 异步写入，写完后再记录；拖动滑条产生的旧值会被新值合并掉
+    serial_port_manager->write_data(packet, [brightness = current_brightness](SerialWriteResult result) {
+        if (result == SerialWriteResult::WRITTEN) {
+            LOG_INFO("已设置亮度: {}", brightness);
+        }
+    });
 }
 
 bool PaperFaceTrackerWindow:: is_running() const
@@ -1385,18 +1397,10 @@ void PaperFaceTrackerWindow::stop()
 {
     LOG_INFO("正在关闭系统...");
     app_is_running = false;
-    if (update_thread.joinable())
-    {
-        update_thread.join();
-    }
-    if (inference_thread.joinable())
-    {
-        inference_thread.join();
-    }
-    if (osc_send_thread.joinable())
-    {
-        osc_send_thread.join();
-    }
+    // 打断各阶段正在进行的等待，不必等到下一个节拍
+    pipeline.stop();
+    // 流水线已停，不会再有发布，共享内存里不再保留面捕的旧结果
+    SharedOutputChannel::instance().clearFace();
     if (brightness_timer) {
         brightness_timer->stop();
         brightness_timer.reset();
@@ -1772,6 +1776,38 @@ void PaperFaceTrackerWindow::updateWifiLabel() const
     }
 }
 
+void PaperFaceTrackerWindow::onSerialConnectionChanged(bool connected)
+{
+    if (serial_connection_checked)
+    {
+        // 之后的插拔只更新状态显示
+        updateSerialLabel();
+        return;
+    }
+    serial_connection_checked = true;
+    if (!connected)
+    {
+        setSerialStatusLabel("有线模式面捕连接失败");
+        LOG_WARN("有线模式面捕未连接，尝试从配置文件中读取地址...");
+        if (!config.wifi_ip.empty())
+        {
+            LOG_INFO("从配置文件中读取地址成功");
+            current_ip_ = config.wifi_ip;
+            start_image_download();
+        } else
+        {
+            QMessageBox msgBox;
+            msgBox.setWindowIcon(this->windowIcon());
+            msgBox.setText(Translator::tr("未找到配置文件信息，请将面捕通过数据线连接到电脑进行首次配置"));
+            msgBox.exec();
+        }
+    } else
+    {
+        LOG_INFO("有线模式面捕连接成功");
+        setSerialStatusLabel("有线模式面捕连接成功");
+    }
+}
+
 void PaperFaceTrackerWindow::updateSerialLabel() const
 {
     if (serial_port_manager->status() == SerialStatus::OPENED)
@@ -1785,9 +1821,34 @@ void PaperFaceTrackerWindow::updateSerialLabel() const
 
 cv::Mat PaperFaceTrackerWindow::getVideoImage() const
 {
+    if (override_source)
+    {
+        return override_source->getLatestFrame();
+    }
+    // 有线模式正在传图时优先使用，延迟比拥挤的 2.4G Wi-Fi 更稳定
+    if (const auto wired = serial_port_manager->frameSource(); wired->isStreaming())
+    {
+        return wired->getLatestFrame();
+    }
     return std::move(image_downloader->getLatestFrame());
 }
 
+cv::Mat PaperFaceTrackerWindow::getTransformedImage()
+{
+    const FrameSource* source = image_downloader.get();
+    if (override_source)
+    {
+        source = override_source.get();
+    }
+    else if (const auto wired = serial_port_manager->frameSource(); wired->isStreaming())
+    {
+        source = wired.get();
+    }
+    uint64_t sequence = 0;
+    const cv::Mat frame = source->peekLatestFrame(&sequence);
+    return frame_transform.get(source, sequence, frame, cv::Size(350, 259), getRotateAngle());
+}
+
 std::string PaperFaceTrackerWindow::getFirmwareVersion() const
 {
     return firmware_version;
@@ -1798,10 +1859,6 @@ SerialStatus PaperFaceTrackerWindow::getSerialStatus() const
     return serial_port_manager->status();
 }
 
-void PaperFaceTrackerWindow::set_osc_send_thead(FuncWithoutArgs func)
-{
-    osc_send_thread = std::thread(std::move(func));
-}
 void PaperFaceTrackerWindow::updateBatteryStatus() const
 {
     if (image_downloader && image_downloader->isStreaming())
@@ -1817,167 +1874,114 @@ void PaperFaceTrackerWindow::updateBatteryStatus() const
 }
 void PaperFaceTrackerWindow::create_sub_threads()
 {
-    update_thread = std::thread([this]()
+    pipeline.addStage("preview", {[this]() { return static_cast<double>(min(get_max_fps() + 30, 50)); }, std::chrono::milliseconds(100), "preview"},
+        [this](utils::StageContext&)
     {
-        auto last_time = std::chrono::high_resolution_clock::now();
-        double fps_total = 0;
-        double fps_count = 0;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        while (is_running())
-        {
-            updateWifiLabel();
-            updateSerialLabel();
-            updateBatteryStatus();
-            checkHardwareVersion();
-            auto start_time = std::chrono::high_resolution_clock::now();
-            try {
-                if (fps_total > 1000)
-                {
-                    fps_count = 0;
-                    fps_total = 0;
-                }
-                // caculate fps
-                auto start = std::chrono::high_resolution_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(start - last_time);
-                last_time = start;
-                auto fps = 1000.0 / static_cast<double>(duration.count());
-                fps_total += fps;
-                fps_count += 1;
-                fps = fps_total/fps_count;
-                cv::Mat frame = getVideoImage();
-                if (!frame.empty())
-                {
-                    auto rotate_angle = getRotateAngle();
-                    cv::resize(frame, frame, cv::Size(350, 259), cv::INTER_NEAREST);
-                    int y = frame.rows / 2;
-                    int x = frame.cols / 2;
-                    auto rotate_matrix = cv::getRotationMatrix2D(cv::Point(x, y), rotate_angle, 1);
-                    cv::warpAffine(frame, frame, rotate_matrix, frame.size(), cv::INTER_NEAREST);
-
-                    auto roi_rect = getRoiRect();
-                    // 显示图像
-                    cv::rectangle(frame, roi_rect.rect, cv::Scalar(0, 255, 0), 2);
-                }
-                // draw rect on frame
-                cv::Mat show_image;
-                if (!frame.empty())
-                {
-                    show_image = frame;
-                }
-                setVideoImage(show_image);
-                // 控制帧率
-            } catch (const std::exception& e) {
-                // 使用Qt方式记录日志，而不是minilog
-                QMetaObject::invokeMethod(this, [&e]() {
-                    LOG_ERROR("错误, 视频处理异常: {}", e.what());
-                }, Qt::QueuedConnection);
+        updateWifiLabel();
+        updateSerialLabel();
+        updateBatteryStatus();
+        checkHardwareVersion();
+        try {
+            // 窗口不可见时不做预览，变换只由推理阶段按需计算
+            if (!preview_visible.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            cv::Mat show_image = getTransformedImage();
+            if (!show_image.empty())
+            {
+                // 变换结果和推理阶段共享，ROI 框画在预览自己的拷贝上
+                show_image = show_image.clone();
+                auto roi_rect = getRoiRect();
+                cv::rectangle(show_image, roi_rect.rect, cv::Scalar(0, 255, 0), 2);
             }
-            auto end_time = std::chrono::high_resolution_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count ();
-            int delay_ms = max(0, static_cast<int>(1000.0 / min(get_max_fps() + 30, 50) - elapsed));
-            // LOG_DEBUG("UIFPS:" +  std::to_string(min(get_max_fps() + 30, 60)));
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+            setVideoImage(std::move(show_image));
+        } catch (const std::exception& e) {
+            // 使用Qt方式记录日志，而不是minilog
+            QMetaObject::invokeMethod(this, [&e]() {
+                LOG_ERROR("错误, 视频处理异常: {}", e.what());
+            }, Qt::QueuedConnection);
         }
     });
 
-    inference_thread = std::thread([this] ()
+    // 发布用的结果在迭代之间复用
+    pipeline.addStage("infer", {[this]() { return static_cast<double>(get_max_fps()); }, std::chrono::milliseconds(100), "inference"},
+        [this, result = FaceResult()](utils::StageContext& context) mutable
     {
-        auto last_time = std::chrono::high_resolution_clock::now();
-        double fps_total = 0;
-        double fps_count = 0;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        while (is_running())
+        // 设置时间序列
+        inference->set_dt(context.interval());
+
+        const cv::Mat frame = getTransformedImage();
+        // 推理处理
+        if (!frame.empty())
         {
-            if (fps_total > 1000)
+            // 变换结果和预览阶段共享，推理只读取，不需要拷贝
+            cv::Mat infer_frame = frame;
+            auto roi_rect = getRoiRect();
+            if (!roi_rect.rect.empty() && roi_rect.is_roi_end)
             {
-                fps_count = 0;
-                fps_total = 0;
+                infer_frame = frame(roi_rect.rect);
             }
-            // calculate fps
-            auto start = std::chrono::high_resolution_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(start - last_time);
-            last_time = start;
-            auto fps = 1000.0 / static_cast<double>(duration.count());
-            fps_total += fps;
-            fps_count += 1;
-            fps = fps_total/fps_count;
-            // LOG_DEBUG("模型FPS： {}", fps);
-
-            auto start_time = std::chrono::high_resolution_clock::now();
-            // 设置时间序列
-            inference->set_dt(duration.count() / 1000.0);
-
-            auto frame = getVideoImage();
-            // 推理处理
-            if (!frame.empty())
-            {
-                auto rotate_angle = getRotateAngle();
-                cv::resize(frame, frame, cv::Size(350, 259), cv::INTER_NEAREST);
-                int y = frame.rows / 2;
-                int x = frame.cols / 2;
-                auto rotate_matrix = cv::getRotationMatrix2D(cv::Point(x, y), rotate_angle, 1);
-                cv::warpAffine(frame, frame, rotate_matrix, frame.size(), cv::INTER_NEAREST);
-                cv::Mat infer_frame;
-                infer_frame = frame.clone();
-                auto roi_rect = getRoiRect();
-                if (!roi_rect.rect.empty() && roi_rect.is_roi_end)
-                {
-                    infer_frame = infer_frame(roi_rect.rect);
-                }
-                inference->inference(infer_frame);
-                {
-                    std::lock_guard<std::mutex> lock(outputs_mutex);
-                    outputs = inference->get_output();
-                }
-            }
-            auto end_time = std::chrono::high_resolution_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-            int delay_ms = max(0, static_cast<int>(1000.0 / get_max_fps() - elapsed));
-            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+            inference->inference(infer_frame);
+            const auto output = inference->get_output();
+            result.count = static_cast<uint32_t>(std::min<std::size_t>(output.size(), MAX_FACE_OUTPUTS));
+            std::copy_n(output.begin(), result.count, result.values.begin());
+            face_results.store(result);
+            output_resampler.push(std::chrono::steady_clock::now(), output);
+            // 推理结果立即交给发送阶段，不再等待下一个发送周期
+            pipeline.notify();
         }
     });
 
-    osc_send_thread = std::thread([this] ()
+    // 有新的推理结果才发送，最高发送频率只作为上限；开启重采样时改为按固定频率发送插值或预测值
+    // max_send_rate 为 0 时不限制，结果到达即发送
+    const int max_send_rate = osc_manager->sendOptions().max_send_rate;
+    const auto min_interval = max_send_rate > 0 ? std::chrono::microseconds(1000000 / max_send_rate)
+                                                : std::chrono::microseconds(0);
+    const bool resampling = output_resampler.options().mode != ResampleMode::OFF;
+    const double resample_rate = max(1.0, output_resampler.options().output_rate);
+    utils::Pipeline::StageOptions emit_options;
+    emit_options.policy = "emit";
+    if (resampling) {
+        // 重采样输出的时间戳按节拍计算，发送时刻也要准，这里值得花一点 CPU 自旋
+        emit_options.rate = [resample_rate]() { return resample_rate; };
+        emit_options.spin = true;
+    }
+    pipeline.addStage("emit", emit_options,
+        [this, min_interval, resampling,
+         last_send_time = std::chrono::steady_clock::now() - min_interval,
+         sent_seq = uint64_t(0), latest = FaceResult(), pending = std::vector<float>()](utils::StageContext& context) mutable
     {
-        auto last_time = std::chrono::high_resolution_clock::now();
-        double fps_total = 0;
-        double fps_count = 0;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        while (is_running())
-        {
-         if (fps_total > 1000)
-         {
-             fps_count = 0;
-             fps_total = 0;
-         }
-         // calculate fps
-         auto start = std::chrono::high_resolution_clock::now();
-         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(start - last_time);
-         last_time = start;
-         auto fps = 1000.0 / static_cast<double>(duration.count());
-         fps_total += fps;
-         fps_count += 1;
-         fps = fps_total/fps_count;
-         auto start_time = std::chrono::high_resolution_clock::now();
-        // 发送OSC数据
-         {
-             std::lock_guard<std::mutex> lock(outputs_mutex);
-             if (!outputs.empty()) {
-                 // 如果正在校准，则收集数据
-                 if (is_calibrating) {
-                     collectData(outputs, inference->getBlendShapeIndexMap());
-                 }
-                updateCalibrationProgressBars(outputs, inference->getBlendShapeIndexMap());
-                osc_manager->sendModelOutput(outputs, blend_shapes);
-             }
-         }
-
-         auto end_time = std::chrono::high_resolution_clock::now();
-         auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-         int delay_ms = max(0, static_cast<int>(1000.0 / 66.0 - elapsed));
-         std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        if (resampling) {
+            if (!output_resampler.sample(std::chrono::steady_clock::now(), pending)) {
+                return;
+            }
+        } else {
+            if (!context.wait([this, &sent_seq]() { return face_results.version() != sent_seq; })) {
+                return;
+            }
+            // 超过频率上限时等到允许发送的时刻，再取那时最新的结果
+            if (min_interval.count() > 0 && !context.sleepUntil(last_send_time + min_interval)) {
+                return;
+            }
+            sent_seq = face_results.load(latest);
+            pending.assign(latest.values.begin(), latest.values.begin() + latest.count);
+            last_send_time = std::chrono::steady_clock::now();
+        }
+
+        // 发送OSC数据和更新界面都在结果的拷贝上进行，推理阶段不会被阻塞
+        if (!pending.empty()) {
+            // 如果正在校准，则收集数据
+            if (is_calibrating) {
+                collectData(pending, inference->getBlendShapeIndexMap());
+            }
+            updateCalibrationProgressBars(pending, inference->getBlendShapeIndexMap());
+            osc_manager->sendModelOutput(pending, blend_shapes);
+            SharedOutputChannel::instance().publishFace(pending, blend_shapes);
         }
     });
+
+    pipeline.start();
 }
 void PaperFaceTrackerWindow::onCheekPuffLeftOffsetChanged()
 {
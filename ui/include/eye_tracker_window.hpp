@@ -10,12 +10,19 @@
 
 #include "serial.hpp"
 #include "image_downloader.hpp"
+#include "frame_transform.hpp"
 #include "osc.hpp"
 #include "logger.hpp"
 #include <QTimer>
 #include "config_writer.hpp"
 #include "osc.hpp"
 #include "face_inference.hpp"
+#include "output_resampler.hpp"
+#include "pipeline.hpp"
+#include "seqlock.hpp"
+#include "thread_pool.hpp"
+#include <array>
+#include <atomic>
 #include <list>
 
 #include <QPainter>
@@ -106,10 +113,14 @@ public:
     void setSerialStatusLabel(const QString& text) const;
     void setWifiStatusLabel(int version, const QString& text) const;
 
-    void setVideoImage(int version, const cv::Mat& image);
+    void setVideoImage(int version, cv::Mat image);
     void updateWifiLabel(int version) ;
     void updateSerialLabel(int version);
+    // 首次设备枚举完成后决定是否使用配置文件中的地址
+    void onSerialConnectionChanged(bool connected);
     cv::Mat getVideoImage(int version) const;
+    // 该眼最新帧缩放并旋转后的结果，每帧只计算一次，预览和推理共享，只能读取
+    cv::Mat getTransformedImage(int version);
 
     Rect getRoiRect(int version);
     float getRotateAngle(int version) const;
@@ -118,6 +129,10 @@ public:
     PaperEyeTrackerConfig generate_config() const;
     void checkHardwareVersion(int version);
 
+protected:
+    void showEvent(QShowEvent* event) override;
+    void hideEvent(QHideEvent* event) override;
+
 private slots:
     void onSendButtonClicked();
     void onRestartButtonClicked();
@@ -168,6 +183,8 @@ private:
     void updateCalibrationButtonStates();
 
     std::shared_ptr<ESP32VideoStream> image_stream[EYE_NUM];
+    // 命令行指定的回放等替代来源，设置后优先于设备视频流
+    std::shared_ptr<FrameSource> override_source[EYE_NUM];
     std::shared_ptr<SerialPortManager> serial_port_;
     std::shared_ptr<OscManager> osc_manager;
     std::shared_ptr<EyeInference> inference_[EYE_NUM];
@@ -177,9 +194,8 @@ private:
 
     inline static PaperEyeTrackerWindow* instance = nullptr;
 
-    std::thread update_ui_thread[EYE_NUM];
-    std::thread osc_send_thread;
-    std::thread inference_thread[EYE_NUM];
+    // 每只眼睛的预览和推理阶段，加上合并两眼结果的发送阶段
+    utils::Pipeline pipeline{"眼追"};
     bool app_is_running = true;
     int max_fps = 38;
 
@@ -199,10 +215,30 @@ private:
     };
     int current_rotate_angle[EYE_NUM] = {0};
 
+    // 只在推理线程中使用，发布给其他线程的部分见 landmarks 和 eye_results
     std::vector<float> outputs[EYE_NUM] = {};
-    std::mutex outputs_mutex[EYE_NUM];
     std::mutex results_mutex[EYE_NUM];
 
+    // 一次推理的关键点，界面线程用来画在画面上
+    struct EyeLandmarks {
+        bool valid = false;
+        std::array<float, EYE_OUTPUT_SIZE> points{};
+    };
+    // 一次推理的结果，发送线程据此计算 OSC 输出
+    struct EyeResult {
+        double eye_open = 0.0;
+        float pupil_x = 0.0f;
+        float pupil_y = 0.0f;
+        std::chrono::steady_clock::time_point time;
+    };
+    // 推理线程发布结果不等待读取方，发送和界面更新再慢也不会阻塞推理
+    utils::SeqLock<EyeLandmarks> landmarks[EYE_NUM];
+    utils::SeqLock<EyeResult> eye_results[EYE_NUM];
+    OutputResampler output_resampler{OutputResampler::configuredOptions(ResampleMode::LINEAR)};
+    FrameTransformCache frame_transform[EYE_NUM];
+    // 窗口是否显示，由界面线程在显示和隐藏时更新，预览阶段据此跳过绘制；isVisible() 只能在界面线程调用
+    std::atomic<bool> preview_visible = false;
+
     float calibration_percentile_90[EYE_NUM];
     float calibration_percentile_2[EYE_NUM];
     std::vector<double> open_list[EYE_NUM];
@@ -249,6 +285,8 @@ private:
     // QSoundEffect* startSound;
     // QSoundEffect* endSound;
     QTimer* auto_save_timer= nullptr;
+    // 上一次自动保存的写文件任务，关闭窗口时先等它写完再同步保存
+    std::future<void> auto_save_result;
     // 用于绘制眼睛位置的自定义小部件
     class EyePositionWidget : public QWidget {
     public:
@@ -315,6 +353,7 @@ private:
     QComboBox *EnergyModelBox;
     QPlainTextEdit *LogText;
     bool showSerialData = false;
+    bool serial_connection_checked = false;
     QLabel *LeftEyeImage;
     QPushButton *RestartButton;
     QLabel *label;
@@ -10,12 +10,18 @@
 #include <future>
 #include <atomic>
 #include <algorithm>
+#include <array>
 #include <config_writer.hpp>
 #include <image_downloader.hpp>
 #include <osc.hpp>
 #include <QTimer>
 #include <QLineEdit>  // 确保包含该头文件
 #include "face_inference.hpp"
+#include "frame_transform.hpp"
+#include "output_resampler.hpp"
+#include "pipeline.hpp"
+#include "seqlock.hpp"
+#include "thread_pool.hpp"
 #include "serial.hpp"
 #include "logger.hpp"
 #include "updater.hpp"
@@ -136,7 +142,7 @@ public:
     std::string getSSID() const;
     std::string getPassword() const;
 
-    void setVideoImage(const cv::Mat& image);
+    void setVideoImage(cv::Mat image);
     // 根据模型输出更新校准页面的进度条
     void updateCalibrationProgressBars(
         const std::vector<float>& output,
@@ -148,7 +154,6 @@ public:
     using FuncWithVal = std::function<void(int)>;
     // let user decide what to do with these action
     void setOnUseFilterClickedFunc(FuncWithVal func);
-    void set_osc_send_thead(FuncWithoutArgs func);
 
     bool is_running() const;
 
@@ -166,8 +171,12 @@ public:
     void updateWifiLabel() const;
     void updateBatteryStatus() const;
     void updateSerialLabel() const;
+    // 首次设备枚举完成和之后设备插拔时调用
+    void onSerialConnectionChanged(bool connected);
 
     cv::Mat getVideoImage() const;
+    // 当前来源的最新帧缩放并旋转后的结果，每帧只计算一次，预览和推理共享，只能读取
+    cv::Mat getTransformedImage();
     std::string getFirmwareVersion() const;
     SerialStatus getSerialStatus() const;
 
@@ -257,6 +266,7 @@ private:
     void start_image_download() const;
     std::vector<std::string> serialRawDataLog;
     bool showSerialData = false;
+    bool serial_connection_checked = false;
     QLabel* roiStatusLabel = nullptr;
     FuncWithVal onRotateAngleChangedFunc;
     FuncWithVal onUseFilterClickedFunc;
@@ -306,14 +316,15 @@ private:
 
     Rect roi_rect;
     void updateOffsetsToInference();
-    std::thread update_thread;
-    std::thread inference_thread;
-    std::thread osc_send_thread;
+    // 预览、推理、发送三个阶段
+    utils::Pipeline pipeline{"面捕"};
     bool app_is_running = true;
     int max_fps = 38;
 
     std::shared_ptr<SerialPortManager> serial_port_manager;
     std::shared_ptr<ESP32VideoStream> image_downloader;
+    // 命令行指定的回放等替代来源，设置后优先于设备视频流
+    std::shared_ptr<FrameSource> override_source;
     std::shared_ptr<FaceInference> inference;
     std::shared_ptr<OscManager> osc_manager;
     std::shared_ptr<ConfigWriter> config_writer;
@@ -374,12 +385,27 @@ private:
     float current_dt = 0.02f;
     float current_q_factor = 1.5f;
     float current_r_factor = 0.0003f;
-    std::vector<float> outputs;
-    std::mutex outputs_mutex;
+    // 一次推理的输出，FaceInference::get_output 固定为 90 个值
+    static constexpr std::size_t MAX_FACE_OUTPUTS = 96;
+    struct FaceResult {
+        uint32_t count = 0;
+        std::array<float, MAX_FACE_OUTPUTS> values{};
+    };
+    // 推理阶段发布结果不等待读取方，版本号变化说明有新结果
+    utils::SeqLock<FaceResult> face_results;
+    // 默认不重采样，推理结果到达即发送；开启后发送线程按固定频率取插值或预测值
+    OutputResampler output_resampler{OutputResampler::configuredOptions(ResampleMode::OFF)};
+    FrameTransformCache frame_transform;
+    // 窗口是否显示，由界面线程在显示和隐藏时更新，预览阶段据此跳过绘制；isVisible() 只能在界面线程调用
+    std::atomic<bool> preview_visible = false;
     QTimer* auto_save_timer;
+    // 上一次自动保存的写文件任务，关闭窗口时先等它写完再同步保存
+    std::future<void> auto_save_result;
     inline static PaperFaceTrackerWindow* instance = nullptr;
 protected:
     bool eventFilter(QObject *obj, QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
     // UI元素指针声明
     QStackedWidget *stackedWidget;
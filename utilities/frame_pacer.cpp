@@ -0,0 +1,159 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "frame_pacer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+namespace utils {
+
+namespace {
+
+// 统计值的平滑系数
+constexpr double STATS_SMOOTHING = 0.05;
+// 自旋提前量的范围和初始值。定时器精度提高到 1 ms 后粗睡眠一般只睡过头几百微秒，
+// 上限再大只是白白占用 CPU
+constexpr double MIN_SPIN_US = 100.0;
+constexpr double MAX_SPIN_US = 1000.0;
+constexpr double INITIAL_SPIN_US = 500.0;
+
+std::chrono::microseconds toMicroseconds(double us)
+{
+    return std::chrono::microseconds(static_cast<int64_t>(us));
+}
+
+} // namespace
+
+FramePacer::FramePacer(double rate, bool spin)
+    : spin(spin), spin_margin(toMicroseconds(INITIAL_SPIN_US))
+{
+    setRate(rate);
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+    if (timer_resolution_raised) {
+        timeEndPeriod(1);
+    }
+#endif
+}
+
+void FramePacer::setRate(double rate)
+{
+    rate = std::isfinite(rate) && rate > 0.0 ? rate : 0.0;
+    if (rate == target_rate) {
+        return;
+    }
+    target_rate = rate;
+    period = rate > 0.0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate))
+        : Clock::duration::zero();
+    // 新周期从上一帧实际执行的时刻算起
+    if (scheduled) {
+        deadline = last_frame;
+    }
+}
+
+bool FramePacer::wait(const SleepFunction& sleep)
+{
+    auto now = Clock::now();
+    if (target_rate <= 0.0 || !scheduled) {
+        deadline = now;
+        scheduled = target_rate > 0.0;
+#ifdef _WIN32
+        // 默认 15.6 ms 的定时器精度下，66 Hz 的睡眠会被拉长到 2 个时钟周期
+        if (scheduled && !timer_resolution_raised) {
+            timer_resolution_raised = timeBeginPeriod(1) == TIMERR_NOERROR;
+        }
+#endif
+        recordFrame(now);
+        return true;
+    }
+
+    deadline += period;
+    if (now >= deadline) {
+        ++statistics.late;
+        if (now - deadline > period) {
+            ++statistics.skipped;
+            deadline = now;
+        }
+        recordFrame(now);
+        return true;
+    }
+
+    if (!spin) {
+        if (!sleep(deadline)) {
+            return false;
+        }
+        recordFrame(Clock::now());
+        return true;
+    }
+
+    const auto wake_target = deadline - spin_margin;
+    if (now < wake_target) {
+        if (!sleep(wake_target)) {
+            return false;
+        }
+        now = Clock::now();
+        const double oversleep = std::chrono::duration<double, std::micro>(now - wake_target).count();
+        oversleep_us += STATS_SMOOTHING * (std::max<double>(0.0, oversleep) - oversleep_us);
+        const double period_us = std::chrono::duration<double, std::micro>(period).count();
+        const double margin = std::clamp(oversleep_us * 1.5 + MIN_SPIN_US, MIN_SPIN_US,
+                                         std::min<double>(MAX_SPIN_US, period_us / 2));
+        spin_margin = toMicroseconds(margin);
+    }
+    while (now < deadline) {
+        std::this_thread::yield();
+        now = Clock::now();
+    }
+    recordFrame(now);
+    return true;
+}
+
+bool FramePacer::wait()
+{
+    return wait([](Clock::time_point time) {
+        std::this_thread::sleep_until(time);
+        return true;
+    });
+}
+
+void FramePacer::reset()
+{
+    scheduled = false;
+}
+
+void FramePacer::recordFrame(Clock::time_point now)
+{
+    if (statistics.frames > 0) {
+        // 平滑间隔再取倒数，补偿迟到的短间隔不会把频率估高
+        const double interval = std::chrono::duration<double>(now - last_frame).count();
+        average_interval = statistics.frames == 1 ? interval
+                                                  : average_interval + STATS_SMOOTHING * (interval - average_interval);
+        statistics.rate = average_interval > 0.0 ? 1.0 / average_interval : 0.0;
+    }
+    if (target_rate > 0.0) {
+        const double error = std::abs(std::chrono::duration<double, std::milli>(now - deadline).count());
+        statistics.jitter_ms += STATS_SMOOTHING * (error - statistics.jitter_ms);
+    }
+    last_frame = now;
+    ++statistics.frames;
+}
+
+} // namespace utils
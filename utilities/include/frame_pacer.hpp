@@ -0,0 +1,76 @@
+// frame_pacer.hpp - 基于绝对截止时间的高精度节拍器，可选在粗睡眠后短暂自旋
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace utils {
+
+struct FramePacerStats {
+    double rate = 0.0;       // 最近实际达到的每秒帧数
+    double jitter_ms = 0.0;  // 醒来时刻偏离截止时间的平均值
+    uint64_t frames = 0;
+    uint64_t late = 0;       // 调用 wait 时已经过了截止时间的次数
+    uint64_t skipped = 0;    // 落后超过一个周期、放弃补帧重新计时的次数
+};
+
+// 截止时间按周期累加，而不是从上次醒来的时刻重新计算，睡过头的部分会从下一个周期里扣回，
+// 长期频率不漂移。默认直接用可打断的睡眠等到截止时间；打开自旋后提前一小段醒来，
+// 剩下的时间让出时间片自旋等待，提前量根据实际睡过头的时间自动调整，最多 1 ms。
+// Windows 上开始限速时把系统定时器精度提高到 1 ms，析构时恢复。
+// 只落后不到一个周期时立即执行并保持原来的节拍，落后更多时从现在重新计时，不会连续补发
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+    // 粗睡眠到指定时刻，被打断时返回 false
+    using SleepFunction = std::function<bool(Clock::time_point)>;
+
+    explicit FramePacer(double rate = 0.0, bool spin = false);
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // 频率变化时从下一帧开始按新周期计时，0 表示不限速
+    void setRate(double rate);
+    double rate() const { return target_rate; }
+
+    // 自旋等待截止时间，抖动更小但每帧多占最多 1 ms 的 CPU，只给对输出时刻敏感的线程打开
+    void setSpin(bool enabled) { spin = enabled; }
+    bool spinning() const { return spin; }
+
+    // 等到下一帧的截止时间，第一次调用立即返回。sleep 返回 false 时放弃等待并返回 false
+    bool wait(const SleepFunction& sleep);
+    // 用 std::this_thread::sleep_until 粗睡眠
+    bool wait();
+
+    // 丢弃当前节拍，下一次 wait 立即返回
+    void reset();
+
+    const FramePacerStats& stats() const { return statistics; }
+
+private:
+    void recordFrame(Clock::time_point now);
+
+    double target_rate = 0.0;
+    Clock::duration period{};
+    Clock::time_point deadline{};
+    Clock::time_point last_frame{};
+    bool scheduled = false;
+    bool spin = false;
+    // 是否已经提高了系统定时器精度
+    bool timer_resolution_raised = false;
+    // 粗睡眠提前结束的时间，之后自旋到截止时间
+    Clock::duration spin_margin;
+    // 粗睡眠平均睡过头的时间
+    double oversleep_us = 0.0;
+    // 平滑后的帧间隔，单位秒
+    double average_interval = 0.0;
+    FramePacerStats statistics;
+};
+
+} // namespace utils
+
+#endif // FRAME_PACER_HPP
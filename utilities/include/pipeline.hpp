@@ -0,0 +1,135 @@
+// pipeline.hpp - 追踪窗口的阶段运行时：统一的节拍、统计和取消
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "frame_pacer.hpp"
+
+namespace utils {
+
+struct StageMetrics {
+    std::string name;
+    uint64_t iterations = 0;
+    double rate = 0.0;       // 最近的每秒迭代次数
+    double busy_ms = 0.0;    // 最近每次迭代的平均耗时
+    uint64_t overruns = 0;   // 没有赶上节拍截止时间的迭代次数
+    double jitter_ms = 0.0;  // 限速阶段醒来时刻偏离截止时间的平均值
+};
+
+class Pipeline;
+
+// 传给阶段函数的上下文，阶段内所有等待都要经过它，停止时立即返回
+class StageContext {
+public:
+    bool running() const;
+    // 距上一次迭代开始的秒数，第一次迭代为 0
+    double interval() const { return last_interval; }
+
+    // 等到 deadline 或 predicate 成立。停止时返回 false，否则返回 predicate 的结果
+    template <typename Predicate>
+    bool waitUntil(std::chrono::steady_clock::time_point deadline, Predicate predicate);
+    // 一直等到 predicate 成立，停止时返回 false
+    template <typename Predicate>
+    bool wait(Predicate predicate);
+    bool sleepUntil(std::chrono::steady_clock::time_point deadline);
+
+private:
+    friend class Pipeline;
+    explicit StageContext(Pipeline& pipeline) : pipeline(pipeline) {}
+
+    Pipeline& pipeline;
+    double last_interval = 0.0;
+};
+
+// 每个阶段是一个反复执行的函数，运行在自己的线程上。运行时负责按节拍调用、统计耗时，
+// 停止时唤醒所有等待中的阶段并回收线程，阶段函数里不再需要 sleep 和 is_running 轮询
+class Pipeline {
+public:
+    using Body = std::function<void(StageContext&)>;
+
+    struct StageOptions {
+        // 每秒迭代次数，每次迭代前调用，可以随设置变化，由 FramePacer 按绝对截止时间节拍。为空或返回 0 时不限速，
+        // 由阶段函数自己通过 StageContext 等待输入
+        std::function<double()> rate;
+        // 第一次迭代前的等待时间
+        std::chrono::milliseconds start_delay{0};
+        // 线程角色，线程启动时按 ThreadPolicies 中的配置设置优先级和 CPU 亲和性，为空时不设置
+        std::string policy;
+        // 限速时在截止时间前自旋，见 FramePacer::setSpin
+        bool spin = false;
+    };
+
+    explicit Pipeline(std::string name);
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // start 之前调用
+    void addStage(std::string stage_name, StageOptions options, Body body);
+
+    void start();
+    // 停止所有阶段并等待线程退出，会打断正在进行的等待，可重复调用
+    void stop();
+    bool running() const { return !stopping.load(std::memory_order_acquire); }
+
+    // 生产者发布新数据后调用，唤醒在 StageContext::wait 中等待的阶段
+    void notify();
+
+    std::vector<StageMetrics> metrics() const;
+
+private:
+    friend class StageContext;
+
+    struct Stage {
+        std::string name;
+        StageOptions options;
+        Body body;
+        std::thread thread;
+        FramePacer pacer;
+        std::atomic<uint64_t> iterations = 0;
+        std::atomic<uint64_t> overruns = 0;
+        std::atomic<double> rate = 0.0;
+        std::atomic<double> busy_ms = 0.0;
+        std::atomic<double> jitter_ms = 0.0;
+    };
+
+    void run(Stage& stage);
+
+    std::string name;
+    std::vector<std::unique_ptr<Stage>> stages;
+    std::atomic<bool> stopping = false;
+    bool started = false;
+    // 所有阶段共用的等待点，notify 和 stop 在持有它时改变状态，唤醒不会丢失
+    mutable std::mutex wait_mutex;
+    std::condition_variable wait_cv;
+};
+
+template <typename Predicate>
+bool StageContext::waitUntil(std::chrono::steady_clock::time_point deadline, Predicate predicate)
+{
+    std::unique_lock<std::mutex> lock(pipeline.wait_mutex);
+    pipeline.wait_cv.wait_until(lock, deadline, [&] { return !pipeline.running() || predicate(); });
+    return pipeline.running() && predicate();
+}
+
+template <typename Predicate>
+bool StageContext::wait(Predicate predicate)
+{
+    std::unique_lock<std::mutex> lock(pipeline.wait_mutex);
+    pipeline.wait_cv.wait(lock, [&] { return !pipeline.running() || predicate(); });
+    return pipeline.running();
+}
+
+} // namespace utils
+
+#endif // PIPELINE_HPP
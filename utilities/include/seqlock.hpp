@@ -0,0 +1,66 @@
+// seqlock.hpp - 单写多读的结果交换，写入方从不等待读取方
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace utils {
+
+// 推理线程发布最新结果，发送线程和界面线程读取。写入期间 seq 为奇数，写完后为偶数；
+// 读取方在拷贝前后各读一次 seq，两次相同且为偶数时拷贝完整，否则重试。
+// 读取方拷贝的是整份 T，拿到之后做多慢的处理（网络发送、界面更新）都不会影响写入方
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock 只能保存可平凡拷贝的类型");
+
+public:
+    SeqLock() = default;
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // 只允许一个线程写入
+    void store(const T& value)
+    {
+        const uint64_t start = seq.load(std::memory_order_relaxed);
+        seq.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&data, &value, sizeof(T));
+        seq.store(start + 2, std::memory_order_release);
+    }
+
+    // 拷贝最新的结果，返回它的版本号：第 n 次 store 的结果版本号为 n，从未写入时为 0
+    uint64_t load(T& out) const
+    {
+        for (;;) {
+            const uint64_t start = seq.load(std::memory_order_acquire);
+            if (start & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::memcpy(&out, &data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == start) {
+                return start / 2;
+            }
+        }
+    }
+
+    // 已经写完的结果个数，用来判断有没有新结果而不拷贝数据
+    uint64_t version() const
+    {
+        return seq.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    // seq 单独占一个缓存行，读取方轮询版本号时不和数据所在的行争用
+    alignas(64) std::atomic<uint64_t> seq = 0;
+    alignas(64) T data{};
+};
+
+} // namespace utils
+
+#endif // SEQLOCK_HPP
@@ -0,0 +1,78 @@
+// thread_policy.hpp - 按角色设置追踪线程的优先级、CPU 亲和性，以及进程内存锁定
+#ifndef THREAD_POLICY_HPP
+#define THREAD_POLICY_HPP
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+namespace utils {
+
+enum class ThreadPriority : int {
+    INVALID = -1, // 配置文件中无法识别的值，configure 时给出警告并按 NORMAL 处理
+    NORMAL = 0,
+    ABOVE_NORMAL,
+    HIGH,
+    REALTIME // Linux 上为 SCHED_FIFO，需要 CAP_SYS_NICE；Windows 上为 TIME_CRITICAL
+};
+
+// 配置文件中写作 "normal"、"above_normal"、"high"、"realtime"，其他值读取为 INVALID
+NLOHMANN_JSON_SERIALIZE_ENUM(ThreadPriority, {
+    {ThreadPriority::INVALID, nullptr},
+    {ThreadPriority::NORMAL, "normal"},
+    {ThreadPriority::ABOVE_NORMAL, "above_normal"},
+    {ThreadPriority::HIGH, "high"},
+    {ThreadPriority::REALTIME, "realtime"},
+})
+
+struct ThreadPolicy {
+    ThreadPriority priority = ThreadPriority::NORMAL;
+    std::vector<int> cpus;  // 允许运行的 CPU 编号，为空时不限制
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(ThreadPolicy, priority, cpus);
+};
+
+// 保存在 thread_policy.json 中，缺少的项使用默认值
+struct ThreadPolicyConfig {
+    // 锁定进程内存，游戏占用大量内存时追踪线程不会因为缺页而卡顿
+    bool lock_memory = false;
+    // 应用策略前后各测量一次线程的调度延迟并写入日志
+    bool measure_latency = false;
+    // 键为线程角色：inference 推理，emit 发送结果，decode 接收和解码图像，preview 界面预览
+    std::map<std::string, ThreadPolicy> threads = {
+        {"inference", {}},
+        {"emit", {}},
+        {"decode", {}},
+        {"preview", {}},
+    };
+
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(ThreadPolicyConfig, lock_memory, measure_latency, threads);
+};
+
+struct SchedulingLatency {
+    double mean_us = 0.0;   // 醒来比预期晚的平均时间
+    double jitter_us = 0.0; // 延迟的标准差
+    double p99_us = 0.0;
+    double max_us = 0.0;
+};
+
+// 线程在开始工作前调用 apply 设置自己。设置失败（例如权限不足）只记录警告，线程照常运行
+class ThreadPolicies {
+public:
+    // 程序启动时调用一次，锁定内存等进程级的设置在这里生效
+    static void configure(const ThreadPolicyConfig& config);
+    static ThreadPolicyConfig config();
+
+    // 按角色设置当前线程，没有配置或保持默认的角色不做任何改变
+    static void apply(const std::string& role);
+
+    // 在当前线程上反复睡眠 interval，统计实际醒来的时刻比预期晚多少
+    static SchedulingLatency measureLatency(int samples = 100,
+                                            std::chrono::microseconds interval = std::chrono::microseconds(1000));
+};
+
+} // namespace utils
+
+#endif // THREAD_POLICY_HPP
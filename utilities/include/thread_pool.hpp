@@ -5,192 +5,390 @@
 #ifndef THREAD_POOL_HPP
 #define THREAD_POOL_HPP
 
-#include <cassert>
-#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <future>
-#include <iostream>
+#include <iterator>
+#include <memory>
 #include <mutex>
-#include <optional>
-#include <ostream>
-#include <queue>
-#include <random>
-#include <sstream>
-#include <string>
+#include <shared_mutex>
 #include <thread>
-#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace utils {
 
-enum class TaskStatus : uint8_t { WAITING = 0, RUNNING, FINISHED };
-
-enum class WorkerStatus : uint8_t { IDLE = 0, RUNNING };
+// 高优先级用于推理等延迟敏感的任务，低优先级用于保存配置、写日志等杂项，
+// 只有所有高优先级任务都被取走后才会执行低优先级任务
+enum class TaskPriority : uint8_t { HIGH = 0, LOW };
 
+// 每个工作线程有自己的任务队列。线程池内部提交的任务放在当前线程队列的尾部并按后进先出执行，
+// 外部提交的任务轮流放在各个线程队列的头部，保持先进先出；线程自己的队列空了就从其他线程的队列头部偷取任务
 class ThreadPool {
 private:
+    using Task = std::function<void(void)>;
+    static constexpr std::size_t PRIORITY_NUM = 2;
+
     struct Worker {
         std::thread worker_thread;
-        WorkerStatus status = WorkerStatus::IDLE;
+        std::mutex queue_mutex;
+        std::deque<Task> tasks[PRIORITY_NUM];
+        std::atomic<bool> exit = false;
 
         void join() {
-            worker_thread.join();
+            if (worker_thread.joinable()) {
+                worker_thread.join();
+            }
         }
     };
 
 public:
     explicit ThreadPool(std::size_t nums_threads) {
-        auto worker_func = [this] {
-            while (true) {
-                Task task;
-                {
-                    std::unique_lock<std::mutex> lock(this->m_queue_mutex);
-                    this->m_condition.wait(lock, [this] { return this->m_stop || !this->m_tasks.empty(); });
-                    if (this->m_stop || this->m_tasks.empty()) {
-                        return;
-                    }
-                    task = std::move(m_tasks.front());
-                    this->m_tasks.pop_front();
-                }
-                task();
-            }
-        };
-        for (std::size_t i = 0; i < nums_threads; i++) {
-            m_workers.emplace_back(Worker {
-                .worker_thread = std::thread(worker_func),
-                .status = WorkerStatus::IDLE,
-            });
-        }
+        add_worker(nums_threads);
+    }
+
+    // 以高优先级提交任务，返回任务结果的 future。线程池停止后提交的任务不会执行，
+    // 对应的 future 会抛出 broken_promise
+    template<typename F, typename... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        return submit_with_priority(TaskPriority::HIGH, std::forward<F>(f), std::forward<Args>(args)...);
     }
 
     template<typename F, typename... Args>
-    void submit(F&& f, Args&&... args) {
-        using ReturnType = void;
+    auto submit_with_priority(TaskPriority priority, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+        using ReturnType = std::invoke_result_t<F, Args...>;
 
         auto task = std::make_shared<std::packaged_task<ReturnType()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+            [f = std::forward<F>(f), ... args = std::forward<Args>(args)]() mutable {
+                return std::invoke(std::move(f), std::move(args)...);
+            }
         );
         std::future<ReturnType> result = task->get_future();
+        enqueue(Task([task] { (*task)(); }), priority);
+        return result;
+    }
 
-        {
-            Task t([task] { (*task)(); });
-            std::lock_guard<std::mutex> lock(m_queue_mutex);
-            if (m_stop) {
-                return ;
-            }
-            m_tasks.push_back(std::move(t));
+    // 把 [begin, end) 分成若干块并行执行 func(i)，调用线程也参与执行，全部完成后返回。
+    // grain 为每块的大小，0 表示按线程数自动划分。任意一次调用抛出的异常会在这里重新抛出
+    template<typename F>
+    void parallel_for(std::size_t begin, std::size_t end, F&& func, std::size_t grain = 0) {
+        if (begin >= end) {
+            return;
+        }
+        const std::size_t count = end - begin;
+        const std::size_t workers = std::max<std::size_t>(1, worker_num());
+        if (grain == 0) {
+            grain = std::max<std::size_t>(1, count / (workers * 4));
         }
+        const std::size_t chunks = (count + grain - 1) / grain;
 
-        m_condition.notify_one();
-        return;
-    }
+        // 其他线程上的辅助任务可能在调用返回后才开始执行，共享状态由它们一起持有
+        struct State {
+            std::function<void(std::size_t)> func;
+            std::size_t begin, end, grain, chunks;
+            std::atomic<std::size_t> next_chunk = 0;
+            std::atomic<std::size_t> done_chunks = 0;
+            std::mutex done_mutex;
+            std::condition_variable done_condition;
+            std::exception_ptr error;
 
-    void stop() {
-        {
-            std::lock_guard<std::mutex> lock(m_queue_mutex);
-            m_stop = true;
+            // 领取并执行剩余的块，没有剩余时返回
+            void run() {
+                for (std::size_t chunk = next_chunk++; chunk < chunks; chunk = next_chunk++) {
+                    const std::size_t first = begin + chunk * grain;
+                    const std::size_t last = std::min(end, first + grain);
+                    try {
+                        for (std::size_t i = first; i < last; ++i) {
+                            func(i);
+                        }
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(done_mutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                    if (++done_chunks == chunks) {
+                        std::lock_guard<std::mutex> lock(done_mutex);
+                        done_condition.notify_all();
+                    }
+                }
+            }
+        };
+        auto state = std::make_shared<State>();
+        state->func = std::forward<F>(func);
+        state->begin = begin;
+        state->end = end;
+        state->grain = grain;
+        state->chunks = chunks;
+
+        const std::size_t helpers = std::min(chunks, workers + 1) - 1;
+        for (std::size_t i = 0; i < helpers; i++) {
+            enqueue(Task([state] { state->run(); }), TaskPriority::HIGH);
         }
-        m_condition.notify_all();
+        state->run();
 
-        for (auto& worker: m_workers) {
-            worker.join();
+        std::unique_lock<std::mutex> lock(state->done_mutex);
+        state->done_condition.wait(lock, [&state] { return state->done_chunks.load() == state->chunks; });
+        if (state->error) {
+            std::rethrow_exception(state->error);
         }
     }
 
-    void stop_now() {
-        m_stop = true;
-        m_condition.notify_all();
+    // 执行完已经提交的任务后停止
+    void stop() {
+        shutdown(false);
+    }
 
-        for (auto& worker: m_workers) {
-            worker.join();
-        }
+    // 丢弃还没开始的任务立即停止，它们的 future 会抛出 broken_promise
+    void stop_now() {
+        shutdown(true);
     }
 
-    // it won't take effect immediately because this will wait for enough workers to finish their current task
     void resize_worker(std::size_t nums_threads) {
-        // lock has been got by sub function in "add worker" and "delete worker"
-        if (nums_threads > m_workers.size()) {
-            add_worker(nums_threads - m_workers.size());
-        } else if (nums_threads < m_workers.size()) {
-            delete_worker(m_workers.size() - nums_threads);
+        const std::size_t current = worker_num();
+        if (nums_threads > current) {
+            add_worker(nums_threads - current);
+        } else if (nums_threads < current) {
+            delete_worker(current - nums_threads);
         }
     }
 
     void add_worker(std::size_t nums_threads) {
-        auto worker_func = [this] {
-            while (true) {
-                Task task;
-                {
-                    std::unique_lock<std::mutex> lock(this->m_queue_mutex);
-                    this->m_condition.wait(lock, [this] { return this->m_stop || !this->m_tasks.empty(); });
-                    if (this->m_stop || this->m_tasks.empty()) {
-                        return;
-                    }
-                    task = std::move(m_tasks.front());
-                    this->m_tasks.pop_front();
-                }
-                task();
-            }
-        };
-        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        std::unique_lock<std::shared_mutex> lock(m_workers_mutex);
+        if (m_stop) {
+            return;
+        }
         for (std::size_t i = 0; i < nums_threads; i++) {
-            m_workers.emplace_back(Worker {
-                .worker_thread = std::thread(worker_func),
-                .status = WorkerStatus::IDLE,
-            });
+            auto worker = std::make_shared<Worker>();
+            worker->worker_thread = std::thread([this, raw = worker.get()] { worker_loop(*raw); });
+            m_workers.push_back(std::move(worker));
         }
     }
 
+    // 通知最后几个线程退出并等待它们执行完当前任务，它们队列里剩余的任务交给其他线程。
+    // 至少保留一个线程。在池内任务中调用时不会选中当前线程，否则会等待自己退出而死锁
     void delete_worker(std::size_t nums_threads) {
-        if (m_workers.empty()) {
-            return;
+        std::vector<std::shared_ptr<Worker>> removed;
+        std::deque<Task> orphaned[PRIORITY_NUM];
+        {
+            std::unique_lock<std::shared_mutex> lock(m_workers_mutex);
+            const Worker* self = current_worker().pool == this ? current_worker().worker : nullptr;
+            nums_threads = std::min(nums_threads, m_workers.empty() ? 0 : m_workers.size() - 1);
+            // 从后往前挑选，跳过当前线程。保留的线程至少有一个，所以总能选够
+            for (std::size_t index = m_workers.size(); index > 0 && removed.size() < nums_threads; index--) {
+                if (m_workers[index - 1].get() == self) {
+                    continue;
+                }
+                auto worker = std::move(m_workers[index - 1]);
+                m_workers.erase(m_workers.begin() + static_cast<std::ptrdiff_t>(index - 1));
+                worker->exit = true;
+                std::lock_guard<std::mutex> queue_lock(worker->queue_mutex);
+                for (std::size_t lane = 0; lane < PRIORITY_NUM; lane++) {
+                    m_pending -= worker->tasks[lane].size();
+                    std::move(worker->tasks[lane].begin(), worker->tasks[lane].end(), std::back_inserter(orphaned[lane]));
+                    worker->tasks[lane].clear();
+                }
+                removed.push_back(std::move(worker));
+            }
         }
-        std::lock_guard<std::mutex> lock(m_queue_mutex);
-        for (std::size_t i = 0; i < nums_threads; i++) {
-            m_workers.back().join();
-            m_workers.pop_back();
+        wake_all();
+        for (std::size_t lane = 0; lane < PRIORITY_NUM; lane++) {
+            for (auto& task : orphaned[lane]) {
+                enqueue(std::move(task), static_cast<TaskPriority>(lane));
+            }
+        }
+        for (auto& worker : removed) {
+            worker->join();
         }
     }
 
     [[nodiscard]] bool is_running() const {
-        return !m_stop;
+        return !m_stop.load();
     }
 
     ~ThreadPool() {
-        if (!this->m_stop) {
-            this->stop();
-        }
+        stop();
     }
 
     std::size_t worker_num() const {
+        std::shared_lock<std::shared_mutex> lock(m_workers_mutex);
         return m_workers.size();
     }
 
     /**
-     * @brief get the number of tasks in the idle queue
+     * @brief get the number of tasks waiting in all worker queues
      */
     std::size_t task_num() const {
-        return m_tasks.size();
+        return m_pending.load();
     }
 
     using SharedPtr = std::shared_ptr<ThreadPool>;
     using UniquePtr = std::unique_ptr<ThreadPool>;
 
 private:
-    using Task = std::function<void(void)>;
+    void enqueue(Task task, TaskPriority priority) {
+        const auto lane = static_cast<std::size_t>(priority);
+        {
+            // 提交和偷取只读取线程列表，可以同时进行；只有增减线程时独占
+            std::shared_lock<std::shared_mutex> lock(m_workers_mutex);
+            if (m_stop || m_workers.empty()) {
+                // task 在这里析构，对应的 future 得到 broken_promise
+                return;
+            }
+            // 线程池内部提交的任务留在当前线程，外部提交的轮流分配
+            Worker* target = current_worker().pool == this ? current_worker().worker : nullptr;
+            const bool internal = target && !target->exit;
+            if (!internal) {
+                target = m_workers[m_next_worker++ % m_workers.size()].get();
+            }
+            std::lock_guard<std::mutex> queue_lock(target->queue_mutex);
+            if (internal) {
+                target->tasks[lane].push_back(std::move(task));
+            } else {
+                target->tasks[lane].push_front(std::move(task));
+            }
+            m_pending++;
+        }
+        // 先增加 m_pending 再检查 m_idle，和睡眠前的顺序相反，两边至少有一方能看到对方。
+        // 所有线程都在忙时不用碰 m_sleep_mutex
+        if (m_idle.load() > 0) {
+            // 空的加锁保证正在检查 m_pending 准备睡眠的线程不会错过这次唤醒
+            {
+                std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            }
+            m_condition.notify_one();
+        }
+    }
 
-    std::vector<Worker> m_workers;
-    std::deque<Task> m_tasks;
+    bool pop_task(Worker& self, Task& task) {
+        for (std::size_t lane = 0; lane < PRIORITY_NUM; lane++) {
+            {
+                std::lock_guard<std::mutex> lock(self.queue_mutex);
+                if (!self.tasks[lane].empty()) {
+                    task = std::move(self.tasks[lane].back());
+                    self.tasks[lane].pop_back();
+                    m_pending--;
+                    return true;
+                }
+            }
+            if (steal_task(self, lane, task)) {
+                return true;
+            }
+        }
+        return false;
+    }
 
-    std::mutex m_queue_mutex;
+    bool steal_task(Worker& self, std::size_t lane, Task& task) {
+        std::shared_lock<std::shared_mutex> lock(m_workers_mutex);
+        const std::size_t count = m_workers.size();
+        // 从不同的位置开始偷，避免所有线程都去抢第一个队列
+        const std::size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        for (std::size_t i = 0; i < count; i++) {
+            Worker& victim = *m_workers[(start + i) % count];
+            if (&victim == &self) {
+                continue;
+            }
+            std::lock_guard<std::mutex> queue_lock(victim.queue_mutex);
+            if (!victim.tasks[lane].empty()) {
+                task = std::move(victim.tasks[lane].front());
+                victim.tasks[lane].pop_front();
+                m_pending--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(Worker& self) {
+        current_worker() = {this, &self};
+        while (true) {
+            Task task;
+            if (!self.exit && !(m_stop && m_drop_pending) && pop_task(self, task)) {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            if (self.exit || (m_stop && (m_drop_pending || m_pending == 0))) {
+                return;
+            }
+            m_idle++;
+            m_condition.wait(lock, [this, &self] {
+                return self.exit || m_stop || m_pending > 0;
+            });
+            m_idle--;
+        }
+    }
+
+    void shutdown(bool drop_pending) {
+        {
+            std::unique_lock<std::shared_mutex> lock(m_workers_mutex);
+            if (m_stop) {
+                return;
+            }
+            m_drop_pending = drop_pending;
+            m_stop = true;
+        }
+        wake_all();
+
+        std::vector<std::shared_ptr<Worker>> workers;
+        {
+            std::shared_lock<std::shared_mutex> lock(m_workers_mutex);
+            workers = m_workers;
+        }
+        for (auto& worker : workers) {
+            worker->join();
+        }
+        std::unique_lock<std::shared_mutex> lock(m_workers_mutex);
+        m_workers.clear();
+        m_pending = 0;
+    }
+
+    void wake_all() {
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        }
+        m_condition.notify_all();
+    }
+
+    // 当前线程所属的线程池和工作线程，不是工作线程时为空
+    struct CurrentWorker {
+        ThreadPool* pool = nullptr;
+        Worker* worker = nullptr;
+    };
+    static CurrentWorker& current_worker() {
+        thread_local CurrentWorker current;
+        return current;
+    }
+
+    std::vector<std::shared_ptr<Worker>> m_workers;
+    mutable std::shared_mutex m_workers_mutex;
+    std::atomic<std::size_t> m_next_worker = 0;
+
+    // 所有队列中的任务总数，空闲线程据此判断是否需要醒来
+    std::atomic<std::size_t> m_pending = 0;
+    // 正在睡眠或准备睡眠的线程数
+    std::atomic<std::size_t> m_idle = 0;
+    std::mutex m_sleep_mutex;
     std::condition_variable m_condition;
 
-    bool m_stop = false;
+    std::atomic<bool> m_stop = false;
+    std::atomic<bool> m_drop_pending = false;
 };
 
+// 进程内共享的后台线程池。保存配置等不该卡住界面线程的杂项提交到这里，一般使用低优先级
+inline ThreadPool& background_pool() {
+    static ThreadPool pool(2);
+    return pool;
+}
+
 } // namespace utils
 
 #endif //THREAD_POOL_HPP
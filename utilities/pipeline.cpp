@@ -0,0 +1,173 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "pipeline.hpp"
+#include <exception>
+#include "logger.hpp"
+#include "thread_policy.hpp"
+
+namespace utils {
+
+namespace {
+
+// 统计值的平滑系数，大约反映最近几十次迭代
+constexpr double METRICS_SMOOTHING = 0.05;
+
+} // namespace
+
+bool StageContext::running() const
+{
+    return pipeline.running();
+}
+
+bool StageContext::sleepUntil(std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lock(pipeline.wait_mutex);
+    pipeline.wait_cv.wait_until(lock, deadline, [this] { return !pipeline.running(); });
+    return pipeline.running();
+}
+
+Pipeline::Pipeline(std::string name)
+    : name(std::move(name))
+{
+}
+
+Pipeline::~Pipeline()
+{
+    stop();
+}
+
+void Pipeline::addStage(std::string stage_name, StageOptions options, Body body)
+{
+    auto stage = std::make_unique<Stage>();
+    stage->name = std::move(stage_name);
+    stage->options = std::move(options);
+    stage->pacer.setSpin(stage->options.spin);
+    stage->body = std::move(body);
+    stages.push_back(std::move(stage));
+}
+
+void Pipeline::start()
+{
+    if (started) {
+        return;
+    }
+    started = true;
+    for (auto& stage : stages) {
+        stage->thread = std::thread([this, &stage = *stage] { run(stage); });
+    }
+}
+
+void Pipeline::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        if (stopping.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+    }
+    wait_cv.notify_all();
+    for (auto& stage : stages) {
+        if (stage->thread.joinable()) {
+            stage->thread.join();
+        }
+    }
+    if (started) {
+        for (const auto& stage : metrics()) {
+            LOG_INFO("{} {} 阶段: 共 {} 次，{:.1f} 次/秒，平均耗时 {:.2f} ms，抖动 {:.2f} ms，超时 {} 次",
+                     name, stage.name, stage.iterations, stage.rate, stage.busy_ms, stage.jitter_ms, stage.overruns);
+        }
+    }
+}
+
+void Pipeline::notify()
+{
+    // 空的加锁让等待方不会在检查条件和开始等待之间错过这次唤醒
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+    }
+    wait_cv.notify_all();
+}
+
+std::vector<StageMetrics> Pipeline::metrics() const
+{
+    std::vector<StageMetrics> result;
+    result.reserve(stages.size());
+    for (const auto& stage : stages) {
+        StageMetrics metrics;
+        metrics.name = stage->name;
+        metrics.iterations = stage->iterations.load(std::memory_order_relaxed);
+        metrics.rate = stage->rate.load(std::memory_order_relaxed);
+        metrics.busy_ms = stage->busy_ms.load(std::memory_order_relaxed);
+        metrics.overruns = stage->overruns.load(std::memory_order_relaxed);
+        metrics.jitter_ms = stage->jitter_ms.load(std::memory_order_relaxed);
+        result.push_back(std::move(metrics));
+    }
+    return result;
+}
+
+void Pipeline::run(Stage& stage)
+{
+    if (!stage.options.policy.empty()) {
+        ThreadPolicies::apply(stage.options.policy);
+    }
+    StageContext context(*this);
+    if (stage.options.start_delay.count() > 0 &&
+        !context.sleepUntil(std::chrono::steady_clock::now() + stage.options.start_delay)) {
+        return;
+    }
+
+    const auto sleep = [&context](std::chrono::steady_clock::time_point deadline) {
+        return context.sleepUntil(deadline);
+    };
+    std::chrono::steady_clock::time_point last_start;
+    double average_interval = 0.0;
+    while (running()) {
+        stage.pacer.setRate(stage.options.rate ? stage.options.rate() : 0.0);
+        if (!stage.pacer.wait(sleep)) {
+            break;
+        }
+        const auto& pacing = stage.pacer.stats();
+        stage.overruns.store(pacing.late, std::memory_order_relaxed);
+        stage.jitter_ms.store(pacing.jitter_ms, std::memory_order_relaxed);
+
+        const auto start = std::chrono::steady_clock::now();
+        if (last_start.time_since_epoch().count() != 0) {
+            context.last_interval = std::chrono::duration<double>(start - last_start).count();
+            // 平滑间隔再取倒数，补偿迟到的短间隔不会把频率估高
+            average_interval = average_interval == 0.0
+                ? context.last_interval
+                : average_interval + METRICS_SMOOTHING * (context.last_interval - average_interval);
+            if (average_interval > 0.0) {
+                stage.rate.store(1.0 / average_interval, std::memory_order_relaxed);
+            }
+        }
+        last_start = start;
+
+        try {
+            stage.body(context);
+        } catch (const std::exception& e) {
+            LOG_ERROR("{} {} 阶段异常: {}", name, stage.name, e.what());
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+        const double busy = std::chrono::duration<double, std::milli>(end - start).count();
+        const double busy_average = stage.busy_ms.load(std::memory_order_relaxed);
+        stage.busy_ms.store(stage.iterations.load(std::memory_order_relaxed) == 0
+                                ? busy
+                                : busy_average + METRICS_SMOOTHING * (busy - busy_average),
+                            std::memory_order_relaxed);
+        stage.iterations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace utils
@@ -0,0 +1,291 @@
+/*
+ * PaperTracker - 面部追踪应用程序
+ * Copyright (C) 2025 PAPER TRACKER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "thread_policy.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "logger.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+namespace {
+
+std::mutex config_mutex;
+ThreadPolicyConfig configured;
+
+const char* priorityName(ThreadPriority priority)
+{
+    switch (priority) {
+        case ThreadPriority::NORMAL: return "normal";
+        case ThreadPriority::ABOVE_NORMAL: return "above_normal";
+        case ThreadPriority::HIGH: return "high";
+        case ThreadPriority::REALTIME: return "realtime";
+        case ThreadPriority::INVALID: break;
+    }
+    return "unknown";
+}
+
+#ifdef _WIN32
+
+// Windows 上锁定内存的近似做法：把最小工作集设为硬限制，系统内存紧张时也不会换出这部分页面
+constexpr SIZE_T LOCKED_WORKING_SET = 256u * 1024u * 1024u;
+constexpr SIZE_T MAX_WORKING_SET = 1024u * 1024u * 1024u;
+
+bool setPriority(const std::string& role, ThreadPriority priority)
+{
+    int value = THREAD_PRIORITY_NORMAL;
+    switch (priority) {
+        case ThreadPriority::INVALID:
+        case ThreadPriority::NORMAL: value = THREAD_PRIORITY_NORMAL; break;
+        case ThreadPriority::ABOVE_NORMAL: value = THREAD_PRIORITY_ABOVE_NORMAL; break;
+        case ThreadPriority::HIGH: value = THREAD_PRIORITY_HIGHEST; break;
+        case ThreadPriority::REALTIME: value = THREAD_PRIORITY_TIME_CRITICAL; break;
+    }
+    if (!SetThreadPriority(GetCurrentThread(), value)) {
+        LOG_WARN("线程 {} 设置优先级 {} 失败，错误码: {}", role, priorityName(priority), GetLastError());
+        return false;
+    }
+    return true;
+}
+
+bool setAffinity(const std::string& role, const std::vector<int>& cpus)
+{
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+            mask |= DWORD_PTR(1) << cpu;
+        }
+    }
+    if (mask == 0) {
+        LOG_WARN("线程 {} 没有有效的 CPU 编号", role);
+        return false;
+    }
+    if (!SetThreadAffinityMask(GetCurrentThread(), mask)) {
+        LOG_WARN("线程 {} 设置 CPU 亲和性失败，错误码: {}", role, GetLastError());
+        return false;
+    }
+    return true;
+}
+
+bool lockMemory()
+{
+    if (!SetProcessWorkingSetSizeEx(GetCurrentProcess(), LOCKED_WORKING_SET, MAX_WORKING_SET,
+                                    QUOTA_LIMITS_HARDWS_MIN_ENABLE | QUOTA_LIMITS_HARDWS_MAX_DISABLE)) {
+        LOG_WARN("锁定进程内存失败，错误码: {}", GetLastError());
+        return false;
+    }
+    return true;
+}
+
+#elif defined(__linux__)
+
+// SCHED_FIFO 的优先级取较低的值，仍高于所有普通线程，但不会压过内核的中断线程
+constexpr int REALTIME_PRIORITY = 10;
+
+bool setNice(const std::string& role, int nice)
+{
+    // Linux 上 setpriority 作用于单个线程
+    const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, tid, nice) != 0) {
+        LOG_WARN("线程 {} 设置 nice {} 失败: {}", role, nice, std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool setPriority(const std::string& role, ThreadPriority priority)
+{
+    switch (priority) {
+        case ThreadPriority::INVALID:
+        case ThreadPriority::NORMAL:
+            return setNice(role, 0);
+        case ThreadPriority::ABOVE_NORMAL:
+            return setNice(role, -5);
+        case ThreadPriority::HIGH:
+            return setNice(role, -10);
+        case ThreadPriority::REALTIME: {
+            sched_param param{};
+            param.sched_priority = REALTIME_PRIORITY;
+            const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (result == 0) {
+                return true;
+            }
+            LOG_WARN("线程 {} 设置 SCHED_FIFO 失败: {}，改用 nice -10", role, std::strerror(result));
+            return setNice(role, -10);
+        }
+    }
+    return false;
+}
+
+bool setAffinity(const std::string& role, const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0) {
+        LOG_WARN("线程 {} 设置 CPU 亲和性失败: {}", role, std::strerror(result));
+        return false;
+    }
+    return true;
+}
+
+bool lockMemory()
+{
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        LOG_WARN("锁定进程内存失败: {}", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool setPriority(const std::string& role, ThreadPriority)
+{
+    LOG_WARN("当前平台不支持设置线程 {} 的优先级", role);
+    return false;
+}
+
+bool setAffinity(const std::string& role, const std::vector<int>&)
+{
+    LOG_WARN("当前平台不支持设置线程 {} 的 CPU 亲和性", role);
+    return false;
+}
+
+bool lockMemory()
+{
+    LOG_WARN("当前平台不支持锁定进程内存");
+    return false;
+}
+
+#endif
+
+void logLatency(const std::string& role, const char* stage, const SchedulingLatency& latency)
+{
+    LOG_INFO("线程 {} {}的调度延迟: 平均 {:.0f} us，抖动 {:.0f} us，P99 {:.0f} us，最大 {:.0f} us",
+             role, stage, latency.mean_us, latency.jitter_us, latency.p99_us, latency.max_us);
+}
+
+} // namespace
+
+void ThreadPolicies::configure(const ThreadPolicyConfig& config)
+{
+    ThreadPolicyConfig checked = config;
+    for (auto& [role, policy] : checked.threads) {
+        if (policy.priority == ThreadPriority::INVALID) {
+            LOG_WARN("线程 {} 的优先级无法识别，应为 normal、above_normal、high 或 realtime，按 normal 处理", role);
+            policy.priority = ThreadPriority::NORMAL;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        configured = checked;
+    }
+    if (checked.lock_memory && lockMemory()) {
+        LOG_INFO("已锁定进程内存");
+    }
+}
+
+ThreadPolicyConfig ThreadPolicies::config()
+{
+    std::lock_guard<std::mutex> lock(config_mutex);
+    return configured;
+}
+
+void ThreadPolicies::apply(const std::string& role)
+{
+    ThreadPolicy policy;
+    bool measure = false;
+    {
+        std::lock_guard<std::mutex> lock(config_mutex);
+        const auto it = configured.threads.find(role);
+        if (it == configured.threads.end()) {
+            return;
+        }
+        policy = it->second;
+        measure = configured.measure_latency;
+    }
+    const ThreadPriority priority = policy.priority;
+    if (priority == ThreadPriority::NORMAL && policy.cpus.empty()) {
+        return;
+    }
+
+    if (measure) {
+        logLatency(role, "设置前", measureLatency());
+    }
+    bool applied = true;
+    if (priority != ThreadPriority::NORMAL) {
+        applied = setPriority(role, priority) && applied;
+    }
+    if (!policy.cpus.empty()) {
+        applied = setAffinity(role, policy.cpus) && applied;
+    }
+    if (applied) {
+        LOG_INFO("线程 {} 已设置优先级 {}，CPU 亲和性 {} 个核心", role, priorityName(priority), policy.cpus.size());
+    }
+    if (measure) {
+        logLatency(role, "设置后", measureLatency());
+    }
+}
+
+SchedulingLatency ThreadPolicies::measureLatency(int samples, std::chrono::microseconds interval)
+{
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> delays;
+    delays.reserve(static_cast<std::size_t>(std::max<int>(samples, 1)));
+    for (int i = 0; i < samples; ++i) {
+        const auto expected = Clock::now() + interval;
+        std::this_thread::sleep_until(expected);
+        delays.push_back(std::max<double>(0.0, std::chrono::duration<double, std::micro>(Clock::now() - expected).count()));
+    }
+
+    SchedulingLatency latency;
+    if (delays.empty()) {
+        return latency;
+    }
+    double sum = 0.0;
+    for (double delay : delays) {
+        sum += delay;
+    }
+    latency.mean_us = sum / static_cast<double>(delays.size());
+    double variance = 0.0;
+    for (double delay : delays) {
+        variance += (delay - latency.mean_us) * (delay - latency.mean_us);
+    }
+    latency.jitter_us = std::sqrt(variance / static_cast<double>(delays.size()));
+    std::sort(delays.begin(), delays.end());
+    latency.p99_us = delays[std::min<std::size_t>(delays.size() - 1, delays.size() * 99 / 100)];
+    latency.max_us = delays.back();
+    return latency;
+}
+
+} // namespace utils